@@ -0,0 +1,140 @@
+#include "Allocations.h"
+#include <cstdlib>
+#include <algorithm>
+#include <new>
+#include <stdio.h>
+
+namespace object
+{
+    namespace
+    {
+        /// counters of one slot, plain atomics so operator new never has to construct anything
+        struct SlotCounters
+        {
+            std::atomic<uint64_t> m_allocations{0};
+            std::atomic<uint64_t> m_bytes{0};
+            std::atomic<uint64_t> m_commands{0};
+        };
+
+        SlotCounters s_slots[AllocationTracker::SLOTS];
+        bool s_isExitHookSet = false;
+
+        const char* _slotName(const unsigned _slot)
+        {
+            static const char* const names[AllocationTracker::SLOTS] =
+                { "MOVE", "LEFT", "RIGHT", "PLACE", "REPORT", "UNDO", "REDO", "DEFINE", "CALL", "UNRESOLVED", "OUTSIDE" };
+            return _slot < AllocationTracker::SLOTS ? names[_slot] : "?";
+        }
+    }
+
+    void AllocationTracker::enableFromEnvironment()
+    {
+        const char* value = getenv("TOYROBOT_ALLOCATIONS");
+        if(value == nullptr || value[0] == '\0' || value[0] == '0')
+            return;
+        if(!s_isExitHookSet)
+        {
+            s_isExitHookSet = true;
+            std::atexit([](){ disable(); print(); });
+        }
+        enable();
+    }
+
+    void AllocationTracker::reset()
+    {
+        for(SlotCounters& slot : s_slots)
+        {
+            slot.m_allocations.store(0, std::memory_order_relaxed);
+            slot.m_bytes.store(0, std::memory_order_relaxed);
+            slot.m_commands.store(0, std::memory_order_relaxed);
+        }
+        t_state.m_total = 0;
+    }
+
+    AllocationTracker::Counts AllocationTracker::get(const unsigned _slot)
+    {
+        Counts counts;
+        if(_slot >= SLOTS)
+            return counts;
+        counts.m_allocations = s_slots[_slot].m_allocations.load(std::memory_order_relaxed);
+        counts.m_bytes = s_slots[_slot].m_bytes.load(std::memory_order_relaxed);
+        counts.m_commands = s_slots[_slot].m_commands.load(std::memory_order_relaxed);
+        return counts;
+    }
+
+    void AllocationTracker::print()
+    {
+        printf("ALLOCATIONS:\n%-12s %14s %14s %14s %12s\n", "action", "commands", "allocations", "bytes", "per command");
+        for(unsigned slot = 0; slot < SLOTS; ++slot)
+        {
+            const Counts counts = get(slot);
+            if(counts.m_allocations == 0 && counts.m_commands == 0)
+                continue;
+            const double perCommand = counts.m_commands ? double(counts.m_allocations) / double(counts.m_commands) : 0.0;
+            printf("%-12s %14lu %14lu %14lu %12.2f\n", _slotName(slot), (unsigned long)counts.m_commands,
+                (unsigned long)counts.m_allocations, (unsigned long)counts.m_bytes, perCommand);
+        }
+    }
+
+    void AllocationTracker::onAllocation(const size_t _bytes)
+    {
+        ThreadState& state = t_state;
+        ++state.m_total;
+        if(state.m_isInScope)
+        {
+            ++state.m_allocations;
+            state.m_bytes += _bytes;
+            return;
+        }
+        s_slots[OUTSIDE].m_allocations.fetch_add(1, std::memory_order_relaxed);
+        s_slots[OUTSIDE].m_bytes.fetch_add(_bytes, std::memory_order_relaxed);
+    }
+
+    void AllocationTracker::onCommand(const unsigned _slot, const uint64_t _allocations, const uint64_t _bytes)
+    {
+        SlotCounters& slot = s_slots[_slot < SLOTS ? _slot : UNRESOLVED];
+        slot.m_commands.fetch_add(1, std::memory_order_relaxed);
+        if(_allocations == 0)
+            return;
+        slot.m_allocations.fetch_add(_allocations, std::memory_order_relaxed);
+        slot.m_bytes.fetch_add(_bytes, std::memory_order_relaxed);
+    }
+}
+
+namespace
+{
+    void* _allocate(const size_t _bytes)
+    {
+        if(object::AllocationTracker::isEnabled())
+            object::AllocationTracker::onAllocation(_bytes);
+        void* memory = malloc(_bytes == 0 ? 1 : _bytes);
+        if(memory == nullptr)
+            throw std::bad_alloc();
+        return memory;
+    }
+
+    void* _allocateAligned(const size_t _bytes, const std::align_val_t _alignment)
+    {
+        if(object::AllocationTracker::isEnabled())
+            object::AllocationTracker::onAllocation(_bytes);
+        const size_t alignment = std::max(size_t(_alignment), sizeof(void*));
+        void* memory = nullptr;
+        if(posix_memalign(&memory, alignment, _bytes == 0 ? 1 : _bytes) != 0)
+            throw std::bad_alloc();
+        return memory;
+    }
+}
+
+// replaced global allocation functions, the nothrow and array forms forward to these
+void* operator new(size_t _bytes) { return _allocate(_bytes); }
+void* operator new[](size_t _bytes) { return _allocate(_bytes); }
+void* operator new(size_t _bytes, std::align_val_t _alignment) { return _allocateAligned(_bytes, _alignment); }
+void* operator new[](size_t _bytes, std::align_val_t _alignment) { return _allocateAligned(_bytes, _alignment); }
+void operator delete(void* _memory) noexcept { free(_memory); }
+void operator delete[](void* _memory) noexcept { free(_memory); }
+void operator delete(void* _memory, size_t) noexcept { free(_memory); }
+void operator delete[](void* _memory, size_t) noexcept { free(_memory); }
+void operator delete(void* _memory, std::align_val_t) noexcept { free(_memory); }
+void operator delete[](void* _memory, std::align_val_t) noexcept { free(_memory); }
+void operator delete(void* _memory, size_t, std::align_val_t) noexcept { free(_memory); }
+void operator delete[](void* _memory, size_t, std::align_val_t) noexcept { free(_memory); }
@@ -0,0 +1,146 @@
+#ifndef ALLOCATIONS_H
+#define ALLOCATIONS_H
+
+#include "Types.h"
+#include <atomic>
+#include <stdint.h>
+
+namespace object
+{
+
+    /**
+     * Opt-in heap allocation accounting
+     * @brief   the global operator new is replaced in Allocations.cpp and, while tracking is on, counts every
+     *          allocation and its size. allocations made inside an AllocationScope are attributed to the ACTION
+     *          of the command being processed, everything else is counted as outside any command.
+     *          frees are not tracked. when tracking is off operator new costs one relaxed atomic load
+    */
+    class AllocationTracker
+    {
+    public:
+        /// allocations of one action
+        struct Counts
+        {
+            uint64_t m_allocations = 0;
+            uint64_t m_bytes = 0;
+            /// commands processed with this action
+            uint64_t m_commands = 0;
+        };
+
+        /// slots for every ACTION, commands that were never resolved to an action, and work outside commands
+        static constexpr unsigned ACTION_SLOTS = 9;
+        static constexpr unsigned UNRESOLVED = ACTION_SLOTS;
+        static constexpr unsigned OUTSIDE = ACTION_SLOTS + 1;
+        static constexpr unsigned SLOTS = ACTION_SLOTS + 2;
+
+        /// command being counted on a thread
+        struct ThreadState
+        {
+            bool m_isInScope;
+            unsigned m_slot;
+            uint64_t m_allocations;
+            uint64_t m_bytes;
+            /// every allocation of the thread while tracking is on
+            uint64_t m_total;
+        };
+
+        /// set while counting, checked by operator new
+        static inline std::atomic<bool> s_isEnabled{false};
+        /// plain data so operator new can use it at any point of a thread's life
+        static inline thread_local ThreadState t_state{ false, UNRESOLVED, 0, 0, 0 };
+
+        /**
+         * @brief start counting, counts are not reset
+        */
+        static void enable() { s_isEnabled.store(true, std::memory_order_release); };
+        static void disable() { s_isEnabled.store(false, std::memory_order_release); };
+        static bool isEnabled() { return s_isEnabled.load(std::memory_order_relaxed); };
+
+        /**
+         * @brief start from TOYROBOT_ALLOCATIONS, when set counts are printed at exit
+        */
+        static void enableFromEnvironment();
+
+        /**
+         * @brief zero every counter
+        */
+        static void reset();
+
+        /**
+         * @brief counts of a slot
+         * @param _slot an ACTION value, UNRESOLVED or OUTSIDE
+        */
+        static Counts get(const unsigned _slot);
+        static Counts get(const type::ACTION _action) { return get(unsigned(_action)); };
+
+        /**
+         * @brief print counts per action
+        */
+        static void print();
+
+        /**
+         * @brief allocations made by the calling thread while tracking is on, including those attributed to actions
+        */
+        static uint64_t threadAllocations() { return t_state.m_total; };
+
+        /**
+         * @brief count an allocation, called by operator new
+        */
+        static void onAllocation(const size_t _bytes);
+
+        /**
+         * @brief add the counts of a finished command to its action
+        */
+        static void onCommand(const unsigned _slot, const uint64_t _allocations, const uint64_t _bytes);
+    };
+
+    /**
+     * Attributes the allocations of one command
+     * @brief   open one at the start of a command and call setAction() once the action is known, allocations
+     *          made before that, like splitting the input, are still attributed to it. nested scopes defer
+     *          to the outermost one on the thread
+    */
+    class AllocationScope
+    {
+        bool m_isOwner = false;
+
+    public:
+        AllocationScope()
+        {
+            AllocationTracker::ThreadState& state = AllocationTracker::t_state;
+            if(!AllocationTracker::isEnabled() || state.m_isInScope)
+                return;
+            m_isOwner = true;
+            state.m_isInScope = true;
+            state.m_slot = AllocationTracker::UNRESOLVED;
+            state.m_allocations = 0;
+            state.m_bytes = 0;
+        }
+        explicit AllocationScope(const type::ACTION _action)
+            :   AllocationScope()
+        {
+            setAction(_action);
+        }
+        AllocationScope(const AllocationScope&) = delete;
+        void operator=(const AllocationScope&) = delete;
+        ~AllocationScope()
+        {
+            if(!m_isOwner)
+                return;
+            AllocationTracker::ThreadState& state = AllocationTracker::t_state;
+            state.m_isInScope = false;
+            AllocationTracker::onCommand(state.m_slot, state.m_allocations, state.m_bytes);
+        }
+
+        /**
+         * @brief set the action the allocations of this command are attributed to
+        */
+        void setAction(const type::ACTION _action)
+        {
+            if(m_isOwner)
+                AllocationTracker::t_state.m_slot = unsigned(_action);
+        }
+    };
+}
+
+#endif  // ALLOCATIONS_H
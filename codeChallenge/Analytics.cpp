@@ -0,0 +1,48 @@
+#include "Analytics.h"
+#include <fstream>
+
+namespace object
+{
+    bool Heatmap::merge(const Heatmap& _other)
+    {
+        if(_other.m_width != m_width || _other.m_height != m_height)
+            return false;
+        for(size_t i = 0; i < m_visits.size(); ++i)
+            m_visits[i] += _other.m_visits[i];
+        for(size_t i = 0; i < m_dwell.size(); ++i)
+            m_dwell[i] += _other.m_dwell[i];
+        return true;
+    }
+
+    bool Heatmap::writeCsv(const std::string& _path) const
+    {
+        std::ofstream file(_path);
+        if(!file.is_open())
+            return false;
+        file << "x,y,visits,north,east,south,west\n";
+        for(uint32_t y = 0; y < m_height; ++y)
+        {
+            for(uint32_t x = 0; x < m_width; ++x)
+            {
+                const size_t cell = size_t(y) * m_width + x;
+                file << x << ',' << y << ',' << m_visits[cell];
+                for(size_t heading = 0; heading < 4; ++heading)
+                    file << ',' << m_dwell[(cell << 2) | heading];
+                file << '\n';
+            }
+        }
+        return file.good();
+    }
+
+    bool Heatmap::writeBinary(const std::string& _path) const
+    {
+        std::ofstream file(_path, std::ios::binary);
+        if(!file.is_open())
+            return false;
+        file.write(reinterpret_cast<const char*>(&m_width), sizeof(m_width));
+        file.write(reinterpret_cast<const char*>(&m_height), sizeof(m_height));
+        file.write(reinterpret_cast<const char*>(m_visits.data()), std::streamsize(m_visits.size() * sizeof(uint64_t)));
+        file.write(reinterpret_cast<const char*>(m_dwell.data()), std::streamsize(m_dwell.size() * sizeof(uint64_t)));
+        return file.good();
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef ANALYTICS_H
+#define ANALYTICS_H
+
+#include "Objects.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace object
+{
+
+    /**
+     * Per cell visit and per heading dwell counters
+     * @brief   visits count every accepted MOVE or PLACE that lands on a cell.
+     *          dwell counts every accepted command by the cell and heading the robot ends up in.
+     *          a heatmap is not thread safe, each replay thread owns one and they are merged at the end
+    */
+    class Heatmap : public TransformListener
+    {
+        /// cells on each axis
+        const uint32_t m_width;
+        const uint32_t m_height;
+        /// visits per cell, row major
+        std::vector<uint64_t> m_visits;
+        /// dwell per cell and heading, 4 counters per cell in HEADING order
+        std::vector<uint64_t> m_dwell;
+
+    public:
+        /**
+         * @param _extentX largest x axis value, inclusive like TABLE_TOP_X
+         * @param _extentY largest y axis value, inclusive like TABLE_TOP_Y
+        */
+        Heatmap(const uint32_t _extentX, const uint32_t _extentY)
+            :   m_width(_extentX + 1),
+                m_height(_extentY + 1),
+                m_visits(size_t(m_width) * m_height, 0),
+                m_dwell(size_t(m_width) * m_height * 4, 0)
+        {};
+
+        /**
+         * @brief count a processed command
+        */
+        virtual void onAction(const type::ACTION _action, const bool _accepted, const type::T_Transform<uint8_t>& _transform,
+            const bool _isPlaced) override
+        {
+            if(!_accepted || !_isPlaced)
+                return;
+            const auto position = _transform.getPosition();
+            if(position.x >= m_width || position.y >= m_height)
+                return;
+            const size_t cell = size_t(position.y) * m_width + position.x;
+            if(_action == type::ACTION::MOVE || _action == type::ACTION::PLACE)
+                ++m_visits[cell];
+            ++m_dwell[(cell << 2) | (_transform.getRotation() & 0b11)];
+        }
+
+        /**
+         * @brief add the counters of another heatmap of the same size
+         * @param _other heatmap to fold into this one
+         * @return false if the sizes differ
+        */
+        bool merge(const Heatmap& _other);
+
+        /**
+         * @brief accessors for counters
+        */
+        uint64_t getVisits(const uint32_t _x, const uint32_t _y) const { return m_visits[size_t(_y) * m_width + _x]; };
+        uint64_t getDwell(const uint32_t _x, const uint32_t _y, const type::HEADING _heading) const
+        {
+            return m_dwell[((size_t(_y) * m_width + _x) << 2) | (_heading & 0b11)];
+        };
+
+        /**
+         * @brief write counters as csv, one "x,y,visits,north,east,south,west" row per cell
+         * @param _path file to write
+         * @return false if the file could not be written
+        */
+        bool writeCsv(const std::string& _path) const;
+
+        /**
+         * @brief write counters as a binary matrix
+         * @brief layout: uint32 width, uint32 height, width*height uint64 visits, width*height*4 uint64 dwell
+         * @param _path file to write
+         * @return false if the file could not be written
+        */
+        bool writeBinary(const std::string& _path) const;
+    };
+}
+
+#endif  // ANALYTICS_H
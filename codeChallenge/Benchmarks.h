@@ -0,0 +1,1080 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include "Objects.h"
+#include "SpatialIndex.h"
+#include "Analytics.h"
+#include "Evaluator.h"
+#include "Tokenizer.h"
+#include "StaticRobot.h"
+#include "Script.h"
+#include "TickEngine.h"
+#include "Trace.h"
+#include "RobotPool.h"
+#include "Trajectory.h"
+#include "Shard.h"
+#include "ResultCache.h"
+#include "Router.h"
+#include "Engine.h"
+#include "EditableScript.h"
+#include "Geofence.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifndef DATA_SET_DIR
+#define DATA_SET_DIR "."
+#endif
+
+
+/**
+ * @brief times a predefined benchmark and reports the cost per operation
+ * @param _bench lambda benchmark of [&]()->void{}
+ * @param _ops amount of operations the benchmark performs
+*/
+#define CREATE_BENCHMARK(_bench, _ops) {\
+    printf("\n%s - BEGINING BENCHMARK..",#_bench);\
+    const auto start(std::chrono::steady_clock::now());\
+    _bench();\
+    const auto end(std::chrono::steady_clock::now());\
+    const double duration_ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>( end - start ).count());\
+    printf("\nDURATION: : %.3f ms , %.2f ns/op over %lu ops", duration_ns / 1e6, duration_ns / double(_ops), (unsigned long)(_ops));\
+    printf("\n%s - FINISHED\n",#_bench);\
+}
+
+
+class Benchmarks
+{
+private:
+    /// results are folded into this so the compiler keeps the measured work
+    volatile uint64_t m_sink = 0;
+
+    /**
+     * @brief build a random command script for a 5x5 table
+     * @param _count amount of commands
+     * @param _seed random seed
+     * @return one command string per entry
+    */
+    static std::vector<std::string> _buildScript(const uint32_t _count, const uint32_t _seed)
+    {
+        static const char* const headings[] = { "NORTH", "EAST", "SOUTH", "WEST" };
+        std::mt19937 random(_seed);
+        std::vector<std::string> script;
+        script.reserve(_count);
+        for(uint32_t i = 0; i < _count; ++i)
+        {
+            const uint32_t roll = random() % 100;
+            if(i == 0 || roll < 5)
+                script.push_back("PLACE " + std::to_string(random() % (TABLE_TOP_X + 1)) + ","
+                    + std::to_string(random() % (TABLE_TOP_Y + 1)) + "," + headings[random() % 4]);
+            else if(roll < 60)
+                script.push_back("MOVE");
+            else if(roll < 75)
+                script.push_back("LEFT");
+            else if(roll < 90)
+                script.push_back("RIGHT");
+            else
+                script.push_back("REPORT");
+        }
+        return script;
+    }
+
+    /**
+     * @brief the repo's data set files, testData.txt and everything under dataSets
+    */
+    static std::vector<std::filesystem::path> _dataSetFiles()
+    {
+        const std::filesystem::path root(DATA_SET_DIR);
+        std::vector<std::filesystem::path> files;
+        std::error_code error;
+        if(std::filesystem::is_regular_file(root / "testData.txt", error))
+            files.push_back(root / "testData.txt");
+        for(const auto& entry : std::filesystem::directory_iterator(root / "dataSets", error))
+            if(entry.is_regular_file())
+                files.push_back(entry.path());
+        std::sort(files.begin() + std::min<size_t>(files.size(), 1), files.end());
+        return files;
+    }
+
+public:
+
+    Benchmarks(){}
+
+    /**
+     * @brief run all benchmarks
+    */
+    void runBenchmarks()
+    {
+        /**
+         * BENCHMARK: sparse obstacle lookups against a dense bitmap on a 32767x32767 table
+        */
+        {
+            const uint32_t EXTENT = 32767;
+            const uint32_t OBSTACLES = 100000;
+            const uint32_t LOOKUPS = 10000000;
+            std::mt19937 random(26);
+            std::uniform_int_distribution<uint32_t> axis(0, EXTENT - 1);
+
+            object::ObstacleMap sparse;
+            object::DenseObstacleMap dense(EXTENT, EXTENT);
+            std::vector<std::pair<uint32_t, uint32_t>> cells;
+            for(uint32_t i = 0; i < OBSTACLES; ++i)
+            {
+                cells.emplace_back(axis(random), axis(random));
+                dense.addObstacle(cells.back().first, cells.back().second);
+            }
+            // a clustered block so some tiles become bitmaps
+            for(uint32_t y = 0; y < 256; ++y)
+                for(uint32_t x = 0; x < 256; ++x)
+                {
+                    cells.emplace_back(1000 + x, 1000 + y);
+                    dense.addObstacle(1000 + x, 1000 + y);
+                }
+            sparse.addObstacles(cells);
+            printf("\nBENCHMARK: obstacles %lu, tiles %lu (dense %lu), sparse %lu KB, dense %lu KB",
+                (unsigned long)sparse.size(), (unsigned long)sparse.tileCount(), (unsigned long)sparse.denseTileCount(),
+                (unsigned long)(sparse.memoryUsage() / 1024), (unsigned long)(dense.memoryUsage() / 1024));
+
+            std::vector<std::pair<uint32_t, uint32_t>> queries;
+            queries.reserve(1 << 16);
+            for(uint32_t i = 0; i < (1 << 16); ++i)
+                queries.emplace_back(axis(random), axis(random));
+
+            auto bench_obstacles_sparse_lookup = [&](){
+                uint64_t hits = 0;
+                for(uint32_t i = 0; i < LOOKUPS; ++i)
+                {
+                    const auto& cell = queries[i & 0xFFFF];
+                    hits += sparse.isBlocked(cell.first, cell.second);
+                }
+                m_sink = m_sink + hits;
+            };
+            CREATE_BENCHMARK(bench_obstacles_sparse_lookup, LOOKUPS)
+
+            auto bench_obstacles_dense_lookup = [&](){
+                uint64_t hits = 0;
+                for(uint32_t i = 0; i < LOOKUPS; ++i)
+                {
+                    const auto& cell = queries[i & 0xFFFF];
+                    hits += dense.isBlocked(cell.first, cell.second);
+                }
+                m_sink = m_sink + hits;
+            };
+            CREATE_BENCHMARK(bench_obstacles_dense_lookup, LOOKUPS)
+        }
+
+        /**
+         * BENCHMARK: spatial index updates and queries against a linear scan at 1M and 10M robots
+        */
+        for(const uint32_t ROBOTS : { 1000000u, 10000000u })
+        {
+            const uint32_t EXTENT = 32767;
+            const uint32_t MOVES = 10000000;
+            const uint32_t INDEX_QUERIES = 1000;
+            const uint32_t SCAN_QUERIES = 10;
+            printf("\nBENCHMARK: spatial index with %u robots", ROBOTS);
+            std::mt19937 random(27);
+            std::uniform_int_distribution<uint32_t> axis(0, EXTENT);
+            std::uniform_int_distribution<uint32_t> pick(0, ROBOTS - 1);
+
+            object::Fleet fleet(EXTENT, EXTENT);
+            fleet.reserve(ROBOTS);
+            for(uint32_t i = 0; i < ROBOTS; ++i)
+                fleet.placeHere(fleet.addRobot(), axis(random), axis(random), type::HEADING(i & 0b11));
+            object::SpatialIndex index(EXTENT, EXTENT, 64);
+
+            auto bench_spatial_index_build = [&](){
+                fleet.setSpatialIndex(&index);
+            };
+            CREATE_BENCHMARK(bench_spatial_index_build, ROBOTS)
+
+            std::vector<uint32_t> movers(1 << 16);
+            for(auto& robot : movers)
+                robot = pick(random);
+            auto bench_spatial_index_move = [&](){
+                uint64_t moved = 0;
+                for(uint32_t i = 0; i < MOVES; ++i)
+                    moved += fleet.move(movers[i & 0xFFFF]);
+                m_sink = m_sink + moved;
+            };
+            CREATE_BENCHMARK(bench_spatial_index_move, MOVES)
+
+            // 256x256 cell query windows
+            std::vector<std::pair<uint32_t, uint32_t>> corners(INDEX_QUERIES);
+            for(auto& corner : corners)
+                corner = std::make_pair(axis(random) % (EXTENT - 256), axis(random) % (EXTENT - 256));
+            std::vector<uint32_t> found;
+            auto bench_spatial_index_rect = [&](){
+                for(const auto& corner : corners)
+                {
+                    found.clear();
+                    index.queryRect(corner.first, corner.second, corner.first + 255, corner.second + 255, found);
+                    m_sink = m_sink + found.size();
+                }
+            };
+            CREATE_BENCHMARK(bench_spatial_index_rect, INDEX_QUERIES)
+
+            auto bench_linear_scan_rect = [&](){
+                for(uint32_t q = 0; q < SCAN_QUERIES; ++q)
+                {
+                    found.clear();
+                    const auto& corner = corners[q];
+                    for(uint32_t robot = 0; robot < fleet.size(); ++robot)
+                    {
+                        const auto position = fleet.getPosition(robot);
+                        if(position.x >= corner.first && position.x <= corner.first + 255
+                            && position.y >= corner.second && position.y <= corner.second + 255)
+                            found.push_back(robot);
+                    }
+                    m_sink = m_sink + found.size();
+                }
+            };
+            CREATE_BENCHMARK(bench_linear_scan_rect, SCAN_QUERIES)
+
+            auto bench_spatial_index_nearest_8 = [&](){
+                for(const auto& corner : corners)
+                {
+                    found.clear();
+                    index.nearest(corner.first, corner.second, 8, found);
+                    m_sink = m_sink + found.size();
+                }
+            };
+            CREATE_BENCHMARK(bench_spatial_index_nearest_8, INDEX_QUERIES)
+        }
+
+        /**
+         * BENCHMARK: replay with heatmap analytics against a plain replay, budget is 10% overhead
+        */
+        {
+            const uint32_t COMMANDS = 10000000;
+            const std::vector<std::string> script = _buildScript(COMMANDS, 28);
+            double plainNs = 0;
+            double analyticsNs = 0;
+
+            auto bench_replay_plain = [&](){
+                object::ToyRobot robot;
+                robot.setReportCallback([](const std::string&){});
+                const auto start(std::chrono::steady_clock::now());
+                for(const auto& command : script)
+                    robot.proccessInput(command);
+                plainNs = double(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+            };
+            CREATE_BENCHMARK(bench_replay_plain, COMMANDS)
+
+            auto bench_replay_heatmap = [&](){
+                object::ToyRobot robot;
+                object::Heatmap heatmap(TABLE_TOP_X, TABLE_TOP_Y);
+                robot.setReportCallback([](const std::string&){});
+                robot.addListener(&heatmap);
+                const auto start(std::chrono::steady_clock::now());
+                for(const auto& command : script)
+                    robot.proccessInput(command);
+                analyticsNs = double(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+                m_sink = m_sink + heatmap.getVisits(0, 0);
+            };
+            CREATE_BENCHMARK(bench_replay_heatmap, COMMANDS)
+            const double overhead = plainNs > 0 ? (analyticsNs - plainNs) * 100.0 / plainNs : 0.0;
+            printf("\nBENCHMARK: heatmap overhead %.1f%% (budget 10%%) - %s\n", overhead, overhead <= 10.0 ? "WITHIN BUDGET" : "OVER BUDGET");
+        }
+
+        /**
+         * BENCHMARK: forking by snapshot against rebuilding a robot and replaying its history
+        */
+        {
+            const uint32_t HISTORY = 1000;
+            const uint32_t FORKS = 10000;
+            const uint32_t CANDIDATES = 1000;
+            const std::vector<std::string> history = _buildScript(HISTORY, 29);
+            object::ToyRobot origin;
+            origin.setReportCallback([](const std::string&){});
+            for(const auto& command : history)
+                origin.proccessInput(command);
+
+            auto bench_fork_rebuild_replay = [&](){
+                for(uint32_t i = 0; i < FORKS / 100; ++i)
+                {
+                    object::ToyRobot robot;
+                    robot.setReportCallback([](const std::string&){});
+                    for(const auto& command : history)
+                        robot.proccessInput(command);
+                    m_sink = m_sink + robot.getPosition().x;
+                }
+            };
+            CREATE_BENCHMARK(bench_fork_rebuild_replay, FORKS / 100)
+
+            object::ToyRobot worker;
+            auto bench_fork_snapshot = [&](){
+                for(uint32_t i = 0; i < FORKS; ++i)
+                {
+                    worker.restore(origin.snapshot());
+                    m_sink = m_sink + worker.getPosition().x;
+                }
+            };
+            CREATE_BENCHMARK(bench_fork_snapshot, FORKS)
+
+            std::vector<std::vector<std::string>> candidates;
+            for(uint32_t i = 0; i < CANDIDATES; ++i)
+                candidates.push_back(_buildScript(100, 1000 + i));
+            object::ParallelEvaluator evaluator;
+            evaluator.evaluate(origin, candidates);
+            auto bench_parallel_evaluator = [&](){
+                m_sink = m_sink + evaluator.evaluate(origin, candidates).size();
+            };
+            CREATE_BENCHMARK(bench_parallel_evaluator, CANDIDATES)
+        }
+
+        /**
+         * BENCHMARK: delimiter scanning with getline against the scalar and vector tokenizers
+        */
+        {
+            const uint32_t COMMANDS = 10000000;
+            std::string text;
+            for(const auto& command : _buildScript(COMMANDS, 32))
+                text.append(command).push_back('|');
+            printf("\nBENCHMARK: tokenizing %lu MB", (unsigned long)(text.size() >> 20));
+            std::vector<std::string_view> commands;
+            commands.reserve(COMMANDS + 1);
+
+            auto bench_tokenize_getline = [&](){
+                std::istringstream stream(text);
+                std::string data;
+                uint64_t count = 0;
+                while(std::getline(stream, data, '|'))
+                    ++count;
+                m_sink = m_sink + count;
+            };
+            CREATE_BENCHMARK(bench_tokenize_getline, COMMANDS)
+
+            auto bench_tokenize_scalar = [&](){
+                commands.clear();
+                object::Tokenizer::split(text, commands, object::Tokenizer::ISA::SCALAR);
+                m_sink = m_sink + commands.size();
+            };
+            CREATE_BENCHMARK(bench_tokenize_scalar, COMMANDS)
+
+            auto bench_tokenize_sse2 = [&](){
+                commands.clear();
+                object::Tokenizer::split(text, commands, object::Tokenizer::ISA::SSE2);
+                m_sink = m_sink + commands.size();
+            };
+            CREATE_BENCHMARK(bench_tokenize_sse2, COMMANDS)
+
+            auto bench_tokenize_avx2 = [&](){
+                commands.clear();
+                object::Tokenizer::split(text, commands, object::Tokenizer::ISA::AVX2);
+                m_sink = m_sink + commands.size();
+            };
+            CREATE_BENCHMARK(bench_tokenize_avx2, COMMANDS)
+        }
+
+        /**
+         * BENCHMARK: pre-parsed commands on the runtime robot against the compile time specialised robot
+        */
+        {
+            const uint32_t COMMANDS = 10000000;
+            std::vector<type::Command> commands;
+            commands.reserve(COMMANDS);
+            for(const auto& text : _buildScript(COMMANDS, 34))
+            {
+                type::Command command;
+                object::InputHandler::parseCommand(text, command);
+                commands.push_back(command);
+            }
+            uint64_t reports = 0;
+            auto countReport = [&](const std::string& _report){ reports += _report.size(); };
+
+            object::ToyRobot runtimeRobot;
+            runtimeRobot.setHistoryCapacity(0);
+            runtimeRobot.setReportCallback(countReport);
+            auto bench_runtime_robot = [&](){
+                uint64_t accepted = 0;
+                for(const type::Command& command : commands)
+                    accepted += runtimeRobot.execute(command);
+                m_sink = m_sink + accepted + reports;
+            };
+            CREATE_BENCHMARK(bench_runtime_robot, COMMANDS)
+
+            object::StaticRobot<TABLE_TOP_X, TABLE_TOP_Y> staticRobot;
+            staticRobot.setReportCallback(countReport);
+            auto bench_static_robot = [&](){
+                uint64_t accepted = 0;
+                for(const type::Command& command : commands)
+                    accepted += staticRobot.execute(command);
+                m_sink = m_sink + accepted + reports;
+            };
+            CREATE_BENCHMARK(bench_static_robot, COMMANDS)
+
+            // same script on a 1000x1000 table, picks a uint32_t transform
+            object::StaticRobot<999, 999> wideRobot;
+            wideRobot.setReportCallback(countReport);
+            auto bench_static_robot_wide = [&](){
+                uint64_t accepted = 0;
+                for(const type::Command& command : commands)
+                    accepted += wideRobot.execute(command);
+                m_sink = m_sink + accepted + reports;
+            };
+            CREATE_BENCHMARK(bench_static_robot_wide, COMMANDS)
+        }
+
+        /**
+         * BENCHMARK: coroutine scripts, the extra cost of yielding after every command is the cost of one yield
+        */
+        {
+            const uint32_t COMMANDS = 2000000;
+            std::string script;
+            for(const auto& command : _buildScript(COMMANDS, 35))
+                script.append(command).push_back('|');
+            object::ToyRobot robot;
+            robot.setHistoryCapacity(0);
+            uint64_t yields[2] = { 0, 0 };
+            double seconds[2] = { 0, 0 };
+            for(const size_t slice : { 0, 1 })
+            {
+                auto bench_script_yield = [&](){
+                    const auto start(std::chrono::steady_clock::now());
+                    object::ScriptTask task = object::runScript(robot, script, slice);
+                    while(task.resume())
+                        ++yields[slice];
+                    seconds[slice] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    m_sink = m_sink + yields[slice];
+                };
+                printf("\nBENCHMARK: script yielding %s", slice ? "after every command" : "on REPORT only");
+                CREATE_BENCHMARK(bench_script_yield, COMMANDS)
+            }
+            printf("\nBENCHMARK: %.2f ns per extra yield\n", (seconds[1] - seconds[0]) * 1e9 / double(yields[1] - yields[0]));
+
+            // many scripts interleaved on one thread
+            const uint32_t SCRIPTS = 10000;
+            const uint32_t SCRIPT_COMMANDS = 200;
+            std::vector<std::string> scripts;
+            for(uint32_t i = 0; i < SCRIPTS; ++i)
+            {
+                scripts.emplace_back();
+                for(const auto& command : _buildScript(SCRIPT_COMMANDS, i))
+                    scripts.back().append(command).push_back('|');
+            }
+            std::vector<std::unique_ptr<object::ToyRobot>> robots;
+            for(uint32_t i = 0; i < SCRIPTS; ++i)
+                robots.push_back(std::make_unique<object::ToyRobot>());
+            object::ScriptScheduler scheduler;
+            for(uint32_t i = 0; i < SCRIPTS; ++i)
+                scheduler.add(object::runScript(*robots[i], scripts[i], 1));
+            auto bench_script_scheduler = [&](){
+                m_sink = m_sink + scheduler.run();
+            };
+            printf("\nBENCHMARK: %u scripts round robin, yielding after every command", SCRIPTS);
+            CREATE_BENCHMARK(bench_script_scheduler, uint64_t(SCRIPTS) * SCRIPT_COMMANDS)
+        }
+
+        /**
+         * BENCHMARK: lockstep ticks, robots on a table with 4 cells per robot running looping 4 command streams
+        */
+        for(const uint32_t robots : { 10000u, 1000000u, 10000000u })
+        {
+            const unsigned extent = std::min<unsigned>(object::Fleet::MAX_EXTENT, unsigned(std::sqrt(double(robots) * 4.0)));
+            object::Fleet fleet(extent, extent);
+            fleet.reserve(robots);
+            std::mt19937 random(36);
+            for(uint32_t i = 0; i < robots; ++i)
+                fleet.placeHere(fleet.addRobot(), random() % (extent + 1), random() % (extent + 1), type::HEADING(random() % 4));
+            object::TickEngine engine(fleet);
+            std::vector<type::Command> stream(4);
+            for(uint32_t i = 0; i < robots; ++i)
+            {
+                for(auto& command : stream)
+                    command.action = random() % 2 ? type::ACTION::MOVE : type::ACTION(1 + random() % 2);
+                engine.addStream(stream);
+            }
+            engine.setLooping(true);
+            const uint64_t ticks = std::max<uint64_t>(5, 20000000 / robots);
+            object::TickEngine::TickStats stats;
+            const auto start(std::chrono::steady_clock::now());
+            auto bench_tick_engine = [&](){
+                stats = engine.run(ticks);
+                m_sink = m_sink + stats.m_accepted;
+            };
+            printf("\nBENCHMARK: %u robots on a %ux%u table", robots, extent + 1, extent + 1);
+            CREATE_BENCHMARK(bench_tick_engine, uint64_t(ticks) * robots)
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            printf("BENCHMARK: %.1f ticks/s, %.2f%% of commands collided\n", double(ticks) / seconds,
+                100.0 * double(stats.m_collisions) / double(stats.m_commands));
+        }
+
+        /**
+         * BENCHMARK: tracing overhead on replayed commands, off and at several sampling rates
+        */
+        {
+            const uint32_t COMMANDS = 10000000;
+            const std::vector<std::string> script = _buildScript(COMMANDS, 38);
+            object::ToyRobot robot;
+            robot.setReportCallback([](const std::string&){});
+            for(const uint32_t sampleEvery : { 0u, 1000u, 100u, 1u })
+            {
+                // spans beyond one million per thread are dropped
+                if(sampleEvery != 0)
+                    object::Tracer::start("", sampleEvery, size_t(1) << 20);
+                auto bench_trace_replay = [&](){
+                    for(const std::string& command : script)
+                        robot.proccessInput(command);
+                };
+                if(sampleEvery == 0)
+                    printf("\nBENCHMARK: tracing off");
+                else
+                    printf("\nBENCHMARK: tracing one command in %u", sampleEvery);
+                CREATE_BENCHMARK(bench_trace_replay, COMMANDS)
+                if(sampleEvery != 0)
+                {
+                    printf("BENCHMARK: %lu spans recorded, %lu dropped\n", (unsigned long)object::Tracer::recordedCount(),
+                        (unsigned long)object::Tracer::droppedCount());
+                    object::Tracer::stop();
+                    object::Tracer::clear();
+                }
+            }
+        }
+
+        /**
+         * BENCHMARK: batch dispatch against one proccessInput call per command
+        */
+        {
+            const uint32_t COMMANDS = 10000000;
+            const std::vector<std::string> script = _buildScript(COMMANDS, 40);
+            const std::vector<std::string_view> views(script.begin(), script.end());
+            std::vector<type::Command> commands(COMMANDS);
+            for(uint32_t i = 0; i < COMMANDS; ++i)
+                object::InputHandler::parseCommand(views[i], commands[i]);
+            object::ToyRobot robot;
+            robot.setReportCallback([](const std::string&){});
+            std::string reports;
+            // about one in ten commands is a REPORT of up to 14 bytes
+            reports.reserve(size_t(COMMANDS) * 2);
+            auto bench_batch_loop = [&](){
+                for(const std::string& command : script)
+                    robot.proccessInput(command);
+            };
+            CREATE_BENCHMARK(bench_batch_loop, COMMANDS)
+            object::InputHandler::BatchResult result;
+            auto bench_batch_strings = [&](){
+                reports.clear();
+                result = robot.processBatch(views, &reports);
+                m_sink = m_sink + result.m_accepted;
+            };
+            CREATE_BENCHMARK(bench_batch_strings, COMMANDS)
+            printf("BENCHMARK: %lu accepted, %lu rejected, %lu reports in %lu bytes\n", (unsigned long)result.m_accepted,
+                (unsigned long)result.m_rejected, (unsigned long)result.m_reports, (unsigned long)reports.size());
+            auto bench_batch_commands = [&](){
+                reports.clear();
+                result = robot.processBatch(commands, &reports);
+                m_sink = m_sink + result.m_accepted;
+            };
+            CREATE_BENCHMARK(bench_batch_commands, COMMANDS)
+        }
+
+        /**
+         * BENCHMARK: fleet startup, replaying the input that built it against mapping its file
+        */
+        {
+            const uint32_t ROBOTS = 10000000;
+            const unsigned EXTENT = object::Fleet::MAX_EXTENT;
+            const std::string path = (std::filesystem::temp_directory_path() / "toyRobotFleetBenchmark.bin").string();
+            std::filesystem::remove(path);
+            // one PLACE and three moves per robot, parsed from text like the data set mode
+            auto replay = [&](object::Fleet& _fleet){
+                static const char* const headings[] = { "NORTH", "EAST", "SOUTH", "WEST" };
+                static const char* const steps[] = { "MOVE", "RIGHT", "MOVE" };
+                std::mt19937 random(41);
+                char line[64];
+                type::Command command;
+                _fleet.reserve(ROBOTS);
+                for(uint32_t i = 0; i < ROBOTS; ++i)
+                {
+                    const uint32_t robot = _fleet.addRobot();
+                    const int length = snprintf(line, sizeof(line), "PLACE %u,%u,%s", unsigned(random() % EXTENT),
+                        unsigned(random() % EXTENT), headings[random() % 4]);
+                    if(object::InputHandler::parseCommand(std::string_view(line, size_t(length)), command))
+                        _fleet.placeHere(robot, command.x, command.y, command.heading);
+                    for(const char* step : steps)
+                    {
+                        object::InputHandler::parseCommand(step, command);
+                        if(command.action == type::ACTION::MOVE)
+                            _fleet.move(robot);
+                        else
+                            _fleet.rotateRight(robot);
+                    }
+                }
+            };
+            auto bench_fleet_replay = [&](){
+                object::Fleet fleet(EXTENT, EXTENT);
+                replay(fleet);
+                m_sink = m_sink + fleet.size();
+            };
+            printf("\nBENCHMARK: startup of %u robots by replaying 4 commands each", ROBOTS);
+            CREATE_BENCHMARK(bench_fleet_replay, ROBOTS)
+            auto bench_fleet_replay_mapped = [&](){
+                auto fleet = object::Fleet::openMapped(path, EXTENT, EXTENT, object::Fleet::SYNC::ON_CLOSE);
+                if(fleet != nullptr)
+                    replay(*fleet);
+            };
+            printf("\nBENCHMARK: the same replay into a mapped fleet, synced on close");
+            CREATE_BENCHMARK(bench_fleet_replay_mapped, ROBOTS)
+            std::unique_ptr<object::Fleet> mapped;
+            auto bench_fleet_open_mapped = [&](){
+                mapped = object::Fleet::openMapped(path, EXTENT, EXTENT);
+            };
+            printf("\nBENCHMARK: startup by mapping the fleet file");
+            CREATE_BENCHMARK(bench_fleet_open_mapped, ROBOTS)
+            uint64_t placed = 0;
+            auto bench_fleet_first_scan = [&](){
+                for(uint32_t robot = 0; mapped != nullptr && robot < mapped->size(); ++robot)
+                    placed += mapped->isPlaced(robot) + mapped->getPosition(robot).x;
+                m_sink = m_sink + placed;
+            };
+            printf("\nBENCHMARK: first pass over every robot of the mapped fleet, faulting its pages in");
+            CREATE_BENCHMARK(bench_fleet_first_scan, ROBOTS)
+            printf("BENCHMARK: %lu robots mapped from a %lu MB file\n", (unsigned long)(mapped ? mapped->size() : 0),
+                (unsigned long)(std::filesystem::file_size(path) >> 20));
+            mapped.reset();
+            std::filesystem::remove(path);
+        }
+
+        /**
+         * BENCHMARK: session churn, 1000 live sessions where each cycle ends the oldest and starts a new one
+         * that runs PLACE, MOVE, LEFT and REPORT
+        */
+        {
+            const uint32_t CYCLES = 2000000;
+            const uint32_t SESSIONS = 1000;
+            const type::Command commands[] = {
+                { type::ACTION::PLACE, 2, 2, type::HEADING::NORTH },
+                { type::ACTION::MOVE, 0, 0, type::HEADING::UNDEFINED },
+                { type::ACTION::LEFT, 0, 0, type::HEADING::UNDEFINED },
+                { type::ACTION::REPORT, 0, 0, type::HEADING::UNDEFINED } };
+            auto silent = [](const std::string&){};
+            std::vector<std::unique_ptr<object::ToyRobot>> heapSessions(SESSIONS);
+            auto bench_churn_make_unique = [&](){
+                for(uint32_t i = 0; i < CYCLES; ++i)
+                {
+                    std::unique_ptr<object::ToyRobot>& session = heapSessions[i % SESSIONS];
+                    session = std::make_unique<object::ToyRobot>();
+                    session->setReportCallback(silent);
+                    for(const type::Command& command : commands)
+                        session->execute(command);
+                }
+                heapSessions.clear();
+            };
+            CREATE_BENCHMARK(bench_churn_make_unique, CYCLES)
+            object::RobotPool pool(SESSIONS);
+            std::vector<object::RobotPool::Handle> poolSessions(SESSIONS);
+            auto bench_churn_pool = [&](){
+                for(uint32_t i = 0; i < CYCLES; ++i)
+                {
+                    object::RobotPool::Handle& session = poolSessions[i % SESSIONS];
+                    pool.destroy(session);
+                    session = pool.create();
+                    object::ToyRobot* robot = pool.get(session);
+                    robot->setReportCallback(silent);
+                    for(const type::Command& command : commands)
+                        robot->execute(command);
+                }
+            };
+            CREATE_BENCHMARK(bench_churn_pool, CYCLES)
+        }
+
+        /**
+         * BENCHMARK: trajectory recording of a replay, its size per step and random access decoding
+        */
+        {
+            const uint32_t COMMANDS = 10000000;
+            const uint32_t LOOKUPS = 1000000;
+            const std::vector<std::string> script = _buildScript(COMMANDS, 43);
+            object::ToyRobot robot;
+            robot.setReportCallback([](const std::string&){});
+            object::TrajectoryRecorder recorder;
+            robot.addListener(&recorder);
+            // what storing a report string per step would cost
+            uint64_t reportBytes = 0;
+            auto bench_trajectory_record = [&](){
+                for(const std::string& command : script)
+                    robot.proccessInput(command);
+            };
+            CREATE_BENCHMARK(bench_trajectory_record, COMMANDS)
+            robot.removeListener(&recorder);
+            for(uint64_t step = 0; step < recorder.size(); step += 997)
+            {
+                const auto position = recorder.stateAt(step).getPosition();
+                reportBytes += sizeof(std::string) + std::to_string(position.x).size() + std::to_string(position.y).size() + 7;
+            }
+            const double sampled = double((recorder.size() + 996) / 997);
+            printf("BENCHMARK: %lu steps in %lu bytes, %.3f bytes per step against about %.1f for a report string per step\n",
+                (unsigned long)recorder.size(), (unsigned long)recorder.byteSize(),
+                double(recorder.byteSize()) / double(recorder.size()), double(reportBytes) / sampled);
+            std::mt19937_64 random(44);
+            auto bench_trajectory_state_at = [&](){
+                uint64_t sum = 0;
+                for(uint32_t i = 0; i < LOOKUPS; ++i)
+                    sum += recorder.stateAt(random() % recorder.size()).getPosition().x;
+                m_sink = m_sink + sum;
+            };
+            CREATE_BENCHMARK(bench_trajectory_state_at, LOOKUPS)
+            // the same figure on the data sets shipped with the repo
+            uint64_t dataSetSteps = 0;
+            uint64_t dataSetBytes = 0;
+            for(const std::filesystem::path& path : _dataSetFiles())
+            {
+                std::ifstream file(path, std::ios::binary);
+                const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+                object::ToyRobot replay;
+                replay.setReportCallback([](const std::string&){});
+                object::TrajectoryRecorder replayRecorder;
+                replay.addListener(&replayRecorder);
+                object::Tokenizer tokenizer;
+                auto run = [&](std::string_view _command){ replay.proccessInput(std::string(_command)); };
+                tokenizer.feed(text, run);
+                tokenizer.finish(run);
+                replay.removeListener(&replayRecorder);
+                dataSetSteps += replayRecorder.size();
+                dataSetBytes += replayRecorder.byteSize();
+                printf("BENCHMARK: %s, %lu steps in %lu bytes, %.3f bytes per step\n", path.filename().string().c_str(),
+                    (unsigned long)replayRecorder.size(), (unsigned long)replayRecorder.byteSize(),
+                    replayRecorder.size() ? double(replayRecorder.byteSize()) / double(replayRecorder.size()) : 0.0);
+            }
+            if(dataSetSteps)
+                printf("BENCHMARK: data sets, %lu steps in %lu bytes, %.3f bytes per step\n",
+                    (unsigned long)dataSetSteps, (unsigned long)dataSetBytes, double(dataSetBytes) / double(dataSetSteps));
+            else
+                printf("BENCHMARK: no data sets found under %s\n", DATA_SET_DIR);
+        }
+
+        /**
+         * BENCHMARK: sharded runs across worker processes, strips of a 2048x2048 table, against one process
+        */
+        {
+            const uint32_t ROBOTS = 200000;
+            const uint32_t STREAM = 50;
+            const unsigned EXTENT = 2047;
+            auto build = [&](object::Fleet& _fleet, object::ShardRunner& _runner){
+                std::mt19937 random(45);
+                std::vector<type::Command> stream(STREAM);
+                _fleet.reserve(ROBOTS);
+                for(uint32_t robot = 0; robot < ROBOTS; ++robot)
+                {
+                    _fleet.placeHere(_fleet.addRobot(), random() % (EXTENT + 1), random() % (EXTENT + 1), type::HEADING(random() % 4));
+                    // mostly straight lines so robots cross strip edges
+                    for(type::Command& command : stream)
+                        command.action = random() % 10 ? type::ACTION::MOVE : type::ACTION(1 + random() % 2);
+                    _runner.addStream(stream);
+                }
+            };
+            for(const unsigned workers : { 0u, 1u, 2u, 4u, 8u })
+            {
+                object::Fleet fleet(EXTENT, EXTENT);
+                object::ShardRunner runner(fleet, std::max(1u, workers), 1);
+                build(fleet, runner);
+                object::ShardRunner::ShardStats stats;
+                auto bench_shard_run = [&](){
+                    stats = workers == 0 ? runner.runInProcess() : runner.run();
+                };
+                if(workers == 0)
+                    printf("\nBENCHMARK: %u robots with %u commands each in this process, %u hardware threads", ROBOTS, STREAM,
+                        std::thread::hardware_concurrency());
+                else
+                    printf("\nBENCHMARK: %u worker processes", workers);
+                const auto start(std::chrono::steady_clock::now());
+                CREATE_BENCHMARK(bench_shard_run, uint64_t(ROBOTS) * STREAM)
+                const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                printf("BENCHMARK: %.1fM commands/s, %lu handoffs\n", double(stats.m_commands) / seconds / 1e6,
+                    (unsigned long)stats.m_handoffs);
+            }
+        }
+
+        /**
+         * BENCHMARK: CALL of a 1000 command macro against running its body command by command
+        */
+        {
+            const uint32_t BODY = 1000;
+            const uint32_t CALLS = 10000;
+            std::mt19937 random(46);
+            std::vector<type::Command> body(BODY);
+            static const char* const names[] = { "MOVE", "LEFT", "RIGHT" };
+            std::string macro;
+            for(type::Command& command : body)
+            {
+                command.action = random() % 3 ? type::ACTION::MOVE : type::ACTION(1 + random() % 2);
+                macro.append(names[size_t(command.action)]).append(";");
+            }
+            object::ToyRobot robot;
+            robot.define("WALK", macro);
+            robot.placeHere(0, 0, type::HEADING::NORTH);
+            auto bench_macro_first_call = [&](){
+                robot.call("WALK");
+            };
+            CREATE_BENCHMARK(bench_macro_first_call, 1)
+            auto bench_macro_call = [&](){
+                for(uint32_t i = 0; i < CALLS; ++i)
+                    robot.call("WALK");
+                m_sink = m_sink + robot.getPosition().x;
+            };
+            CREATE_BENCHMARK(bench_macro_call, CALLS)
+            auto bench_macro_expanded = [&](){
+                for(uint32_t i = 0; i < CALLS; ++i)
+                    for(const type::Command& command : body)
+                        robot.execute(command);
+                m_sink = m_sink + robot.getPosition().x;
+            };
+            CREATE_BENCHMARK(bench_macro_expanded, CALLS)
+        }
+
+        /**
+         * BENCHMARK: replay of a 1M command script against hashing it and reading the cached result from memory and disk
+        */
+        {
+            const uint32_t COMMANDS = 1000000;
+            std::string script;
+            for(const std::string& command : _buildScript(COMMANDS, 47))
+                script.append(command).push_back('\n');
+            object::ResultCache::Result result;
+            auto bench_cache_replay = [&](){
+                object::ToyRobot robot;
+                result.m_reports.clear();
+                robot.setReportCallback([&](const std::string& _report){ result.m_reports.append(_report).push_back('\n'); });
+                object::Tokenizer tokenizer;
+                auto run = [&](std::string_view _command){ robot.proccessInput(std::string(_command)); ++result.m_commands; };
+                tokenizer.feed(script, run);
+                tokenizer.finish(run);
+                result.m_finalState = robot.snapshot();
+            };
+            CREATE_BENCHMARK(bench_cache_replay, COMMANDS)
+            const std::filesystem::path directory = std::filesystem::temp_directory_path() / "toyrobot_result_cache_bench";
+            object::ResultCacheConfig config;
+            config.m_directory = directory.string();
+            object::ResultCache cache(config);
+            object::ContentHasher hasher;
+            hasher.update(script);
+            const object::ResultCache::Key key = object::ResultCache::makeKey(hasher, object::ToyRobot::Snapshot(), TABLE_TOP_X, TABLE_TOP_Y, nullptr);
+            cache.store(key, result);
+            auto bench_cache_memory_hit = [&](){
+                object::ContentHasher lookup;
+                lookup.update(script);
+                object::ResultCache::Result found;
+                cache.find(object::ResultCache::makeKey(lookup, object::ToyRobot::Snapshot(), TABLE_TOP_X, TABLE_TOP_Y, nullptr), found);
+                m_sink = m_sink + found.m_commands;
+            };
+            CREATE_BENCHMARK(bench_cache_memory_hit, COMMANDS)
+            cache.clear();
+            auto bench_cache_disk_hit = [&](){
+                object::ResultCache::Result found;
+                cache.find(key, found);
+                m_sink = m_sink + found.m_commands;
+            };
+            CREATE_BENCHMARK(bench_cache_disk_hit, COMMANDS)
+            printf("BENCHMARK: %lu script bytes, %lu report bytes\n", (unsigned long)script.size(), (unsigned long)result.m_reports.size());
+            std::filesystem::remove_all(directory);
+        }
+
+        /**
+         * BENCHMARK: addressed commands to random targets among 1K, 1M and 10M robot ids, batched with lookahead,
+         *            one at a time, and through std::unordered_map for comparison
+        */
+        for(const uint32_t robots : { 1000u, 1000000u, 10000000u })
+        {
+            const uint32_t COMMANDS = 10000000;
+            object::Fleet fleet(object::Fleet::MAX_EXTENT, object::Fleet::MAX_EXTENT);
+            object::CommandRouter router(fleet, robots);
+            std::unordered_map<uint32_t, uint32_t> baseline;
+            baseline.reserve(robots);
+            fleet.reserve(robots);
+            std::mt19937 random(49);
+            // sparse ids, an odd multiplier keeps them distinct
+            std::vector<uint32_t> ids(robots);
+            for(uint32_t robot = 0; robot < robots; ++robot)
+            {
+                ids[robot] = (robot + 1) * 2654435761u;
+                const uint32_t slot = router.addRobot(ids[robot]);
+                fleet.placeHere(slot, random() % 32768, random() % 32768, type::HEADING(random() % 4));
+                baseline.emplace(ids[robot], slot);
+            }
+            std::vector<object::CommandRouter::AddressedCommand> commands(COMMANDS);
+            for(object::CommandRouter::AddressedCommand& command : commands)
+            {
+                command.m_robot = ids[random() % robots];
+                command.m_command.action = type::ACTION(random() % 3);
+            }
+            printf("\nBENCHMARK: %u robot ids", robots);
+            auto bench_route_batch = [&](){
+                router.routeBatch(std::span<const object::CommandRouter::AddressedCommand>(commands));
+            };
+            CREATE_BENCHMARK(bench_route_batch, COMMANDS)
+            auto bench_route_single = [&](){
+                for(const object::CommandRouter::AddressedCommand& command : commands)
+                    router.route(command);
+            };
+            CREATE_BENCHMARK(bench_route_single, COMMANDS)
+            auto bench_route_unordered_map = [&](){
+                for(const object::CommandRouter::AddressedCommand& command : commands)
+                {
+                    const uint32_t slot = baseline.find(command.m_robot)->second;
+                    switch (command.m_command.action)
+                    {
+                    case type::ACTION::MOVE:    fleet.move(slot); break;
+                    case type::ACTION::LEFT:    fleet.rotateLeft(slot); break;
+                    default:                    fleet.rotateRight(slot); break;
+                    }
+                }
+            };
+            CREATE_BENCHMARK(bench_route_unordered_map, COMMANDS)
+        }
+
+        /**
+         * BENCHMARK: each engine on a 1M command script, then the parsed engine with shadow checks at several sample rates
+        */
+        {
+            const uint32_t COMMANDS = 1000000;
+            const std::vector<std::string> script = _buildScript(COMMANDS, 51);
+            auto runEngine = [&](const char* _name, const uint32_t _sample){
+                object::ToyRobot robot;
+                object::EngineConfig config;
+                config.m_engine = _name;
+                config.m_shadowSample = _sample;
+                std::unique_ptr<object::Engine> engine = object::EngineRegistry::create(config, robot);
+                engine->setReportCallback([](const std::string&){});
+                auto bench_engine = [&](){
+                    for(const std::string& command : script)
+                        engine->run(command);
+                };
+                printf("\nBENCHMARK: %s engine, shadow sample %u", _name, _sample);
+                CREATE_BENCHMARK(bench_engine, COMMANDS)
+            };
+            for(const char* name : { "reference", "parsed", "static" })
+                runEngine(name, 0);
+            for(const uint32_t sample : { 1000u, 100u, 10u, 1u })
+                runEngine("parsed", sample);
+        }
+
+        /**
+         * BENCHMARK: editable script of 10M commands, building it, edits each followed by the final state, prefix
+         * queries, and a full replay which is what every edit would cost without it
+        */
+        {
+            const uint32_t COMMANDS = 10000000;
+            const uint32_t EDITS = 100000;
+            std::vector<type::Command> commands(COMMANDS);
+            {
+                const std::vector<std::string> script = _buildScript(COMMANDS, 49);
+                for(uint32_t i = 0; i < COMMANDS; ++i)
+                    object::InputHandler::parseCommand(script[i], commands[i]);
+            }
+            object::EditableScript script;
+            printf("\nBENCHMARK: editable script of %u commands", COMMANDS);
+            auto bench_editable_assign = [&](){
+                script.assign(commands);
+            };
+            CREATE_BENCHMARK(bench_editable_assign, COMMANDS)
+            auto bench_editable_replay = [&](){
+                object::ToyRobot robot;
+                robot.setReportCallback([](const std::string&){});
+                for(const type::Command& command : commands)
+                    robot.execute(command);
+                m_sink = m_sink + robot.snapshot().m_hasBeenPlaced;
+            };
+            CREATE_BENCHMARK(bench_editable_replay, COMMANDS)
+            std::mt19937 random(49);
+            auto bench_editable_edit = [&](){
+                for(uint32_t i = 0; i < EDITS; ++i)
+                {
+                    const uint64_t index = random() % script.size();
+                    const type::Command& command = commands[random() % COMMANDS];
+                    switch (i % 3)
+                    {
+                    case 0:     script.insert(index, command); break;
+                    case 1:     script.replace(index, command); break;
+                    default:    script.erase(index); break;
+                    }
+                    m_sink = m_sink + script.finalState().m_hasBeenPlaced;
+                }
+            };
+            CREATE_BENCHMARK(bench_editable_edit, EDITS)
+            auto bench_editable_prefix = [&](){
+                for(uint32_t i = 0; i < EDITS; ++i)
+                    m_sink = m_sink + script.stateAt(random() % script.size()).m_transform.getRotation();
+            };
+            CREATE_BENCHMARK(bench_editable_prefix, EDITS)
+        }
+
+        /**
+         * BENCHMARK: fleet commands on a 1024x1024 table without a geofence monitor, then with one over 0, 10 and 10K
+         * zones, events drained from the queue as they would be by a consumer
+        */
+        {
+            const uint32_t EXTENT = 1023;
+            const uint32_t ROBOTS = 1000;
+            const uint32_t COMMANDS = 10000000;
+            const uint32_t DRAIN_EVERY = 4096;
+            std::mt19937 random(50);
+            std::vector<std::pair<uint32_t, type::ACTION>> commands(COMMANDS);
+            for(auto& command : commands)
+            {
+                const uint32_t roll = random() % 10;
+                command = { uint32_t(random() % ROBOTS), roll < 8 ? type::ACTION::MOVE : roll < 9 ? type::ACTION::LEFT : type::ACTION::RIGHT };
+            }
+            std::vector<std::array<uint32_t, 3>> places(ROBOTS);
+            for(auto& place : places)
+                place = { uint32_t(random() % (EXTENT + 1)), uint32_t(random() % (EXTENT + 1)), uint32_t(random() % 4) };
+            auto runFleet = [&](const int _zones){
+                object::Fleet fleet(EXTENT, EXTENT);
+                object::GeofenceIndex index(EXTENT, EXTENT);
+                object::SpscQueue<object::GeofenceEvent> queue(1 << 16);
+                object::GeofenceMonitor monitor(index, queue);
+                std::mt19937 zoneRandom(50);
+                for(int i = 0; i < _zones; ++i)
+                {
+                    const uint32_t x = zoneRandom() % (EXTENT + 1);
+                    const uint32_t y = zoneRandom() % (EXTENT + 1);
+                    index.addZone(x, y, std::min(EXTENT, x + uint32_t(zoneRandom() % 64)), std::min(EXTENT, y + uint32_t(zoneRandom() % 64)));
+                }
+                for(uint32_t robot = 0; robot < ROBOTS; ++robot)
+                    fleet.placeHere(fleet.addRobot(), places[robot][0], places[robot][1], type::HEADING(places[robot][2]));
+                if(_zones >= 0)
+                    fleet.setGeofenceMonitor(&monitor);
+                uint64_t consumed = 0;
+                auto bench_geofence = [&](){
+                    object::GeofenceEvent event;
+                    for(uint32_t i = 0; i < COMMANDS; ++i)
+                    {
+                        switch (commands[i].second)
+                        {
+                        case type::ACTION::MOVE:    fleet.move(commands[i].first); break;
+                        case type::ACTION::LEFT:    fleet.rotateLeft(commands[i].first); break;
+                        default:                    fleet.rotateRight(commands[i].first); break;
+                        }
+                        if(i % DRAIN_EVERY == 0)
+                            while(queue.tryPop(event))
+                                ++consumed;
+                    }
+                    while(queue.tryPop(event))
+                        ++consumed;
+                };
+                if(_zones < 0)
+                    printf("\nBENCHMARK: fleet commands without a geofence monitor");
+                else
+                    printf("\nBENCHMARK: fleet commands with %d geofence zones, %lu interned sets", _zones,
+                        (unsigned long)index.getSetCount());
+                CREATE_BENCHMARK(bench_geofence, COMMANDS)
+                if(_zones >= 0)
+                    monitor.getStats().print();
+                m_sink = m_sink + consumed;
+            };
+            for(const int zones : { -1, 0, 10, 10000 })
+                runFleet(zones);
+        }
+    };
+};
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,370 @@
+#include "EditableScript.h"
+#include <algorithm>
+#include <deque>
+
+namespace object
+{
+    EditableScript::EditableScript(const ObstacleMap* _obstacleMap)
+        :   m_obstacleMap(_obstacleMap),
+            m_obstacleVersion(_obstacleMap != nullptr ? _obstacleMap->getVersion() : 0)
+    {
+        _buildCodeTransitions();
+    }
+
+    bool EditableScript::_encode(const type::Command& _command, uint8_t& _code)
+    {
+        switch (_command.action)
+        {
+        case type::ACTION::MOVE:    _code = CODE_MOVE; return true;
+        case type::ACTION::LEFT:    _code = CODE_LEFT; return true;
+        case type::ACTION::RIGHT:   _code = CODE_RIGHT; return true;
+        case type::ACTION::REPORT:  _code = CODE_NONE; return true;
+        case type::ACTION::PLACE:
+            // a PLACE off the table is rejected by the robot, so it changes nothing
+            if(_command.x > TABLE_TOP_X || _command.y > TABLE_TOP_Y || _command.heading > type::HEADING::WEST)
+                _code = CODE_NONE;
+            else
+                _code = uint8_t(CODE_PLACE + (_command.y * (TABLE_TOP_X + 1) + _command.x) * 4 + _command.heading);
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    uint8_t EditableScript::_packState(const ToyRobot::Snapshot& _snapshot)
+    {
+        if(!_snapshot.m_hasBeenPlaced)
+            return UNPLACED_STATE;
+        const auto position = _snapshot.m_transform.getPosition();
+        return uint8_t((position.y * (TABLE_TOP_X + 1) + position.x) * 4 + (_snapshot.m_transform.getRotation() & 0b11));
+    }
+
+    ToyRobot::Snapshot EditableScript::_unpackState(const uint8_t _state)
+    {
+        ToyRobot::Snapshot snapshot;
+        if(_state == UNPLACED_STATE)
+            return snapshot;
+        const uint32_t cell = _state / 4;
+        snapshot.m_transform.setPosition(type::T_Position<uint8_t>(uint8_t(cell % (TABLE_TOP_X + 1)), uint8_t(cell / (TABLE_TOP_X + 1))));
+        snapshot.m_transform.setRotation(type::HEADING(_state & 0b11));
+        snapshot.m_hasBeenPlaced = true;
+        return snapshot;
+    }
+
+    uint32_t EditableScript::_nextPriority()
+    {
+        // xorshift64, priorities only need to be spread out
+        m_random ^= m_random << 13;
+        m_random ^= m_random >> 7;
+        m_random ^= m_random << 17;
+        return uint32_t(m_random >> 32);
+    }
+
+    void EditableScript::_buildCodeTransitions()
+    {
+        m_codeTransitions.resize(CODES);
+        // run every code from every state on a robot, so the results match ToyRobot exactly
+        ToyRobot robot;
+        robot.setObstacleMap(m_obstacleMap);
+        for(uint32_t code = 0; code < CODES; ++code)
+        {
+            for(uint32_t state = 0; state < STATES; ++state)
+            {
+                robot.restore(_unpackState(uint8_t(state)));
+                if(code == CODE_MOVE)
+                    robot.move();
+                else if(code == CODE_LEFT)
+                    robot.rotateLeft();
+                else if(code == CODE_RIGHT)
+                    robot.rotateRight();
+                else if(code >= CODE_PLACE)
+                {
+                    const ToyRobot::Snapshot place = _unpackState(uint8_t(code - CODE_PLACE));
+                    const auto position = place.m_transform.getPosition();
+                    robot.placeHere(position.x, position.y, place.m_transform.getRotation());
+                }
+                m_codeTransitions[code][state] = _packState(robot.snapshot());
+            }
+        }
+    }
+
+    void EditableScript::_updateBlock(Node& _node) const
+    {
+        Transition& block = _node.m_block;
+        for(uint32_t state = 0; state < STATES; ++state)
+            block[state] = uint8_t(state);
+        for(const uint8_t code : _node.m_codes)
+        {
+            const Transition& transition = m_codeTransitions[code];
+            for(uint8_t& state : block)
+                state = transition[state];
+        }
+    }
+
+    void EditableScript::_updateTotal(Node& _node)
+    {
+        _node.m_count = _node.m_codes.size();
+        _node.m_total = _node.m_block;
+        // the left subtree runs first, the right one last
+        if(_node.m_left)
+        {
+            _node.m_count += _node.m_left->m_count;
+            for(uint32_t state = 0; state < STATES; ++state)
+                _node.m_total[state] = _node.m_block[_node.m_left->m_total[state]];
+        }
+        if(_node.m_right)
+        {
+            _node.m_count += _node.m_right->m_count;
+            for(uint8_t& state : _node.m_total)
+                state = _node.m_right->m_total[state];
+        }
+    }
+
+    void EditableScript::_updateAll(Node* _node)
+    {
+        if(_node == nullptr)
+            return;
+        _updateAll(_node->m_left.get());
+        _updateAll(_node->m_right.get());
+        _updateBlock(*_node);
+        _updateTotal(*_node);
+    }
+
+    void EditableScript::_split(std::unique_ptr<Node> _node, const uint64_t _count, std::unique_ptr<Node>& _left,
+        std::unique_ptr<Node>& _right)
+    {
+        if(!_node)
+        {
+            _left.reset();
+            _right.reset();
+            return;
+        }
+        const uint64_t leftCount = _node->m_left ? _node->m_left->m_count : 0;
+        std::unique_ptr<Node> rest;
+        if(_count <= leftCount)
+        {
+            _split(std::move(_node->m_left), _count, _left, rest);
+            _node->m_left = std::move(rest);
+            _updateTotal(*_node);
+            _right = std::move(_node);
+        }
+        else
+        {
+            _split(std::move(_node->m_right), _count - leftCount - _node->m_codes.size(), rest, _right);
+            _node->m_right = std::move(rest);
+            _updateTotal(*_node);
+            _left = std::move(_node);
+        }
+    }
+
+    std::unique_ptr<EditableScript::Node> EditableScript::_merge(std::unique_ptr<Node> _left, std::unique_ptr<Node> _right)
+    {
+        if(!_left)
+            return _right;
+        if(!_right)
+            return _left;
+        if(_left->m_priority >= _right->m_priority)
+        {
+            _left->m_right = _merge(std::move(_left->m_right), std::move(_right));
+            _updateTotal(*_left);
+            return _left;
+        }
+        _right->m_left = _merge(std::move(_left), std::move(_right->m_left));
+        _updateTotal(*_right);
+        return _right;
+    }
+
+    template <typename F>
+    void EditableScript::_edit(std::unique_ptr<Node>& _node, uint64_t _index, F&& _change, uint64_t _offset, uint64_t& _splitOffset)
+    {
+        Node& node = *_node;
+        const uint64_t leftCount = node.m_left ? node.m_left->m_count : 0;
+        if(_index < leftCount)
+            _edit(node.m_left, _index, _change, _offset, _splitOffset);
+        else if(_index - leftCount >= node.m_codes.size())
+            _edit(node.m_right, _index - leftCount - node.m_codes.size(), _change, _offset + leftCount + node.m_codes.size(), _splitOffset);
+        else
+        {
+            _change(node.m_codes, size_t(_index - leftCount));
+            if(node.m_codes.empty())
+            {
+                // the children are already composed
+                _node = _merge(std::move(node.m_left), std::move(node.m_right));
+                return;
+            }
+            if(node.m_codes.size() >= BLOCK_LIMIT)
+                _splitOffset = _offset + leftCount;
+            _updateBlock(node);
+        }
+        _updateTotal(node);
+    }
+
+    void EditableScript::_splitBlock(const uint64_t _offset)
+    {
+        std::unique_ptr<Node> left, right, block, rest;
+        _split(std::move(m_root), _offset, left, right);
+        // the overfull block is the first one of right, take it out on its own
+        const Node* first = right.get();
+        while(first->m_left)
+            first = first->m_left.get();
+        _split(std::move(right), first->m_codes.size(), block, rest);
+        std::unique_ptr<Node> second = std::make_unique<Node>();
+        second->m_codes.assign(block->m_codes.begin() + BLOCK_LIMIT / 2, block->m_codes.end());
+        second->m_priority = _nextPriority();
+        block->m_codes.resize(BLOCK_LIMIT / 2);
+        _updateBlock(*block);
+        _updateTotal(*block);
+        _updateBlock(*second);
+        _updateTotal(*second);
+        m_root = _merge(_merge(std::move(left), std::move(block)), _merge(std::move(second), std::move(rest)));
+    }
+
+    void EditableScript::_refresh()
+    {
+        if(m_obstacleMap == nullptr || m_obstacleMap->getVersion() == m_obstacleVersion)
+            return;
+        m_obstacleVersion = m_obstacleMap->getVersion();
+        _buildCodeTransitions();
+        _updateAll(m_root.get());
+    }
+
+    bool EditableScript::assign(std::span<const type::Command> _commands)
+    {
+        std::vector<uint8_t> codes(_commands.size());
+        for(size_t i = 0; i < _commands.size(); ++i)
+            if(!_encode(_commands[i], codes[i]))
+                return false;
+        _refresh();
+        m_root.reset();
+        const size_t blocks = (codes.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        if(blocks == 0)
+            return true;
+        std::vector<std::unique_ptr<Node>> nodes(blocks);
+        for(size_t i = 0; i < blocks; ++i)
+        {
+            nodes[i] = std::make_unique<Node>();
+            const size_t begin = i * BLOCK_SIZE;
+            nodes[i]->m_codes.assign(codes.begin() + begin, codes.begin() + std::min(codes.size(), begin + BLOCK_SIZE));
+            _updateBlock(*nodes[i]);
+        }
+        // a balanced tree, middle block at the root. random priorities, highest first, handed out breadth first keep
+        // every parent above its children
+        std::vector<uint32_t> priorities(blocks);
+        for(uint32_t& priority : priorities)
+            priority = _nextPriority();
+        std::sort(priorities.begin(), priorities.end(), std::greater<uint32_t>());
+        struct Range
+        {
+            size_t m_begin;
+            size_t m_end;
+            std::unique_ptr<Node>* m_slot;
+        };
+        std::deque<Range> ranges{ Range{ 0, blocks, &m_root } };
+        std::vector<Node*> order;
+        order.reserve(blocks);
+        for(size_t next = 0; !ranges.empty(); ranges.pop_front())
+        {
+            const Range range = ranges.front();
+            if(range.m_begin == range.m_end)
+                continue;
+            const size_t middle = range.m_begin + (range.m_end - range.m_begin) / 2;
+            *range.m_slot = std::move(nodes[middle]);
+            Node* node = range.m_slot->get();
+            node->m_priority = priorities[next++];
+            order.push_back(node);
+            ranges.push_back(Range{ range.m_begin, middle, &node->m_left });
+            ranges.push_back(Range{ middle + 1, range.m_end, &node->m_right });
+        }
+        // children come after their parent breadth first
+        for(auto itr = order.rbegin(); itr != order.rend(); ++itr)
+            _updateTotal(**itr);
+        return true;
+    }
+
+    bool EditableScript::insert(const uint64_t _index, const type::Command& _command)
+    {
+        uint8_t code;
+        if(_index > size() || !_encode(_command, code))
+            return false;
+        _refresh();
+        if(!m_root)
+        {
+            m_root = std::make_unique<Node>();
+            m_root->m_codes.push_back(code);
+            m_root->m_priority = _nextPriority();
+            _updateBlock(*m_root);
+            _updateTotal(*m_root);
+            return true;
+        }
+        // appending goes after the last command of the last block
+        const bool isAppend = _index == size();
+        uint64_t split = ~uint64_t(0);
+        _edit(m_root, isAppend ? _index - 1 : _index, [&](std::vector<uint8_t>& _codes, const size_t _position)
+        {
+            _codes.insert(_codes.begin() + ptrdiff_t(_position + isAppend), code);
+        }, 0, split);
+        if(split != ~uint64_t(0))
+            _splitBlock(split);
+        return true;
+    }
+
+    bool EditableScript::replace(const uint64_t _index, const type::Command& _command)
+    {
+        uint8_t code;
+        if(_index >= size() || !_encode(_command, code))
+            return false;
+        _refresh();
+        uint64_t split = ~uint64_t(0);
+        _edit(m_root, _index, [&](std::vector<uint8_t>& _codes, const size_t _position){ _codes[_position] = code; }, 0, split);
+        return true;
+    }
+
+    bool EditableScript::erase(const uint64_t _index)
+    {
+        if(_index >= size())
+            return false;
+        _refresh();
+        uint64_t split = ~uint64_t(0);
+        _edit(m_root, _index, [](std::vector<uint8_t>& _codes, const size_t _position)
+        {
+            _codes.erase(_codes.begin() + ptrdiff_t(_position));
+        }, 0, split);
+        return true;
+    }
+
+    ToyRobot::Snapshot EditableScript::stateAt(uint64_t _count, const ToyRobot::Snapshot& _start)
+    {
+        _refresh();
+        uint8_t state = _packState(_start);
+        const Node* node = m_root.get();
+        while(node != nullptr && _count > 0)
+        {
+            const uint64_t leftCount = node->m_left ? node->m_left->m_count : 0;
+            if(_count <= leftCount)
+            {
+                node = node->m_left.get();
+                continue;
+            }
+            if(node->m_left)
+                state = node->m_left->m_total[state];
+            _count -= leftCount;
+            // the prefix ends inside this block
+            if(_count < node->m_codes.size())
+            {
+                for(size_t i = 0; i < _count; ++i)
+                    state = m_codeTransitions[node->m_codes[i]][state];
+                break;
+            }
+            state = node->m_block[state];
+            _count -= node->m_codes.size();
+            node = node->m_right.get();
+        }
+        return _unpackState(state);
+    }
+
+    ToyRobot::Snapshot EditableScript::finalState(const ToyRobot::Snapshot& _start)
+    {
+        _refresh();
+        return m_root ? _unpackState(m_root->m_total[_packState(_start)]) : _start;
+    }
+}
@@ -0,0 +1,177 @@
+#ifndef EDITABLE_SCRIPT_H
+#define EDITABLE_SCRIPT_H
+
+#include "Objects.h"
+#include <array>
+#include <memory>
+#include <span>
+#include <stdint.h>
+#include <vector>
+
+namespace object
+{
+
+    /**
+     * Command script that stays evaluated while it is edited
+     * @brief   every command is a function from robot state to robot state, and a run of commands is those
+     *          functions composed. the script is a balanced tree (a treap keyed by position) whose leaves are
+     *          blocks of commands and whose nodes keep the composed function of their whole subtree, so an
+     *          insert, erase or replace only recomposes the changed block and the nodes above it, and the state
+     *          after any prefix is read by walking one path down the tree. both are O(log n).
+     *          states are the placed cells of the default table times four headings plus unplaced, so a
+     *          function is a 101 byte table. REPORT does not change the state and is kept as a no op, UNDO,
+     *          REDO, DEFINE and CALL depend on history and are not accepted. results match ToyRobot with the
+     *          same obstacles
+    */
+    class EditableScript
+    {
+    public:
+        /// placed states (y * (TABLE_TOP_X + 1) + x) * 4 + heading, then unplaced
+        static constexpr uint32_t PLACED_STATES = (TABLE_TOP_X + 1) * (TABLE_TOP_Y + 1) * 4;
+        static_assert(PLACED_STATES < 256, "states, unplaced included, are stored in one byte");
+        static constexpr uint8_t UNPLACED_STATE = uint8_t(PLACED_STATES);
+        static constexpr uint32_t STATES = PLACED_STATES + 1;
+        /// commands per block when a script is assigned, a block is split in two when it reaches BLOCK_LIMIT
+        static constexpr uint32_t BLOCK_SIZE = 32;
+        static constexpr uint32_t BLOCK_LIMIT = BLOCK_SIZE * 2;
+
+    private:
+        /// state after a command or run of commands for every state before it
+        typedef std::array<uint8_t, STATES> Transition;
+
+        /// commands are stored as one byte codes, each with its own transition
+        static constexpr uint8_t CODE_NONE = 0;
+        static constexpr uint8_t CODE_MOVE = 1;
+        static constexpr uint8_t CODE_LEFT = 2;
+        static constexpr uint8_t CODE_RIGHT = 3;
+        /// PLACE on placed state s is CODE_PLACE + s
+        static constexpr uint8_t CODE_PLACE = 4;
+        static constexpr uint32_t CODES = CODE_PLACE + PLACED_STATES;
+        static_assert(CODES <= 256, "command codes are stored in one byte");
+
+        struct Node
+        {
+            /// command codes of this block, in order
+            std::vector<uint8_t> m_codes;
+            /// composed transition of m_codes
+            Transition m_block;
+            /// composed transition of the left subtree, this block and the right subtree
+            Transition m_total;
+            /// commands in the subtree
+            uint64_t m_count = 0;
+            /// heap priority, a parent is never below its children
+            uint32_t m_priority = 0;
+            std::unique_ptr<Node> m_left;
+            std::unique_ptr<Node> m_right;
+        };
+
+        const ObstacleMap* m_obstacleMap = nullptr;
+        /// obstacle version m_codeTransitions were built for
+        uint64_t m_obstacleVersion = 0;
+        /// transition of every command code
+        std::vector<Transition> m_codeTransitions;
+        std::unique_ptr<Node> m_root;
+        uint64_t m_random = 0x9e3779b97f4a7c15ull;
+
+        /**
+         * @brief one byte code of a command
+         * @return false if the command depends on history
+        */
+        static bool _encode(const type::Command& _command, uint8_t& _code);
+
+        static uint8_t _packState(const ToyRobot::Snapshot& _snapshot);
+        static ToyRobot::Snapshot _unpackState(const uint8_t _state);
+
+        uint32_t _nextPriority();
+
+        /**
+         * @brief transitions of every code, run on a robot with the script's obstacles
+        */
+        void _buildCodeTransitions();
+
+        /**
+         * @brief recompose the block transition of a node from its codes
+        */
+        void _updateBlock(Node& _node) const;
+
+        /**
+         * @brief recompose the count and total transition of a node from its block and children
+        */
+        static void _updateTotal(Node& _node);
+
+        /**
+         * @brief recompose every block and total, bottom up
+        */
+        void _updateAll(Node* _node);
+
+        /**
+         * @brief split a tree before the block starting at command _count, which must be a block boundary
+        */
+        static void _split(std::unique_ptr<Node> _node, const uint64_t _count, std::unique_ptr<Node>& _left,
+            std::unique_ptr<Node>& _right);
+        static std::unique_ptr<Node> _merge(std::unique_ptr<Node> _left, std::unique_ptr<Node> _right);
+
+        /**
+         * @brief find the block holding command _index, recompose the path down to it on the way back up
+         * @param _change changes the block codes at the offset of _index in the block
+         * @param _splitOffset set to the command offset of the block if it reached BLOCK_LIMIT and must be split
+        */
+        template <typename F>
+        void _edit(std::unique_ptr<Node>& _node, uint64_t _index, F&& _change, uint64_t _offset, uint64_t& _splitOffset);
+
+        /**
+         * @brief split an overfull block starting at command _offset into two nodes
+        */
+        void _splitBlock(const uint64_t _offset);
+
+        /**
+         * @brief rebuild the code transitions and every node when the obstacles have changed
+        */
+        void _refresh();
+
+    public:
+        /**
+         * @param _obstacleMap obstacles the script runs against, not owned. changes to it are picked up by the next
+         *        call, which then recomposes the whole script once
+        */
+        explicit EditableScript(const ObstacleMap* _obstacleMap = nullptr);
+
+        /**
+         * @brief replace the whole script, O(n)
+         * @return false, leaving the script unchanged, if a command depends on history
+        */
+        bool assign(std::span<const type::Command> _commands);
+
+        /**
+         * @brief insert a command so it becomes command _index, _index == size() appends
+         * @return false if _index is past the end or the command depends on history
+        */
+        bool insert(const uint64_t _index, const type::Command& _command);
+
+        /**
+         * @brief overwrite command _index
+         * @return false if _index is past the end or the command depends on history
+        */
+        bool replace(const uint64_t _index, const type::Command& _command);
+
+        /**
+         * @brief remove command _index
+         * @return false if _index is past the end
+        */
+        bool erase(const uint64_t _index);
+
+        /**
+         * @brief state after the first _count commands run from _start, _count past the end is the final state
+        */
+        ToyRobot::Snapshot stateAt(uint64_t _count, const ToyRobot::Snapshot& _start = ToyRobot::Snapshot());
+
+        /**
+         * @brief state after the whole script run from _start
+        */
+        ToyRobot::Snapshot finalState(const ToyRobot::Snapshot& _start = ToyRobot::Snapshot());
+
+        uint64_t size() const { return m_root ? m_root->m_count : 0; };
+    };
+}
+
+#endif  // EDITABLE_SCRIPT_H
@@ -0,0 +1,258 @@
+#include "Engine.h"
+#include "StaticRobot.h"
+#include <map>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace object
+{
+    namespace
+    {
+        /**
+         * ToyRobot::proccessInput, the behaviour every engine is checked against
+        */
+        class ReferenceEngine : public Engine
+        {
+        protected:
+            ToyRobot& m_robot;
+
+        public:
+            explicit ReferenceEngine(ToyRobot& _robot) : m_robot(_robot) {};
+
+            virtual const char* getName() const override { return "reference"; };
+            virtual void run(std::string_view _input) override { m_robot.proccessInput(std::string(_input)); };
+            virtual ToyRobot::Snapshot snapshot() const override { return m_robot.snapshot(); };
+            virtual void restore(const ToyRobot::Snapshot& _snapshot) override { m_robot.restore(_snapshot); };
+            virtual void setReportCallback(std::function<void(const std::string&)> _callback) override
+            {
+                m_robot.setReportCallback(std::move(_callback));
+            };
+        };
+
+        /**
+         * parseCommand and execute, no string copy or action map lookup per command
+        */
+        class ParsedEngine : public ReferenceEngine
+        {
+        public:
+            explicit ParsedEngine(ToyRobot& _robot) : ReferenceEngine(_robot) {};
+
+            virtual const char* getName() const override { return "parsed"; };
+            virtual void run(std::string_view _input) override
+            {
+                type::Command command;
+                if(InputHandler::parseCommand(_input, command))
+                    m_robot.execute(command);
+                // DEFINE and CALL have no Command form
+                else if(_input.starts_with("DEFINE ") || _input.starts_with("CALL "))
+                    ReferenceEngine::run(_input);
+            };
+        };
+
+        /**
+         * StaticRobot of the default table, no obstacles, history or macros
+        */
+        class StaticEngine : public Engine
+        {
+            typedef StaticRobot<TABLE_TOP_X, TABLE_TOP_Y> Robot;
+            Robot m_robot;
+            std::function<void(const std::string&)> m_reportCallback;
+
+        public:
+            virtual const char* getName() const override { return "static"; };
+            virtual void run(std::string_view _input) override { m_robot.proccessInput(_input); };
+            virtual ToyRobot::Snapshot snapshot() const override
+            {
+                ToyRobot::Snapshot snapshot;
+                snapshot.m_hasBeenPlaced = m_robot.isPlaced();
+                if(!snapshot.m_hasBeenPlaced)
+                    return snapshot;
+                const auto position = m_robot.getTransform().getPosition();
+                snapshot.m_transform.setPosition(type::T_Position<uint8_t>(uint8_t(position.x), uint8_t(position.y)));
+                snapshot.m_transform.setRotation(m_robot.getTransform().getRotation());
+                return snapshot;
+            };
+            virtual void restore(const ToyRobot::Snapshot& _snapshot) override
+            {
+                // a new robot is unplaced
+                m_robot = Robot();
+                m_robot.setReportCallback(m_reportCallback);
+                const auto position = _snapshot.m_transform.getPosition();
+                if(_snapshot.m_hasBeenPlaced)
+                    m_robot.placeHere(position.x, position.y, _snapshot.m_transform.getRotation());
+            };
+            virtual void setReportCallback(std::function<void(const std::string&)> _callback) override
+            {
+                m_reportCallback = std::move(_callback);
+                m_robot.setReportCallback(m_reportCallback);
+            };
+        };
+
+        struct Registry
+        {
+            std::mutex m_mutex;
+            std::map<std::string, EngineRegistry::Factory> m_factories;
+        };
+
+        Registry& _registry()
+        {
+            static Registry registry;
+            // built in engines, added once on first use
+            static const bool isBuilt = []()
+            {
+                registry.m_factories.emplace("reference", [](ToyRobot& _robot){ return std::make_unique<ReferenceEngine>(_robot); });
+                registry.m_factories.emplace("parsed", [](ToyRobot& _robot){ return std::make_unique<ParsedEngine>(_robot); });
+                registry.m_factories.emplace("static", [](ToyRobot&){ return std::make_unique<StaticEngine>(); });
+                return true;
+            }();
+            (void)isBuilt;
+            return registry;
+        }
+
+        /**
+         * @brief commands whose result depends on more than a snapshot
+        */
+        bool _dependsOnHistory(std::string_view _input)
+        {
+            return _input.starts_with("UNDO") || _input.starts_with("REDO") || _input.starts_with("DEFINE")
+                || _input.starts_with("CALL");
+        }
+
+        bool _isSameState(const ToyRobot::Snapshot& _a, const ToyRobot::Snapshot& _b)
+        {
+            if(_a.m_hasBeenPlaced != _b.m_hasBeenPlaced)
+                return false;
+            if(!_a.m_hasBeenPlaced)
+                return true;
+            const auto positionA = _a.m_transform.getPosition();
+            const auto positionB = _b.m_transform.getPosition();
+            return positionA.x == positionB.x && positionA.y == positionB.y
+                && _a.m_transform.getRotation() == _b.m_transform.getRotation();
+        }
+
+        std::string _describe(const ToyRobot::Snapshot& _state)
+        {
+            if(!_state.m_hasBeenPlaced)
+                return "unplaced";
+            const auto position = _state.m_transform.getPosition();
+            return std::to_string(position.x) + "," + std::to_string(position.y) + ","
+                + type::headingMap.at(_state.m_transform.getRotation());
+        }
+    }
+
+    EngineConfig EngineConfig::fromEnvironment()
+    {
+        EngineConfig config;
+        const char* engine = getenv("TOYROBOT_ENGINE");
+        const char* sample = getenv("TOYROBOT_SHADOW_SAMPLE");
+        if(engine != nullptr && engine[0] != '\0')
+            config.m_engine = engine;
+        if(sample != nullptr)
+            config.m_shadowSample = uint32_t(strtoul(sample, nullptr, 10));
+        return config;
+    }
+
+    void ShadowEngine::ShadowStats::print(const char* _engine) const
+    {
+        printf("\nSHADOW: %s engine, %lu commands, %lu checked against reference, %lu not checkable, %lu divergences\n",
+            _engine, (unsigned long)m_commands, (unsigned long)m_sampled, (unsigned long)m_skipped,
+            (unsigned long)m_divergences);
+    }
+
+    ShadowEngine::ShadowEngine(std::unique_ptr<Engine> _engine, const ObstacleMap* _obstacleMap, const uint32_t _sample,
+        const uint32_t _printLimit)
+        :   m_engine(std::move(_engine)),
+            m_sample(_sample),
+            m_printLimit(_printLimit),
+            m_countdown(_sample)
+    {
+        m_reference.setObstacleMap(_obstacleMap);
+        m_reference.setReportCallback([this](const std::string& _report){ m_referenceReport.append(_report).push_back('\n'); });
+        // see the engine's reports of sampled commands, then pass them on
+        m_engine->setReportCallback([this](const std::string& _report)
+        {
+            if(m_isSampling)
+                m_engineReport.append(_report).push_back('\n');
+            if(m_reportCallback)
+                m_reportCallback(_report);
+            else
+                printf( "Output : %s\n" ,_report.c_str());
+        });
+    }
+
+    void ShadowEngine::run(std::string_view _input)
+    {
+        ++m_stats.m_commands;
+        if(m_sample == 0 || --m_countdown != 0)
+        {
+            m_engine->run(_input);
+            return;
+        }
+        m_countdown = m_sample;
+        if(_dependsOnHistory(_input))
+        {
+            ++m_stats.m_skipped;
+            m_engine->run(_input);
+            return;
+        }
+        ++m_stats.m_sampled;
+        const ToyRobot::Snapshot before = m_engine->snapshot();
+        m_engineReport.clear();
+        m_referenceReport.clear();
+        m_isSampling = true;
+        m_engine->run(_input);
+        m_isSampling = false;
+        m_reference.restore(before);
+        m_reference.proccessInput(std::string(_input));
+        const ToyRobot::Snapshot after = m_engine->snapshot();
+        const ToyRobot::Snapshot expected = m_reference.snapshot();
+        if(_isSameState(after, expected) && m_engineReport == m_referenceReport)
+            return;
+        if(++m_stats.m_divergences <= m_printLimit)
+            printf("SHADOW: %s engine diverged on \"%.*s\" from %s: %s, reference %s\n", getName(), int(_input.size()),
+                _input.data(), _describe(before).c_str(), _describe(after).c_str(), _describe(expected).c_str());
+    }
+
+    void EngineRegistry::add(const std::string& _name, Factory _factory)
+    {
+        Registry& registry = _registry();
+        std::lock_guard<std::mutex> lock(registry.m_mutex);
+        registry.m_factories[_name] = std::move(_factory);
+    }
+
+    std::vector<std::string> EngineRegistry::names()
+    {
+        Registry& registry = _registry();
+        std::lock_guard<std::mutex> lock(registry.m_mutex);
+        std::vector<std::string> names;
+        for(const auto& factory : registry.m_factories)
+            names.push_back(factory.first);
+        return names;
+    }
+
+    std::unique_ptr<Engine> EngineRegistry::create(const EngineConfig& _config, ToyRobot& _robot)
+    {
+        Factory factory;
+        {
+            Registry& registry = _registry();
+            std::lock_guard<std::mutex> lock(registry.m_mutex);
+            auto itr = registry.m_factories.find(_config.m_engine);
+            if(itr != registry.m_factories.end())
+                factory = itr->second;
+        }
+        if(!factory)
+        {
+            printf("ENGINE: unknown engine %s, registered:", _config.m_engine.c_str());
+            for(const std::string& name : names())
+                printf(" %s", name.c_str());
+            printf("\n");
+            return nullptr;
+        }
+        std::unique_ptr<Engine> engine = factory(_robot);
+        if(_config.m_shadowSample == 0)
+            return engine;
+        return std::make_unique<ShadowEngine>(std::move(engine), _robot.getObstacleMap(), _config.m_shadowSample,
+            _config.m_shadowPrintLimit);
+    }
+}
@@ -0,0 +1,156 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "Objects.h"
+#include <functional>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace object
+{
+
+    /**
+     * One way of running string commands on a robot
+     * @brief   every engine must behave like ToyRobot::proccessInput, the "reference" engine, for the commands
+     *          it supports. engines are created by name through EngineRegistry
+    */
+    class Engine
+    {
+    public:
+        virtual ~Engine(){};
+
+        /**
+         * @brief name the engine is registered under
+        */
+        virtual const char* getName() const = 0;
+
+        /**
+         * @brief run one command string
+        */
+        virtual void run(std::string_view _input) = 0;
+
+        /**
+         * @brief copy and overwrite the robot state, used to check single commands against another engine
+        */
+        virtual ToyRobot::Snapshot snapshot() const = 0;
+        virtual void restore(const ToyRobot::Snapshot& _snapshot) = 0;
+
+        /**
+         * @brief REPORT output handler, printf is used when empty
+        */
+        virtual void setReportCallback(std::function<void(const std::string&)> _callback) = 0;
+    };
+
+    /**
+     * Engine selection, read from TOYROBOT_ENGINE and TOYROBOT_SHADOW_SAMPLE or set by the --engine= and --shadow=
+     * command line flags
+    */
+    struct EngineConfig
+    {
+        /// registered engine name
+        std::string m_engine = "reference";
+        /// one command in m_shadowSample is also run on the reference engine and compared, 0 disables shadowing
+        uint32_t m_shadowSample = 0;
+        /// divergences printed before only counting them
+        uint32_t m_shadowPrintLimit = 10;
+
+        /**
+         * @brief config from the environment, defaults where a variable is not set
+        */
+        static EngineConfig fromEnvironment();
+    };
+
+    /**
+     * Runs commands on an engine and checks a sample of them against the reference engine
+     * @brief   before a sampled command the state of the engine is restored into a private reference robot, the
+     *          command runs on both and the resulting states and REPORT output are compared. UNDO, REDO, DEFINE
+     *          and CALL depend on history and macros a snapshot does not carry, so they are never sampled
+    */
+    class ShadowEngine : public Engine
+    {
+    public:
+        struct ShadowStats
+        {
+            uint64_t m_commands = 0;
+            uint64_t m_sampled = 0;
+            /// sample slots that fell on a command depending on history or macros
+            uint64_t m_skipped = 0;
+            uint64_t m_divergences = 0;
+
+            /**
+             * @brief print sampled and divergent counts
+            */
+            void print(const char* _engine) const;
+        };
+
+    private:
+        std::unique_ptr<Engine> m_engine;
+        ToyRobot m_reference;
+        const uint32_t m_sample;
+        const uint32_t m_printLimit;
+        /// commands until the next sample
+        uint32_t m_countdown;
+        ShadowStats m_stats;
+        std::function<void(const std::string&)> m_reportCallback;
+        /// REPORT output of the sampled command from each side
+        bool m_isSampling = false;
+        std::string m_engineReport;
+        std::string m_referenceReport;
+
+    public:
+        /**
+         * @param _engine engine to run and check
+         * @param _obstacleMap obstacles of the robot the engine runs on, the reference robot uses them too
+         * @param _sample one command in _sample is checked, 0 checks none
+         * @param _printLimit divergences printed before only counting them
+        */
+        ShadowEngine(std::unique_ptr<Engine> _engine, const ObstacleMap* _obstacleMap, const uint32_t _sample,
+            const uint32_t _printLimit = 10);
+
+        virtual const char* getName() const override { return m_engine->getName(); };
+        virtual void run(std::string_view _input) override;
+        virtual ToyRobot::Snapshot snapshot() const override { return m_engine->snapshot(); };
+        virtual void restore(const ToyRobot::Snapshot& _snapshot) override { m_engine->restore(_snapshot); };
+        virtual void setReportCallback(std::function<void(const std::string&)> _callback) override
+        {
+            m_reportCallback = std::move(_callback);
+        };
+
+        const ShadowStats& getStats() const { return m_stats; };
+    };
+
+    /**
+     * Engines by name
+     * @brief   "reference" runs ToyRobot::proccessInput, "parsed" runs InputHandler::parseCommand and
+     *          ToyRobot::execute, "static" runs a StaticRobot of the default table without obstacles, history or
+     *          macros. more engines can be added at start up
+    */
+    class EngineRegistry
+    {
+    public:
+        /// builds an engine on a robot, engines without a ToyRobot only copy its settings
+        typedef std::function<std::unique_ptr<Engine>(ToyRobot& _robot)> Factory;
+
+        /**
+         * @brief add or replace an engine
+        */
+        static void add(const std::string& _name, Factory _factory);
+
+        /**
+         * @brief registered names, sorted
+        */
+        static std::vector<std::string> names();
+
+        /**
+         * @brief build the configured engine, wrapped in a ShadowEngine when shadowing is enabled
+         * @param _robot robot the engine runs on
+         * @return nullptr if no engine has the configured name
+        */
+        static std::unique_ptr<Engine> create(const EngineConfig& _config, ToyRobot& _robot);
+    };
+}
+
+#endif  // ENGINE_H
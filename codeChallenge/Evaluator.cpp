@@ -0,0 +1,37 @@
+#include "Evaluator.h"
+#include "Parallel.h"
+#include <algorithm>
+
+namespace object
+{
+    namespace
+    {
+        const std::function<void(const std::string&)> s_ignoreReport = [](const std::string&){};
+    }
+
+    std::vector<std::string> ParallelEvaluator::evaluate(const ToyRobot& _origin, const std::vector<std::vector<std::string>>& _candidates)
+    {
+        // one robot per worker thread, grown once and reused by later evaluations
+        const size_t workerCount = std::min<size_t>(std::max<size_t>(1, _candidates.size()),
+            m_threadCount != 0 ? m_threadCount : defaultThreadCount());
+        while(m_workers.size() < workerCount)
+            m_workers.push_back(std::make_unique<ToyRobot>());
+        const ToyRobot::Snapshot snapshot = _origin.snapshot();
+        std::vector<std::string> reports(_candidates.size());
+        parallelFor(_candidates.size(), unsigned(workerCount), [&](const size_t _index, const unsigned _worker)
+        {
+            // fork, the worker ran other candidates before so drop their macros too
+            ToyRobot& robot = *m_workers[_worker];
+            robot.reset();
+            robot.setReportCallback(s_ignoreReport);
+            robot.restore(snapshot);
+            robot.setObstacleMap(_origin.getObstacleMap());
+            // run candidate
+            for(const std::string& command : _candidates[_index])
+                robot.proccessInput(command);
+            if(robot.isPlaced())
+                reports[_index] = robot.getReport();
+        });
+        return reports;
+    }
+}
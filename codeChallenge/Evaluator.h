@@ -0,0 +1,40 @@
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include "Objects.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace object
+{
+
+    /**
+     * Parallel what-if evaluation of candidate scripts
+     * @brief   every candidate runs on its own fork of a starting robot. each worker thread owns one robot that is
+     *          built once and reused, every candidate only restores a Snapshot into it, so a fork costs the size
+     *          of the robot state and never rebuilds an action map
+    */
+    class ParallelEvaluator
+    {
+        /// reusable worker robots, one per worker thread
+        std::vector<std::unique_ptr<ToyRobot>> m_workers;
+        /// amount of threads to use, 0 for all cores
+        const unsigned m_threadCount;
+
+    public:
+        ParallelEvaluator(const unsigned _threadCount = 0)
+            :   m_threadCount(_threadCount)
+        {};
+
+        /**
+         * @brief run every candidate script from the state of a robot
+         * @param _origin robot to fork, it is not modified
+         * @param _candidates command scripts, one per candidate
+         * @return final getReport() of each candidate in candidate order, empty if the fork never got placed
+        */
+        std::vector<std::string> evaluate(const ToyRobot& _origin, const std::vector<std::vector<std::string>>& _candidates);
+    };
+}
+
+#endif  // EVALUATOR_H
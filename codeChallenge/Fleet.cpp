@@ -0,0 +1,370 @@
+#include "Fleet.h"
+#include "SpatialIndex.h"
+#include "Geofence.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace object
+{
+    namespace
+    {
+        /// first bytes of a mapped fleet file, bump FLEET_VERSION whenever the layout changes
+        const char FLEET_MAGIC[8] = { 'T', 'R', 'F', 'L', 'E', 'E', 'T', '\0' };
+        const uint32_t FLEET_VERSION = 1;
+        /// slots a new file starts with
+        const size_t FLEET_INITIAL_CAPACITY = 1024;
+
+        /**
+         * mapped fleet file layout: this header, then m_capacity transforms, then m_capacity placed flags
+        */
+        struct FleetFileHeader
+        {
+            char m_magic[8];
+            uint32_t m_version;
+            /// sizeof(Fleet::Transform) of the writer
+            uint32_t m_transformBytes;
+            uint32_t m_axisX;
+            uint32_t m_axisY;
+            uint64_t m_size;
+            uint64_t m_capacity;
+            uint8_t m_reserved[24];
+        };
+        static_assert(sizeof(FleetFileHeader) == 64, "fleet file header layout changed, bump FLEET_VERSION");
+
+        size_t _fileBytes(const uint64_t _capacity)
+        {
+            return sizeof(FleetFileHeader) + size_t(_capacity) * (sizeof(Fleet::Transform) + 1);
+        }
+    }
+
+    struct Fleet::Mapping
+    {
+        int m_file = -1;
+        void* m_data = nullptr;
+        size_t m_bytes = 0;
+        SYNC m_sync = SYNC::ON_CLOSE;
+        uint64_t m_syncEvery = 0;
+
+        ~Mapping()
+        {
+            if(m_data != nullptr)
+                munmap(m_data, m_bytes);
+            if(m_file >= 0)
+                close(m_file);
+        }
+
+        bool map(const size_t _bytes)
+        {
+            void* data = mmap(nullptr, _bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+            if(data == MAP_FAILED)
+                return false;
+            m_data = data;
+            m_bytes = _bytes;
+            return true;
+        }
+
+        FleetFileHeader& header() const { return *static_cast<FleetFileHeader*>(m_data); }
+        Transform* transforms() const
+        {
+            return reinterpret_cast<Transform*>(static_cast<uint8_t*>(m_data) + sizeof(FleetFileHeader));
+        }
+        uint8_t* placed() const { return placed(header().m_capacity); }
+        /**
+         * @brief placed flags of a file holding _capacity robots, they follow the transform array
+        */
+        uint8_t* placed(const uint64_t _capacity) const
+        {
+            return static_cast<uint8_t*>(m_data) + sizeof(FleetFileHeader) + size_t(_capacity) * sizeof(Transform);
+        }
+    };
+
+    Fleet::Fleet(const unsigned _x, const unsigned _y)
+        :   m_axisX(_x < MAX_EXTENT ? _x : MAX_EXTENT),
+            m_axisY(_y < MAX_EXTENT ? _y : MAX_EXTENT)
+    {}
+
+    Fleet::~Fleet()
+    {
+        if(m_mapping != nullptr && m_mapping->m_sync != SYNC::NONE)
+            sync();
+    }
+
+    std::unique_ptr<Fleet> Fleet::openMapped(const std::string& _path, const unsigned _x, const unsigned _y,
+        const SYNC _sync, const uint64_t _syncEvery)
+    {
+        auto mapping = std::make_unique<Mapping>();
+        mapping->m_file = open(_path.c_str(), O_RDWR | O_CREAT, 0644);
+        struct stat status;
+        if(mapping->m_file < 0 || fstat(mapping->m_file, &status) != 0)
+        {
+            printf("FLEET: could not open %s\n", _path.c_str());
+            return nullptr;
+        }
+        if(status.st_size == 0)
+        {
+            // new file, write an empty fleet
+            if(ftruncate(mapping->m_file, off_t(_fileBytes(FLEET_INITIAL_CAPACITY))) != 0
+                || !mapping->map(_fileBytes(FLEET_INITIAL_CAPACITY)))
+            {
+                printf("FLEET: could not create %s\n", _path.c_str());
+                return nullptr;
+            }
+            FleetFileHeader& header = mapping->header();
+            memcpy(header.m_magic, FLEET_MAGIC, sizeof(FLEET_MAGIC));
+            header.m_version = FLEET_VERSION;
+            header.m_transformBytes = uint32_t(sizeof(Transform));
+            header.m_axisX = _x < MAX_EXTENT ? _x : MAX_EXTENT;
+            header.m_axisY = _y < MAX_EXTENT ? _y : MAX_EXTENT;
+            header.m_size = 0;
+            header.m_capacity = FLEET_INITIAL_CAPACITY;
+        }
+        else
+        {
+            if(size_t(status.st_size) < sizeof(FleetFileHeader) || !mapping->map(size_t(status.st_size)))
+            {
+                printf("FLEET: could not map %s\n", _path.c_str());
+                return nullptr;
+            }
+            const FleetFileHeader& header = mapping->header();
+            if(memcmp(header.m_magic, FLEET_MAGIC, sizeof(FLEET_MAGIC)) != 0 || header.m_version != FLEET_VERSION
+                || header.m_transformBytes != sizeof(Transform) || header.m_size > header.m_capacity
+                || header.m_axisX > MAX_EXTENT || header.m_axisY > MAX_EXTENT
+                || _fileBytes(header.m_capacity) > size_t(status.st_size))
+            {
+                printf("FLEET: %s is not a version %u fleet file\n", _path.c_str(), FLEET_VERSION);
+                return nullptr;
+            }
+        }
+        mapping->m_sync = _sync;
+        mapping->m_syncEvery = _sync == SYNC::PERIODIC ? std::max<uint64_t>(1, _syncEvery) : 0;
+
+        auto fleet = std::make_unique<Fleet>(mapping->header().m_axisX, mapping->header().m_axisY);
+        fleet->m_transforms = mapping->transforms();
+        fleet->m_placed = mapping->placed();
+        fleet->m_size = size_t(mapping->header().m_size);
+        fleet->m_syncCountdown = mapping->m_syncEvery;
+        fleet->m_mapping = std::move(mapping);
+        return fleet;
+    }
+
+    bool Fleet::sync()
+    {
+        if(m_mapping == nullptr)
+            return true;
+        return msync(m_mapping->m_data, m_mapping->m_bytes, MS_SYNC) == 0;
+    }
+
+    void Fleet::_periodicSync()
+    {
+        // start writing back without waiting for it
+        msync(m_mapping->m_data, m_mapping->m_bytes, MS_ASYNC);
+        m_syncCountdown = m_mapping->m_syncEvery;
+    }
+
+    void Fleet::_grow(const size_t _capacity)
+    {
+        if(m_mapping == nullptr)
+        {
+            m_heapTransforms.reserve(_capacity);
+            m_heapPlaced.reserve(_capacity);
+            m_transforms = m_heapTransforms.data();
+            m_placed = m_heapPlaced.data();
+            return;
+        }
+        const uint64_t capacity = m_mapping->header().m_capacity;
+        if(_capacity <= capacity)
+            return;
+        const size_t bytes = _fileBytes(_capacity);
+        if(ftruncate(m_mapping->m_file, off_t(bytes)) != 0)
+            throw std::bad_alloc();
+        munmap(m_mapping->m_data, m_mapping->m_bytes);
+        m_mapping->m_data = nullptr;
+        m_transforms = nullptr;
+        m_placed = nullptr;
+        if(!m_mapping->map(bytes))
+            throw std::bad_alloc();
+        // the placed flags follow the transforms, copy them behind the larger transform array first and only then
+        // publish the capacity, so a crash in between leaves the old flags in place and the file valid
+        memmove(m_mapping->placed(_capacity), m_mapping->placed(), m_size);
+        m_mapping->header().m_capacity = _capacity;
+        m_transforms = m_mapping->transforms();
+        m_placed = m_mapping->placed();
+    }
+
+    uint32_t Fleet::addRobot()
+    {
+        if(m_mapping == nullptr)
+        {
+            m_heapTransforms.emplace_back();
+            m_heapPlaced.push_back(0);
+            m_transforms = m_heapTransforms.data();
+            m_placed = m_heapPlaced.data();
+        }
+        else
+        {
+            const uint64_t capacity = m_mapping->header().m_capacity;
+            if(m_size == capacity)
+                _grow(size_t(capacity) * 2);
+            m_transforms[m_size] = Transform();
+            m_placed[m_size] = 0;
+            // publish the slot once it is written
+            m_mapping->header().m_size = m_size + 1;
+            _onWrite();
+        }
+        return uint32_t(m_size++);
+    }
+
+    void Fleet::reserve(const size_t _count)
+    {
+        _grow(_count);
+    }
+
+    bool Fleet::placeHere(const uint32_t _robot, const uint32_t _x, const uint32_t _y, const type::HEADING _rotation)
+    {
+        // check validity of arguments
+        if(!_validateCell(_x, _y) || _rotation == type::HEADING::UNDEFINED)
+            return false;
+        Transform& transform = m_transforms[_robot];
+        transform.setRotation(_rotation);
+        transform.setPosition(type::T_Position<uint32_t>(_x, _y));
+        m_placed[_robot] = 1;
+        _onWrite();
+        if(m_spatialIndex != nullptr)
+            m_spatialIndex->update(_robot, _x, _y);
+        if(m_geofenceMonitor != nullptr)
+            m_geofenceMonitor->update(_robot, _x, _y);
+        return true;
+    }
+
+    bool Fleet::move(const uint32_t _robot)
+    {
+        // check if the robot is on the table top
+        if(!m_placed[_robot])
+            return false;
+        Transform& transform = m_transforms[_robot];
+        const auto position = transform.getPosition();
+        // widen so stepping off either edge can be detected
+        int64_t x = position.x;
+        int64_t y = position.y;
+        switch (transform.getRotation())
+        {
+        case type::HEADING::NORTH:  ++y; break;
+        case type::HEADING::SOUTH:  --y; break;
+        case type::HEADING::EAST:   ++x; break;
+        case type::HEADING::WEST:   --x; break;
+        default:                    return false;
+        }
+        if(x < 0 || y < 0 || !_validateCell(uint32_t(x), uint32_t(y)))
+            return false;
+        transform.setPosition(type::T_Position<uint32_t>(uint32_t(x), uint32_t(y)));
+        _onWrite();
+        if(m_spatialIndex != nullptr)
+            m_spatialIndex->update(_robot, uint32_t(x), uint32_t(y));
+        if(m_geofenceMonitor != nullptr)
+            m_geofenceMonitor->update(_robot, uint32_t(x), uint32_t(y));
+        return true;
+    }
+
+    bool Fleet::rotateLeft(const uint32_t _robot)
+    {
+        if(!m_placed[_robot])
+            return false;
+        Transform& transform = m_transforms[_robot];
+        // headings are ordered clockwise, so -1 wraps to +3
+        transform.setRotation(type::HEADING((transform.getRotation() + 3) & 0b11));
+        _onWrite();
+        return true;
+    }
+
+    bool Fleet::rotateRight(const uint32_t _robot)
+    {
+        if(!m_placed[_robot])
+            return false;
+        Transform& transform = m_transforms[_robot];
+        transform.setRotation(type::HEADING((transform.getRotation() + 1) & 0b11));
+        _onWrite();
+        return true;
+    }
+
+    void Fleet::setState(const uint32_t _robot, const Transform& _transform, const bool _isPlaced)
+    {
+        m_transforms[_robot] = _transform;
+        m_placed[_robot] = _isPlaced;
+        _onWrite();
+        const auto position = _transform.getPosition();
+        if(m_geofenceMonitor != nullptr)
+        {
+            if(_isPlaced)
+                m_geofenceMonitor->update(_robot, position.x, position.y);
+            else
+                m_geofenceMonitor->remove(_robot);
+        }
+        if(m_spatialIndex == nullptr)
+            return;
+        if(!_isPlaced)
+        {
+            m_spatialIndex->remove(_robot);
+            return;
+        }
+        m_spatialIndex->update(_robot, position.x, position.y);
+    }
+
+    std::string Fleet::getReport(const uint32_t _robot) const
+    {
+        // build a sting for the position and rotation
+        std::string result;
+        const auto position = getPosition(_robot);
+        result.append(std::to_string(position.x)).append(",");
+        result.append(std::to_string(position.y)).append(",");
+        result.append(type::headingMap.at(getRotation(_robot)));
+        return result;
+    }
+
+    std::unique_ptr<Fleet> Fleet::fork() const
+    {
+        auto fleet = std::make_unique<Fleet>(m_axisX, m_axisY);
+        fleet->m_heapTransforms.assign(m_transforms, m_transforms + m_size);
+        fleet->m_heapPlaced.assign(m_placed, m_placed + m_size);
+        fleet->m_transforms = fleet->m_heapTransforms.data();
+        fleet->m_placed = fleet->m_heapPlaced.data();
+        fleet->m_size = m_size;
+        fleet->m_obstacleMap = m_obstacleMap;
+        return fleet;
+    }
+
+    void Fleet::setSpatialIndex(SpatialIndex* _spatialIndex)
+    {
+        m_spatialIndex = _spatialIndex;
+        if(m_spatialIndex == nullptr)
+            return;
+        // bring the index up to date with robots placed so far
+        for(uint32_t robot = 0; robot < m_size; ++robot)
+        {
+            if(!m_placed[robot])
+                continue;
+            const auto position = getPosition(robot);
+            m_spatialIndex->update(robot, position.x, position.y);
+        }
+    }
+
+    void Fleet::setGeofenceMonitor(GeofenceMonitor* _geofenceMonitor)
+    {
+        m_geofenceMonitor = _geofenceMonitor;
+        if(m_geofenceMonitor == nullptr)
+            return;
+        // robots placed so far enter the zones they are in
+        for(uint32_t robot = 0; robot < m_size; ++robot)
+        {
+            if(!m_placed[robot])
+                continue;
+            const auto position = getPosition(robot);
+            m_geofenceMonitor->update(robot, position.x, position.y);
+        }
+    }
+}
@@ -0,0 +1,227 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include "Types.h"
+#include "Obstacles.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace object
+{
+    class SpatialIndex;
+    class GeofenceMonitor;
+
+    /**
+     * Compact fleet of robots sharing one table top
+     * @brief   a ToyRobot carries its own action map, which is too heavy for millions of robots.
+     *          a fleet stores each robot as a 32 bit transform plus a placed flag and addresses it by slot.
+     *          the 32 bit transform gives 15 bits per axis, so tables up to 32767x32767 are supported.
+     *          state is held on the heap, or in a file mapped with openMapped() so it survives restarts
+    */
+    class Fleet
+    {
+    public:
+        typedef type::T_Transform<uint32_t> Transform;
+        /// largest axis value a 32 bit transform can hold
+        static constexpr unsigned MAX_EXTENT = 32767;
+
+        /// when a mapped fleet flushes its file
+        enum class SYNC : uint8_t
+        {
+            /// only when the kernel decides, the file survives a crash of the process but not of the machine
+            NONE     = 0,
+            /// blocking msync when the fleet is destroyed or sync() is called
+            ON_CLOSE = 1,
+            /// asynchronous msync every m_syncEvery writes, and blocking on close
+            PERIODIC = 2
+        };
+
+    private:
+        /// file backing a mapped fleet, defined in Fleet.cpp
+        struct Mapping;
+
+        /// extents of the table, inclusive like TABLE_TOP_X
+        const unsigned m_axisX;
+        const unsigned m_axisY;
+        /// robot position and rotation per slot, points into m_heapTransforms or the mapping
+        Transform* m_transforms = nullptr;
+        /// flag identying if the robot in a slot has been placed, points into m_heapPlaced or the mapping
+        uint8_t* m_placed = nullptr;
+        size_t m_size = 0;
+        /// storage of a fleet that is not mapped
+        std::vector<Transform> m_heapTransforms;
+        std::vector<uint8_t> m_heapPlaced;
+        /// file backing the state, nullptr for a heap fleet
+        std::unique_ptr<Mapping> m_mapping;
+        /// writes left until the next periodic sync, 0 when not syncing periodically
+        uint64_t m_syncCountdown = 0;
+        /// optional static obstacles, not owned
+        const ObstacleMap* m_obstacleMap = nullptr;
+        /// optional spatial index kept up to date on PLACE and MOVE, not owned
+        SpatialIndex* m_spatialIndex = nullptr;
+        /// optional geofence monitor told about PLACE and MOVE, not owned
+        GeofenceMonitor* m_geofenceMonitor = nullptr;
+
+        /**
+         * @brief check a cell against table extents and obstacles
+        */
+        bool _validateCell(const uint32_t _x, const uint32_t _y) const
+        {
+            return (_x <= m_axisX) && (_y <= m_axisY)
+                && ((m_obstacleMap == nullptr) || !m_obstacleMap->isBlocked(_x, _y));
+        }
+
+        /**
+         * @brief count a state change towards the next periodic sync
+        */
+        void _onWrite()
+        {
+            if(m_syncCountdown != 0 && --m_syncCountdown == 0)
+                _periodicSync();
+        }
+        void _periodicSync();
+
+        /**
+         * @brief make room for at least _capacity robots
+        */
+        void _grow(const size_t _capacity);
+
+    public:
+        Fleet(const unsigned _x, const unsigned _y);
+        Fleet(const Fleet&) = delete;
+        void operator=(const Fleet&) = delete;
+        ~Fleet();
+
+        /**
+         * @brief open a fleet whose state lives in a memory mapped file, changes are written straight to the file
+         * @brief an existing file is mapped as it is, without reading or replaying anything, and its extents
+         *        are used instead of _x and _y. a missing or empty file starts an empty fleet
+         * @param _path file holding the fleet
+         * @param _x x extent of a new fleet
+         * @param _y y extent of a new fleet
+         * @param _sync when changes are flushed to the file
+         * @param _syncEvery writes between flushes for SYNC::PERIODIC
+         * @return the fleet, nullptr if the file could not be mapped or is not a fleet of this version
+        */
+        static std::unique_ptr<Fleet> openMapped(const std::string& _path, const unsigned _x, const unsigned _y,
+            const SYNC _sync = SYNC::ON_CLOSE, const uint64_t _syncEvery = 1 << 20);
+
+        /**
+         * @brief blocking flush of a mapped fleet, does nothing for a heap fleet
+         * @return false if msync failed
+        */
+        bool sync();
+
+        /**
+         * @brief check if the state lives in a mapped file
+        */
+        bool isMapped() const { return m_mapping != nullptr; };
+
+        /**
+         * @brief add an unplaced robot
+         * @return slot of the new robot
+        */
+        uint32_t addRobot();
+
+        /**
+         * @brief pre allocate storage for a known fleet size
+        */
+        void reserve(const size_t _count);
+
+        /**
+         * @brief amount of robots in the fleet
+        */
+        size_t size() const { return m_size; };
+
+        /**
+         * @brief accessors for X and Y boundries
+        */
+        const unsigned& getExtentX() const { return m_axisX; };
+        const unsigned& getExtentY() const { return m_axisY; };
+
+        /**
+         * @brief check if a PLACE onto a cell would be accepted, inside the table and not on an obstacle
+        */
+        bool isPlaceable(const uint32_t _x, const uint32_t _y, const type::HEADING _rotation) const
+        {
+            return _validateCell(_x, _y) && _rotation != type::HEADING::UNDEFINED;
+        }
+
+        /**
+         * @brief places a robot at a specific location on the table top
+         * @param _robot slot of the robot
+         * @param _x x axis on table top
+         * @param _y y axis on table top
+         * @param _rotation direction to face
+         * @return true if the robot was placed
+        */
+        bool placeHere(const uint32_t _robot, const uint32_t _x, const uint32_t _y, const type::HEADING _rotation);
+
+        /**
+         * @brief moves a robot 1 unit in the direction it is facing
+         * @param _robot slot of the robot
+         * @return true if the robot moved
+        */
+        bool move(const uint32_t _robot);
+
+        /**
+         * @brief rotates a robot to the left/anti-clockwise or right/clockwise direction
+         * @param _robot slot of the robot
+         * @return true if the robot rotated
+        */
+        bool rotateLeft(const uint32_t _robot);
+        bool rotateRight(const uint32_t _robot);
+
+        /**
+         * @brief accessors for robot state
+         * @param _robot slot of the robot
+        */
+        type::T_Position<uint32_t> getPosition(const uint32_t _robot) const { return m_transforms[_robot].getPosition(); };
+        type::HEADING getRotation(const uint32_t _robot) const { return m_transforms[_robot].getRotation(); };
+        bool isPlaced(const uint32_t _robot) const { return m_placed[_robot] != 0; };
+        const Transform& getTransform(const uint32_t _robot) const { return m_transforms[_robot]; };
+
+        /**
+         * @brief overwrite a robot state without validation, used to write back simulated state
+         * @param _robot slot of the robot
+         * @param _transform position and rotation
+         * @param _isPlaced robot is on the table
+        */
+        void setState(const uint32_t _robot, const Transform& _transform, const bool _isPlaced);
+
+        /**
+         * @brief string form of a robot position, matches ToyRobot::getReport
+        */
+        std::string getReport(const uint32_t _robot) const;
+
+        /**
+         * @brief copy the fleet state into a new fleet
+         * @brief transforms and placed flags are copied, obstacles are shared and no spatial index or geofence
+         *        monitor is attached. the copy of a mapped fleet lives on the heap
+         * @return independent fleet starting from the same state
+        */
+        std::unique_ptr<Fleet> fork() const;
+
+        /**
+         * @brief attach an obstacle layer used when validating cells
+         * @param _obstacleMap obstacles to consult, nullptr to disable
+        */
+        void setObstacleMap(const ObstacleMap* _obstacleMap) { m_obstacleMap = _obstacleMap; };
+        const ObstacleMap* getObstacleMap() const { return m_obstacleMap; };
+
+        /**
+         * @brief attach a spatial index, every placed robot is inserted straight away
+         * @param _spatialIndex index to keep up to date, nullptr to detach
+        */
+        void setSpatialIndex(SpatialIndex* _spatialIndex);
+
+        /**
+         * @brief attach a geofence monitor, every placed robot is checked straight away
+         * @param _geofenceMonitor monitor to keep up to date, nullptr to detach
+        */
+        void setGeofenceMonitor(GeofenceMonitor* _geofenceMonitor);
+    };
+}
+
+#endif  // FLEET_H
@@ -0,0 +1,151 @@
+#include "Geofence.h"
+#include <algorithm>
+#include <stdio.h>
+
+namespace object
+{
+    GeofenceIndex::GeofenceIndex(const uint32_t _extentX, const uint32_t _extentY)
+        :   m_width(_extentX + 1),
+            m_height(_extentY + 1),
+            m_cells(size_t(m_width) * m_height, 0)
+    {
+        _intern(std::vector<uint32_t>());
+    }
+
+    uint32_t GeofenceIndex::_intern(std::vector<uint32_t> _zones)
+    {
+        auto result = m_interned.emplace(std::move(_zones), uint32_t(m_sets.size()));
+        if(result.second)
+            m_sets.push_back(&result.first->first);
+        return result.first->second;
+    }
+
+    void GeofenceIndex::_apply(const uint32_t _zone, const bool _isAdded)
+    {
+        const Zone& zone = m_zones[_zone];
+        // every cell with the same set before gets the same set after
+        std::unordered_map<uint32_t, uint32_t> replaced;
+        for(uint32_t y = zone.m_minY; y <= zone.m_maxY; ++y)
+        {
+            for(uint32_t x = zone.m_minX; x <= zone.m_maxX; ++x)
+            {
+                uint32_t& cell = m_cells[size_t(y) * m_width + x];
+                auto itr = replaced.find(cell);
+                if(itr != replaced.end())
+                {
+                    cell = itr->second;
+                    continue;
+                }
+                std::vector<uint32_t> zones = *m_sets[cell];
+                if(_isAdded)
+                    zones.insert(std::upper_bound(zones.begin(), zones.end(), _zone), _zone);
+                else
+                    zones.erase(std::lower_bound(zones.begin(), zones.end(), _zone));
+                const uint32_t set = _intern(std::move(zones));
+                replaced.emplace(cell, set);
+                cell = set;
+            }
+        }
+    }
+
+    uint32_t GeofenceIndex::addZone(const uint32_t _minX, const uint32_t _minY, const uint32_t _maxX, const uint32_t _maxY)
+    {
+        if(_minX > _maxX || _minY > _maxY || _maxX >= m_width || _maxY >= m_height || m_zones.size() >= NO_ZONE)
+            return NO_ZONE;
+        const uint32_t zone = uint32_t(m_zones.size());
+        m_zones.push_back(Zone{ _minX, _minY, _maxX, _maxY, true });
+        _apply(zone, true);
+        return zone;
+    }
+
+    bool GeofenceIndex::removeZone(const uint32_t _zone)
+    {
+        if(_zone >= m_zones.size() || !m_zones[_zone].m_isActive)
+            return false;
+        _apply(_zone, false);
+        m_zones[_zone].m_isActive = false;
+        return true;
+    }
+
+    void GeofenceMonitor::Stats::print() const
+    {
+        printf("\nGEOFENCE: %lu checks, %lu zone changes, %lu events, %lu dropped\n", (unsigned long)m_checks,
+            (unsigned long)m_changes, (unsigned long)m_events, (unsigned long)m_dropped);
+    }
+
+    GeofenceMonitor::GeofenceMonitor(const GeofenceIndex& _index, SpscQueue<GeofenceEvent>& _queue, const uint32_t _listenerRobot)
+        :   m_index(_index),
+            m_queue(_queue),
+            m_listenerRobot(_listenerRobot)
+    {}
+
+    void GeofenceMonitor::_difference(const uint32_t _from, const uint32_t _to, Difference& _difference) const
+    {
+        // both sets are sorted, walk them together
+        const std::vector<uint32_t>& from = m_index.getZones(_from);
+        const std::vector<uint32_t>& to = m_index.getZones(_to);
+        size_t i = 0;
+        size_t j = 0;
+        while(i < from.size() || j < to.size())
+        {
+            GeofenceEvent event;
+            if(j == to.size() || (i < from.size() && from[i] < to[j]))
+            {
+                event.m_type = GeofenceEvent::TYPE::EXIT;
+                event.m_zone = from[i++];
+            }
+            else if(i == from.size() || to[j] < from[i])
+            {
+                event.m_type = GeofenceEvent::TYPE::ENTER;
+                event.m_zone = to[j++];
+            }
+            else
+            {
+                ++i;
+                ++j;
+                continue;
+            }
+            _difference.push_back(event);
+        }
+    }
+
+    void GeofenceMonitor::_raise(const uint32_t _robot, const uint32_t _from, const uint32_t _to, const uint32_t _x,
+        const uint32_t _y)
+    {
+        ++m_stats.m_changes;
+        m_current[_robot] = _to;
+        const Difference* difference = &m_scratch;
+        if(m_index.getZones(_from).size() + m_index.getZones(_to).size() <= MEMO_ZONES)
+        {
+            m_scratch.clear();
+            _difference(_from, _to, m_scratch);
+        }
+        else
+        {
+            auto itr = m_differences.find((uint64_t(_from) << 32) | _to);
+            if(itr == m_differences.end())
+            {
+                // robots wandering through many distinct sets would otherwise grow this without bound
+                if(m_differences.size() >= MAX_DIFFERENCES)
+                    m_differences.clear();
+                itr = m_differences.emplace((uint64_t(_from) << 32) | _to, Difference()).first;
+                _difference(_from, _to, itr->second);
+            }
+            difference = &itr->second;
+        }
+        for(GeofenceEvent event : *difference)
+        {
+            event.m_robot = _robot;
+            event.m_x = _x;
+            event.m_y = _y;
+            ++(m_queue.tryPush(event) ? m_stats.m_events : m_stats.m_dropped);
+        }
+    }
+
+    void GeofenceMonitor::remove(const uint32_t _robot)
+    {
+        if(_robot >= m_current.size() || m_current[_robot] == 0)
+            return;
+        _raise(_robot, m_current[_robot], 0, GeofenceEvent::OFF_TABLE, GeofenceEvent::OFF_TABLE);
+    }
+}
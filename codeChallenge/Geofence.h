@@ -0,0 +1,222 @@
+#ifndef GEOFENCE_H
+#define GEOFENCE_H
+
+#include "Objects.h"
+#include "SpscQueue.h"
+#include <map>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+namespace object
+{
+
+    /**
+     * A robot entering or leaving a zone
+    */
+    struct GeofenceEvent
+    {
+        enum class TYPE : uint8_t
+        {
+            ENTER   = 0,
+            EXIT    = 1
+        };
+        /// cell of an event raised by a robot leaving the table
+        static constexpr uint32_t OFF_TABLE = ~0u;
+
+        TYPE m_type = TYPE::ENTER;
+        uint32_t m_robot = 0;
+        uint32_t m_zone = 0;
+        /// cell the robot moved to
+        uint32_t m_x = OFF_TABLE;
+        uint32_t m_y = OFF_TABLE;
+    };
+
+    /**
+     * Rectangular zones with a per cell membership index
+     * @brief   every distinct set of zones covering a cell is interned once and each cell stores the 32 bit id of
+     *          its set, so the zones at a cell are one array read and two cells are in the same zones exactly when
+     *          their ids are equal. set 0 is the empty set. adding or removing a zone rewrites the cells it
+     *          covers, sets that no cell uses any more are kept so ids held elsewhere stay valid
+    */
+    class GeofenceIndex
+    {
+    public:
+        /// zone id returned when a zone could not be added
+        static constexpr uint32_t NO_ZONE = ~0u;
+
+    private:
+        struct Zone
+        {
+            uint32_t m_minX;
+            uint32_t m_minY;
+            uint32_t m_maxX;
+            uint32_t m_maxY;
+            bool m_isActive;
+        };
+
+        /// cells on each axis
+        const uint32_t m_width;
+        const uint32_t m_height;
+        /// set id per cell, row major
+        std::vector<uint32_t> m_cells;
+        std::vector<Zone> m_zones;
+        /// sorted zone ids by set id, pointing at the keys of m_interned
+        std::vector<const std::vector<uint32_t>*> m_sets;
+        std::map<std::vector<uint32_t>, uint32_t> m_interned;
+
+        /**
+         * @brief id of a set, added if new
+        */
+        uint32_t _intern(std::vector<uint32_t> _zones);
+
+        /**
+         * @brief add or remove a zone on every cell of its rectangle
+        */
+        void _apply(const uint32_t _zone, const bool _isAdded);
+
+    public:
+        /**
+         * @param _extentX largest x axis value, inclusive like TABLE_TOP_X
+         * @param _extentY largest y axis value, inclusive like TABLE_TOP_Y
+        */
+        GeofenceIndex(const uint32_t _extentX, const uint32_t _extentY);
+
+        /**
+         * @brief add a zone covering a rectangle of cells, corners inclusive
+         * @return id of the zone, NO_ZONE if the rectangle is empty or off the table
+        */
+        uint32_t addZone(const uint32_t _minX, const uint32_t _minY, const uint32_t _maxX, const uint32_t _maxY);
+
+        /**
+         * @brief remove a zone, robots inside it get their EXIT on their next move
+         * @return false if the zone is unknown or already removed
+        */
+        bool removeZone(const uint32_t _zone);
+
+        /**
+         * @brief set id of the zones covering a cell, 0 off the table
+        */
+        uint32_t getSet(const uint32_t _x, const uint32_t _y) const
+        {
+            return (_x < m_width && _y < m_height) ? m_cells[size_t(_y) * m_width + _x] : 0;
+        }
+
+        /**
+         * @brief sorted zone ids of a set
+        */
+        const std::vector<uint32_t>& getZones(const uint32_t _set) const { return *m_sets[_set]; };
+
+        size_t getZoneCount() const { return m_zones.size(); };
+        size_t getSetCount() const { return m_sets.size(); };
+    };
+
+    /**
+     * Raises ENTER and EXIT events as robots move between zones
+     * @brief   the monitor keeps the set id of the cell every robot is on. a MOVE or PLACE looks the new cell up
+     *          in the index and does nothing more when the id is unchanged, which is the common case. otherwise
+     *          the zones left and entered are pushed to a single consumer queue without waiting, the difference
+     *          of two large sets is worked out once and reused. events that do not fit in the queue are counted as
+     *          dropped. attach it to a ToyRobot as a listener or to a Fleet with setGeofenceMonitor
+    */
+    class GeofenceMonitor : public TransformListener
+    {
+    public:
+        struct Stats
+        {
+            /// cell lookups
+            uint64_t m_checks = 0;
+            /// lookups that changed the set of zones
+            uint64_t m_changes = 0;
+            uint64_t m_events = 0;
+            /// events lost to a full queue
+            uint64_t m_dropped = 0;
+
+            /**
+             * @brief print event counts
+            */
+            void print() const;
+        };
+
+    private:
+        /// events of moving from one set to another, without robot and cell
+        typedef std::vector<GeofenceEvent> Difference;
+        /// smaller differences are cheaper to work out again than to look up
+        static constexpr size_t MEMO_ZONES = 64;
+        /// remembered differences before they are dropped and worked out again as needed
+        static constexpr size_t MAX_DIFFERENCES = 4096;
+
+        const GeofenceIndex& m_index;
+        SpscQueue<GeofenceEvent>& m_queue;
+        /// robot id used for events of the robot the monitor listens to
+        const uint32_t m_listenerRobot;
+        /// set id per robot
+        std::vector<uint32_t> m_current;
+        /// differences of sets holding more than MEMO_ZONES zones between them, by from << 32 | to
+        std::unordered_map<uint64_t, Difference> m_differences;
+        /// difference worked out for the current event
+        Difference m_scratch;
+        Stats m_stats;
+
+        /**
+         * @brief zones left and entered moving from one set to another
+        */
+        void _difference(const uint32_t _from, const uint32_t _to, Difference& _difference) const;
+
+        /**
+         * @brief push the events of moving a robot from one set to another
+        */
+        void _raise(const uint32_t _robot, const uint32_t _from, const uint32_t _to, const uint32_t _x, const uint32_t _y);
+
+    public:
+        /**
+         * @param _index zones, not owned
+         * @param _queue receives events, not owned. this monitor is its only producer
+         * @param _listenerRobot robot id of events raised through onAction
+        */
+        GeofenceMonitor(const GeofenceIndex& _index, SpscQueue<GeofenceEvent>& _queue, const uint32_t _listenerRobot = 0);
+
+        /**
+         * @brief a robot is now on a cell
+        */
+        void update(const uint32_t _robot, const uint32_t _x, const uint32_t _y)
+        {
+            ++m_stats.m_checks;
+            if(_robot >= m_current.size())
+                m_current.resize(size_t(_robot) + 1, 0);
+            // without zones every cell is in the empty set, skip reading the cell
+            const uint32_t set = m_index.getSetCount() > 1 ? m_index.getSet(_x, _y) : 0;
+            if(set == m_current[_robot])
+                return;
+            _raise(_robot, m_current[_robot], set, _x, _y);
+        }
+
+        /**
+         * @brief a robot left the table, it exits every zone it was in
+        */
+        void remove(const uint32_t _robot);
+
+        /**
+         * @brief check the cell of the listened robot after a command that can change it, an UNDO back off the
+         *        table exits every zone
+        */
+        virtual void onAction(const type::ACTION _action, const bool _accepted, const type::T_Transform<uint8_t>& _transform,
+            const bool _isPlaced) override
+        {
+            if(!_accepted || _action == type::ACTION::LEFT || _action == type::ACTION::RIGHT || _action == type::ACTION::REPORT)
+                return;
+            if(!_isPlaced)
+            {
+                remove(m_listenerRobot);
+                return;
+            }
+            const auto position = _transform.getPosition();
+            update(m_listenerRobot, position.x, position.y);
+        }
+
+        const Stats& getStats() const { return m_stats; };
+        size_t getDifferenceCount() const { return m_differences.size(); };
+    };
+}
+
+#endif  // GEOFENCE_H
@@ -1,6 +1,8 @@
 #include "Objects.h"
+#include <algorithm>
 #include <string>
 #include <cstring>
+#include <utility>
 
 namespace object
 {
@@ -8,13 +10,14 @@ namespace object
     {
         // build actions for each input enum
         _buildActions();
+        setHistoryCapacity(DEFAULT_HISTORY_CAPACITY);
     };
 
-    void ToyRobot::_rotate(bool _clockWise)
+    bool ToyRobot::_rotate(bool _clockWise)
     {
         // check if the robot is on the table top
         if(!m_hasBeenPlaced)
-            return;
+            return false;
         // get transform heading
         const type::HEADING direction = m_transform.getRotation();
         // get heading from map
@@ -51,73 +54,100 @@ namespace object
             }
             // apply new rotation
             m_transform.setRotation(itr->first);
+            return true;
         }
+        return false;
     }
 
-    void ToyRobot::move()
+    bool ToyRobot::move()
     {
         // check if the robot is on the table top
         if(!m_hasBeenPlaced)
-            return;
+            return false;
+        bool hasMoved = false;
         auto currentPos = getPosition();
         // depending on heading move in that direction
         switch (getRotation())
         {
         // move to the north
         case type::HEADING::NORTH:
-            if(validateAxisX(++currentPos.y))
+            if(validateAxisY(++currentPos.y) && validateCell(currentPos.x, currentPos.y))
             {
                 m_transform.setPosition(currentPos);
+                hasMoved = true;
             }
             break;
         // move to the south
         case type::HEADING::SOUTH:
-            if(validateAxisX(--currentPos.y))
+            if(validateAxisY(--currentPos.y) && validateCell(currentPos.x, currentPos.y))
             {
                 m_transform.setPosition(currentPos);
+                hasMoved = true;
             }
             break;
         // move to the east
         case type::HEADING::EAST:
-            if(validateAxisX(++currentPos.x))
+            if(validateAxisX(++currentPos.x) && validateCell(currentPos.x, currentPos.y))
             {
                 m_transform.setPosition(currentPos);
+                hasMoved = true;
             }
             break;
         // move to the west
         case type::HEADING::WEST:
-            if(validateAxisX(--currentPos.x))
+            if(validateAxisX(--currentPos.x) && validateCell(currentPos.x, currentPos.y))
             {
                 m_transform.setPosition(currentPos);
+                hasMoved = true;
             }
             break;
         // anything else do nothing
         default:
             break;
         }
+        if(hasMoved)
+            _record();
+        _notify(type::ACTION::MOVE, hasMoved);
+        return hasMoved;
     }
 
-    void ToyRobot::rotateLeft()
+    bool ToyRobot::rotateLeft()
     { 
-        _rotate(false); 
+        const bool hasRotated = _rotate(false);
+        if(hasRotated)
+            _record();
+        if(m_hasBeenPlaced)
+            _notify(type::ACTION::LEFT, hasRotated);
+        return hasRotated;
     }
     
-    void ToyRobot::rotateRight()  
+    bool ToyRobot::rotateRight()  
     { 
-        _rotate(true); 
+        const bool hasRotated = _rotate(true);
+        if(hasRotated)
+            _record();
+        if(m_hasBeenPlaced)
+            _notify(type::ACTION::RIGHT, hasRotated);
+        return hasRotated;
     }
     
-    void ToyRobot::placeHere(const uint8_t _x, const uint8_t _y, const type::HEADING _rotation)
+    bool ToyRobot::placeHere(const uint8_t _x, const uint8_t _y, const type::HEADING _rotation)
     {
         // check validity of arguments
-        if(validateAxisX(_x) && validateAxisY(_y) && validateRotation(_rotation))
+        if(validateAxisX(_x) && validateAxisY(_y) && validateRotation(_rotation) && validateCell(_x, _y))
         {   
             // set a new position and rotation
             m_hasBeenPlaced = true;
             m_transform.setRotation(_rotation);
             const type::T_Position<uint8_t> position(_x, _y);
             m_transform.setPosition(position);
+            _record();
+            _notify(type::ACTION::PLACE, true);
+            return true;
         }
+        if(m_hasBeenPlaced)
+            _notify(type::ACTION::PLACE, false);
+        return false;
     }
     
     const type::T_Position<uint8_t> ToyRobot::getPosition()
@@ -158,7 +188,7 @@ namespace object
             size_t pos = 0;
             uint32_t loopCounter = 0;
             uint32_t x = 0, y = 0;
-            type::HEADING heading; 
+            type::HEADING heading = type::HEADING::UNDEFINED;
             std::string token;
             bool tooManyTokens = false;
             // iterate over input to build command from string
@@ -227,15 +257,410 @@ namespace object
             // check if the robot is on the table top
             if(!m_hasBeenPlaced)
                 return;
-            printf( "Output : %s\n" ,getReport().c_str());
+            _report();
+        }));
+        // Undo action, also allowed when unplaced so the first PLACE can be redone
+        m_actionMap.insert(std::make_pair( type::ACTION::UNDO , [&](const std::string&){
+            undo();
+        }));
+        // Redo action 
+        m_actionMap.insert(std::make_pair( type::ACTION::REDO , [&](const std::string&){
+            redo();
+        }));
+        // Define action, "DEFINE name body"
+        m_actionMap.insert(std::make_pair( type::ACTION::DEFINE , [&](const std::string& _input){
+            std::string_view args = std::string_view(_input).substr(std::min<size_t>(_input.size(), 7));
+            const size_t pos = args.find(' ');
+            if(pos == std::string_view::npos)
+                return;
+            define(args.substr(0, pos), args.substr(pos + 1));
+        }));
+        // Call action, "CALL name"
+        m_actionMap.insert(std::make_pair( type::ACTION::CALL , [&](const std::string& _input){
+            call(std::string_view(_input).substr(std::min<size_t>(_input.size(), 5)));
         }));
     };
 
+    bool ToyRobot::execute(const type::Command& _command)
+    {
+        TraceSpan span("execute", TraceSpan::MODE::COMMAND);
+        AllocationScope allocations(_command.action);
+        switch (_command.action)
+        {
+        case type::ACTION::PLACE:
+            // same checks as the PLACE action before narrowing to the transform width
+            if(!(validateAxisX(_command.x) && validateAxisY(_command.y) && validateRotation(_command.heading)))
+                return false;
+            return placeHere(uint8_t(_command.x), uint8_t(_command.y), _command.heading);
+        case type::ACTION::MOVE:
+            return m_hasBeenPlaced && move();
+        case type::ACTION::LEFT:
+            return m_hasBeenPlaced && rotateLeft();
+        case type::ACTION::RIGHT:
+            return m_hasBeenPlaced && rotateRight();
+        case type::ACTION::REPORT:
+            if(!m_hasBeenPlaced)
+                return false;
+            _report();
+            return true;
+        case type::ACTION::UNDO:
+            return undo();
+        case type::ACTION::REDO:
+            return redo();
+        default:
+            return false;
+        }
+    }
+
+    void ToyRobot::_report()
+    {
+        if(m_reportBuffer != nullptr)
+            m_reportBuffer->append(getReport()).push_back('\n');
+        else if(m_reportCallback)
+            m_reportCallback(getReport());
+        else
+            printf( "Output : %s\n" ,getReport().c_str());
+        _notify(type::ACTION::REPORT, true);
+    }
+
+    void ToyRobot::reset()
+    {
+        // only allocates when the UNDO depth was changed
+        if(getHistoryCapacity() != DEFAULT_HISTORY_CAPACITY)
+            setHistoryCapacity(DEFAULT_HISTORY_CAPACITY);
+        restore(Snapshot());
+        m_listeners.clear();
+        m_reportCallback = nullptr;
+        m_macroState.reset();
+        ++m_macroGeneration;
+    }
+
+    bool ToyRobot::undo()
+    {
+        if(m_undoCount == 0)
+            return false;
+        // step the cursor back and apply the older state
+        m_historyCursor = (m_historyCursor + m_history.size() - 1) % m_history.size();
+        m_transform = m_history[m_historyCursor].m_transform;
+        m_hasBeenPlaced = m_history[m_historyCursor].m_hasBeenPlaced;
+        --m_undoCount;
+        ++m_redoCount;
+        _notify(type::ACTION::UNDO, true);
+        return true;
+    }
+
+    bool ToyRobot::redo()
+    {
+        if(m_redoCount == 0)
+            return false;
+        m_historyCursor = (m_historyCursor + 1) % m_history.size();
+        m_transform = m_history[m_historyCursor].m_transform;
+        m_hasBeenPlaced = m_history[m_historyCursor].m_hasBeenPlaced;
+        --m_redoCount;
+        ++m_undoCount;
+        _notify(type::ACTION::REDO, true);
+        return true;
+    }
+
+    uint16_t ToyRobot::_packState(const Snapshot& _snapshot)
+    {
+        if(!_snapshot.m_hasBeenPlaced)
+            return UNPLACED_STATE;
+        const auto position = _snapshot.m_transform.getPosition();
+        return uint16_t(position.x | (position.y << 3) | ((_snapshot.m_transform.getRotation() & 0b11) << 6));
+    }
+
+    ToyRobot::Snapshot ToyRobot::_unpackState(const uint16_t _state)
+    {
+        Snapshot snapshot;
+        if(_state == UNPLACED_STATE)
+            return snapshot;
+        snapshot.m_transform.setPosition(type::T_Position<uint8_t>(uint8_t(_state & 0b111), uint8_t((_state >> 3) & 0b111)));
+        snapshot.m_transform.setRotation(type::HEADING((_state >> 6) & 0b11));
+        snapshot.m_hasBeenPlaced = true;
+        return snapshot;
+    }
+
+    void ToyRobot::_buildTransition(const type::Command& _command, Transition& _transition, Acceptance& _accepted)
+    {
+        if(!m_macroState->m_robot)
+            m_macroState->m_robot = std::make_unique<ToyRobot>();
+        ToyRobot& robot = *m_macroState->m_robot;
+        robot.setObstacleMap(m_obstacleMap);
+        // run the command from every state, packed placed states the table can not hold are left as they are
+        for(uint16_t state = 0; state < MACRO_STATES; ++state)
+        {
+            const Snapshot before = _unpackState(state);
+            const auto position = before.m_transform.getPosition();
+            if(state != UNPLACED_STATE && !(validateAxisX(position.x) && validateAxisY(position.y)))
+            {
+                _transition[state] = state;
+                _accepted[state] = false;
+                continue;
+            }
+            robot.restore(before);
+            bool isAccepted = false;
+            switch (_command.action)
+            {
+            case type::ACTION::PLACE:
+                if(validateAxisX(_command.x) && validateAxisY(_command.y))
+                    isAccepted = robot.placeHere(uint8_t(_command.x), uint8_t(_command.y), _command.heading);
+                break;
+            case type::ACTION::MOVE:    isAccepted = robot.move(); break;
+            case type::ACTION::LEFT:    isAccepted = robot.rotateLeft(); break;
+            case type::ACTION::RIGHT:   isAccepted = robot.rotateRight(); break;
+            default:                    break;
+            }
+            _transition[state] = _packState(robot.snapshot());
+            _accepted[state] = isAccepted;
+        }
+    }
+
+    const ToyRobot::Macro* ToyRobot::_buildMacro(Macro& _macro)
+    {
+        const MacroKey key = _macroKey();
+        if(_macro.m_key == key)
+            return _macro.m_isValid ? &_macro : nullptr;
+        // the macro calls itself through its body
+        if(_macro.m_isBuilding)
+            return nullptr;
+        _macro.m_isBuilding = true;
+        MacroState& macroState = *m_macroState;
+        // MOVE, LEFT and RIGHT only depend on the obstacles, generation 1 never matches the default key
+        const MacroKey primitiveKey{ 1, key.m_obstacleMap, key.m_obstacleVersion };
+        if(!(macroState.m_primitiveKey == primitiveKey))
+        {
+            _buildTransition(type::Command{ type::ACTION::MOVE }, macroState.m_primitives[0], macroState.m_primitiveAccepted[0]);
+            _buildTransition(type::Command{ type::ACTION::LEFT }, macroState.m_primitives[1], macroState.m_primitiveAccepted[1]);
+            _buildTransition(type::Command{ type::ACTION::RIGHT }, macroState.m_primitives[2], macroState.m_primitiveAccepted[2]);
+            macroState.m_primitiveKey = primitiveKey;
+        }
+        Transition result;
+        for(uint16_t state = 0; state < MACRO_STATES; ++state)
+            result[state] = state;
+        Acceptance accepted;
+        Transition place;
+        Acceptance placeAccepted;
+        bool isValid = true;
+        for(const MacroStep& step : _macro.m_steps)
+        {
+            const Transition* transition = nullptr;
+            const Acceptance* stepAccepted = nullptr;
+            if(!step.m_call.empty())
+            {
+                auto itr = macroState.m_macros.find(step.m_call);
+                const Macro* called = itr != macroState.m_macros.end() ? _buildMacro(itr->second) : nullptr;
+                if(called != nullptr)
+                {
+                    transition = &called->m_transition;
+                    stepAccepted = &called->m_accepted;
+                }
+            }
+            else if(step.m_command.action == type::ACTION::PLACE)
+            {
+                _buildTransition(step.m_command, place, placeAccepted);
+                transition = &place;
+                stepAccepted = &placeAccepted;
+            }
+            else
+            {
+                const size_t primitive = size_t(step.m_command.action) - size_t(type::ACTION::MOVE);
+                transition = &macroState.m_primitives[primitive];
+                stepAccepted = &macroState.m_primitiveAccepted[primitive];
+            }
+            if(transition == nullptr)
+            {
+                isValid = false;
+                break;
+            }
+            // apply the step after everything before it, a CALL is accepted when any of its steps is
+            for(uint16_t state = 0; state < MACRO_STATES; ++state)
+            {
+                accepted[state] = accepted[state] || (*stepAccepted)[result[state]];
+                result[state] = (*transition)[result[state]];
+            }
+        }
+        _macro.m_transition = result;
+        _macro.m_accepted = accepted;
+        _macro.m_key = key;
+        _macro.m_isValid = isValid;
+        _macro.m_isBuilding = false;
+        return isValid ? &_macro : nullptr;
+    }
+
+    bool ToyRobot::define(std::string_view _name, std::string_view _body)
+    {
+        if(_name.empty() || _name.find(' ') != std::string_view::npos)
+            return false;
+        std::vector<MacroStep> steps;
+        while(!_body.empty())
+        {
+            const size_t pos = _body.find(';');
+            std::string_view part = _body.substr(0, pos);
+            _body = pos == std::string_view::npos ? std::string_view() : _body.substr(pos + 1);
+            // allow "MOVE; LEFT"
+            while(!part.empty() && part.front() == ' ')
+                part.remove_prefix(1);
+            while(!part.empty() && part.back() == ' ')
+                part.remove_suffix(1);
+            if(part.empty())
+                continue;
+            MacroStep step;
+            if(part.starts_with("CALL "))
+                step.m_call = std::string(part.substr(5));
+            else if(!parseCommand(part, step.m_command) || step.m_command.action > type::ACTION::PLACE)
+                return false;
+            steps.push_back(std::move(step));
+        }
+        if(!m_macroState)
+            m_macroState = std::make_unique<MacroState>();
+        std::map<std::string, Macro, std::less<>>& macros = m_macroState->m_macros;
+        auto itr = macros.find(_name);
+        if(itr == macros.end())
+            itr = macros.emplace(std::string(_name), Macro()).first;
+        itr->second = Macro();
+        itr->second.m_steps = std::move(steps);
+        // every cached transition may call this macro
+        ++m_macroGeneration;
+        return true;
+    }
+
+    bool ToyRobot::call(std::string_view _name)
+    {
+        Macro* found = nullptr;
+        if(m_macroState)
+        {
+            auto itr = m_macroState->m_macros.find(_name);
+            if(itr != m_macroState->m_macros.end())
+                found = &itr->second;
+        }
+        if(found == nullptr)
+            return false;
+        const Macro* macro = _buildMacro(*found);
+        // unknown or recursive macro calls
+        if(macro == nullptr)
+            return false;
+        const uint16_t before = _packState(snapshot());
+        // like running the body, rejected only when every command in it was rejected
+        if(!macro->m_accepted[before])
+        {
+            if(m_hasBeenPlaced)
+                _notify(type::ACTION::CALL, false);
+            return false;
+        }
+        const Snapshot state = _unpackState(macro->m_transition[before]);
+        m_transform = state.m_transform;
+        m_hasBeenPlaced = state.m_hasBeenPlaced;
+        _record();
+        _notify(type::ACTION::CALL, true);
+        return true;
+    }
+
+    void ToyRobot::setHistoryCapacity(const size_t _capacity)
+    {
+        m_history.assign(_capacity + 1, snapshot());
+        m_historyCursor = 0;
+        m_undoCount = 0;
+        m_redoCount = 0;
+    }
+
+    void ToyRobot::addListener(TransformListener* _listener)
+    {
+        m_listeners.push_back(_listener);
+    }
+
+    void ToyRobot::removeListener(TransformListener* _listener)
+    {
+        auto itr = std::find(m_listeners.begin(), m_listeners.end(), _listener);
+        if(itr != m_listeners.end())
+            m_listeners.erase(itr);
+    }
+
 }
 
 namespace object
 {
 
+    bool InputHandler::parseCommand(std::string_view _input, type::Command& _command)
+    {
+        // action is everything up to the first space
+        const std::string_view actionStr = _input.substr(0, _input.find(' '));
+        bool isKnown = false;
+        for(const auto& action : type::actionEnumMap)
+        {
+            if(actionStr == action.first)
+            {
+                _command = type::Command();
+                _command.action = action.second;
+                isKnown = true;
+                break;
+            }
+        }
+        // macros need the robot that defined them, they have no Command form
+        if(!isKnown || _command.action == type::ACTION::DEFINE || _command.action == type::ACTION::CALL)
+            return false;
+        if(_command.action != type::ACTION::PLACE)
+            return true;
+        // PLACE arguments follow "PLACE " as "x,y,heading", anything after a third "," is ignored
+        std::string_view args = _input.size() > 6 ? _input.substr(6) : std::string_view();
+        uint32_t values[2] = {0, 0};
+        for(uint32_t& value : values)
+        {
+            const size_t pos = args.find(',');
+            // missing heading, proccessInput reuses the last token which is never a heading
+            if(pos == std::string_view::npos)
+                return false;
+            uint64_t number = 0;
+            for(const char c : args.substr(0, pos))
+            {
+                if(c < '0' || c > '9')
+                    return false;
+                // saturate so oversized values fail validation
+                number = std::min<uint64_t>(number * 10 + uint64_t(c - '0'), UINT32_MAX);
+            }
+            value = uint32_t(number);
+            args.remove_prefix(pos + 1);
+        }
+        _command.x = values[0];
+        _command.y = values[1];
+        _command.heading = type::getHeadingEnum(args.substr(0, args.find(',')));
+        return _command.heading != type::HEADING::UNDEFINED;
+    }
+
+    InputHandler::BatchResult InputHandler::processBatch(std::span<const std::string_view> _inputs, std::string* _reports)
+    {
+        BatchResult result;
+        std::string* const previous = std::exchange(m_reportBuffer, _reports);
+        type::Command command;
+        for(const std::string_view input : _inputs)
+        {
+            if(!parseCommand(input, command))
+            {
+                ++result.m_ignored;
+                continue;
+            }
+            const bool isAccepted = execute(command);
+            ++(isAccepted ? result.m_accepted : result.m_rejected);
+            result.m_reports += isAccepted && command.action == type::ACTION::REPORT;
+        }
+        m_reportBuffer = previous;
+        return result;
+    }
+
+    InputHandler::BatchResult InputHandler::processBatch(std::span<const type::Command> _commands, std::string* _reports)
+    {
+        BatchResult result;
+        std::string* const previous = std::exchange(m_reportBuffer, _reports);
+        for(const type::Command& command : _commands)
+        {
+            const bool isAccepted = execute(command);
+            ++(isAccepted ? result.m_accepted : result.m_rejected);
+            result.m_reports += isAccepted && command.action == type::ACTION::REPORT;
+        }
+        m_reportBuffer = previous;
+        return result;
+    }
+
     const bool InputHandler::isNumber(const std::string& _str)
     {
         for(const auto& c : _str)
@@ -252,7 +677,7 @@ namespace object
     const bool InputHandler::validateAxisY(const uint32_t& _y)
     {
         // check value against extents
-        return (_y <= TABLE_TOP_X) && (_y >= 0);
+        return (_y <= TABLE_TOP_Y) && (_y >= 0);
     }
 
     const bool InputHandler::validateRotation(const type::HEADING& _heading)
@@ -7,8 +7,18 @@
 */
 
 #include "Types.h"
+#include "Obstacles.h"
+#include "Fleet.h"
+#include "Trace.h"
+#include "Allocations.h"
+#include <algorithm>
+#include <array>
+#include <bitset>
 #include <memory>
 #include <functional>
+#include <span>
+#include <string_view>
+#include <vector>
 
 /// table top sizes
 #define TABLE_TOP_X 4
@@ -26,6 +36,10 @@ namespace object
     protected:
         /// key/value pairs linkning action enums to lambdas
         std::map<type::ACTION, std::function<void(const std::string _input)>> m_actionMap;
+        /// optional static obstacles, not owned
+        const ObstacleMap* m_obstacleMap = nullptr;
+        /// REPORT output of the running batch, reports go to the usual output when nullptr
+        std::string* m_reportBuffer = nullptr;
 
         /**
          * @brief check a value against X axie rules
@@ -48,6 +62,17 @@ namespace object
         */
         const bool validateRotation(const type::HEADING& _heading);
 
+        /**
+         * @brief check a cell against obstacle rules
+         * @param _x x axis of the cell
+         * @param _y y axis of the cell
+         * @return pass or fail
+        */
+        const bool validateCell(const uint32_t& _x, const uint32_t& _y)
+        {
+            return (m_obstacleMap == nullptr) || !m_obstacleMap->isBlocked(_x, _y);
+        }
+
         /**
          * @brief check if a string is a number
          * @param string to validate
@@ -55,30 +80,87 @@ namespace object
         */
         const bool isNumber(const std::string& _str);
     public:
+        /// outcome of a batch of commands
+        struct BatchResult
+        {
+            uint64_t m_accepted = 0;
+            uint64_t m_rejected = 0;
+            /// string commands proccessInput would ignore, not counted as rejected
+            uint64_t m_ignored = 0;
+            /// accepted REPORT commands
+            uint64_t m_reports = 0;
+        };
 
         InputHandler(){};
         virtual ~InputHandler(){};
 
+        /**
+         * @brief attach an obstacle layer used when validating cells
+         * @param _obstacleMap obstacles to consult, nullptr to disable
+        */
+        void setObstacleMap(const ObstacleMap* _obstacleMap) { m_obstacleMap = _obstacleMap; };
+        const ObstacleMap* getObstacleMap() const { return m_obstacleMap; };
+
         /**
          * @brief process strinified commands
          * @param string command to process
         */
        void proccessInput(const std::string& _input)
        {
-            // get command out of input string
-            const std::string actionStr = _input.substr(0, _input.find(" "));
-            // get str to enum value iterator
-            auto enumItr = type::actionEnumMap.find(actionStr);
-            // does input exist as an action enum, if not return early
-            if(enumItr == type::actionEnumMap.cend())
-                return;
-            // does action enum have a associated action callback, if not return early
-            const auto actionItr = m_actionMap.find(enumItr->second);
-            if(actionItr == m_actionMap.cend())
-                return;
+            TraceSpan dispatchSpan("dispatch", TraceSpan::MODE::COMMAND);
+            AllocationScope allocations;
+            decltype(m_actionMap)::const_iterator actionItr;
+            {
+                TraceSpan parseSpan("parse", TraceSpan::MODE::NESTED);
+                // get command out of input string
+                const std::string actionStr = _input.substr(0, _input.find(" "));
+                // get str to enum value iterator
+                auto enumItr = type::actionEnumMap.find(actionStr);
+                // does input exist as an action enum, if not return early
+                if(enumItr == type::actionEnumMap.cend())
+                    return;
+                allocations.setAction(enumItr->second);
+                // does action enum have a associated action callback, if not return early
+                actionItr = m_actionMap.find(enumItr->second);
+                if(actionItr == m_actionMap.cend())
+                    return;
+            }
             // run action callback
+            TraceSpan executeSpan("execute", TraceSpan::MODE::NESTED);
             actionItr->second(_input);
        };
+
+        /**
+         * @brief parse a command string the same way proccessInput does, without allocating
+         * @param _input command to parse
+         * @param _command receives the parsed command
+         * @return false if proccessInput would ignore the input, and for DEFINE and CALL which only proccessInput runs
+        */
+        static bool parseCommand(std::string_view _input, type::Command& _command);
+
+        /**
+         * @brief run a pre-parsed command
+         * @param _command command from parseCommand
+         * @return true if the command was accepted
+        */
+        virtual bool execute(const type::Command& _command) = 0;
+
+        /**
+         * @brief run many string commands in one loop, parsed with parseCommand so nothing is allocated per command
+         * @param _inputs commands in order
+         * @param _reports optional buffer REPORT output is appended to, one line per report, reserve it up front
+         *                 to avoid growing it. when nullptr reports go to the report callback or the window
+         * @return accepted, rejected and ignored counts
+        */
+        BatchResult processBatch(std::span<const std::string_view> _inputs, std::string* _reports = nullptr);
+
+        /**
+         * @brief run many pre-parsed commands in one loop
+         * @param _commands commands from parseCommand
+         * @param _reports optional buffer REPORT output is appended to, see above
+         * @return accepted and rejected counts
+        */
+        BatchResult processBatch(std::span<const type::Command> _commands, std::string* _reports = nullptr);
     private:
 
         /**
@@ -87,17 +169,171 @@ namespace object
         virtual void _buildActions() = 0;
     };
 
+    /**
+     * Observer of robot commands
+     * @brief notified after a placed robot handles a command, with the resulting transform
+    */
+    class TransformListener
+    {
+    public:
+        virtual ~TransformListener(){};
+
+        /**
+         * @brief called after a command has been applied or rejected
+         * @param _action action that was processed
+         * @param _accepted false if the robot rejected the command
+         * @param _transform robot transform after the command
+         * @param _isPlaced false if the robot is off the table after the command, an UNDO can take it back off
+        */
+        virtual void onAction(const type::ACTION _action, const bool _accepted, const type::T_Transform<uint8_t>& _transform,
+            const bool _isPlaced) = 0;
+    };
+
     /**
      * Player controller robot
     */
     class ToyRobot : public InputHandler
     {
+    public:
+        /**
+         * copy of the robot state
+         * @brief holds everything needed to fork a robot, the action map is not part of it
+        */
+        struct Snapshot
+        {
+            type::T_Transform<uint8_t> m_transform;
+            bool m_hasBeenPlaced = false;
+        };
+
+    private:
         /// robot position and rotation
         type::T_Transform<uint8_t> m_transform;
         /// flag identying if this robot has been placed
         bool m_hasBeenPlaced = false;
+        /// observers notified on every command, not owned
+        std::vector<TransformListener*> m_listeners;
+        /// optional REPORT output handler, printf is used when empty
+        std::function<void(const std::string&)> m_reportCallback;
+        /// ring of states for UNDO/REDO, capacity + 1 entries so the current state is kept too
+        std::vector<Snapshot> m_history;
+        /// ring slot holding the current state
+        size_t m_historyCursor = 0;
+        /// amount of states available to UNDO and REDO
+        size_t m_undoCount = 0;
+        size_t m_redoCount = 0;
+
+        /// macro results are over packed placed states (x | y << 3 | heading << 6) plus this one for unplaced
+        static constexpr uint16_t UNPLACED_STATE = 256;
+        static constexpr size_t MACRO_STATES = 257;
+        static_assert(TABLE_TOP_X <= 7 && TABLE_TOP_Y <= 7, "macro states pack each axis of the table in 3 bits");
+        /// state after a command or macro for every state before it
+        typedef std::array<uint16_t, MACRO_STATES> Transition;
+        /// for every state before a command or macro, whether any command of it was accepted
+        typedef std::bitset<MACRO_STATES> Acceptance;
+
+        /// what a transition depends on besides the commands, it is rebuilt when this changes
+        struct MacroKey
+        {
+            uint64_t m_generation = 0;
+            const ObstacleMap* m_obstacleMap = nullptr;
+            uint64_t m_obstacleVersion = 0;
+
+            bool operator==(const MacroKey&) const = default;
+        };
+
+        /// one command of a macro body, a CALL when m_call is set
+        struct MacroStep
+        {
+            type::Command m_command;
+            std::string m_call;
+        };
+
+        struct Macro
+        {
+            std::vector<MacroStep> m_steps;
+            Transition m_transition;
+            Acceptance m_accepted;
+            /// key m_transition was built for
+            MacroKey m_key;
+            /// false when the body calls an unknown macro or itself
+            bool m_isValid = false;
+            bool m_isBuilding = false;
+        };
+
+        /// everything macros need, only allocated by the first DEFINE so other robots stay small
+        struct MacroState
+        {
+            /// macros by name
+            std::map<std::string, Macro, std::less<>> m_macros;
+            /// MOVE, LEFT and RIGHT transitions for m_primitiveKey
+            std::array<Transition, 3> m_primitives;
+            std::array<Acceptance, 3> m_primitiveAccepted;
+            MacroKey m_primitiveKey;
+            /// works out single command transitions so they match this robot exactly, built on first use
+            std::unique_ptr<ToyRobot> m_robot;
+        };
+
+        std::unique_ptr<MacroState> m_macroState;
+        /// bumped by every DEFINE, a redefinition can change any macro calling it
+        uint64_t m_macroGeneration = 1;
+
+        /**
+         * @brief pack a state into a transition index
+        */
+        static uint16_t _packState(const Snapshot& _snapshot);
+        static Snapshot _unpackState(const uint16_t _state);
+
+        /**
+         * @brief current inputs of every transition
+        */
+        MacroKey _macroKey() const
+        {
+            return MacroKey{ m_macroGeneration, m_obstacleMap, m_obstacleMap != nullptr ? m_obstacleMap->getVersion() : 0 };
+        }
+
+        /**
+         * @brief transition and acceptance of a single PLACE, MOVE, LEFT or RIGHT
+        */
+        void _buildTransition(const type::Command& _command, Transition& _transition, Acceptance& _accepted);
+
+        /**
+         * @brief compose a macro body into one transition and acceptance, or reuse the cached ones
+         * @return the built macro, nullptr if the macro is invalid
+        */
+        const Macro* _buildMacro(Macro& _macro);
+
+        /**
+         * @brief notify listeners of a processed command
+        */
+        void _notify(const type::ACTION _action, const bool _accepted)
+        {
+            for(TransformListener* listener : m_listeners)
+                listener->onAction(_action, _accepted, m_transform, m_hasBeenPlaced);
+        }
+
+        /**
+         * @brief send a REPORT to the batch buffer, the report callback or the window
+        */
+        void _report();
+
+        /**
+         * @brief store the current state after an accepted command, drops any REDO states
+        */
+        void _record()
+        {
+            m_historyCursor = (m_historyCursor + 1) % m_history.size();
+            m_history[m_historyCursor] = snapshot();
+            m_undoCount = std::min(m_undoCount + 1, m_history.size() - 1);
+            m_redoCount = 0;
+        }
 
     public:
+        /// UNDO depth used by new robots
+        static constexpr size_t DEFAULT_HISTORY_CAPACITY = 32;
+        /// version of what commands do, bump it whenever a command changes its result or output so stored
+        /// replays of older builds, e.g. in a ResultCache directory, are not reused
+        static constexpr uint32_t REPLAY_VERSION = 1;
+
         ToyRobot();
         ToyRobot(const ToyRobot&) = delete;
         void operator=(const ToyRobot&) = delete;
@@ -106,8 +342,9 @@ namespace object
         /**
          * @brief logic to rotate robot transform
          * @param bool flag to indicate direction to rotate
+         * @return true if the robot rotated
         */
-        void _rotate(bool _clockWise);
+        bool _rotate(bool _clockWise);
 
         /**
          * @brief builds action and lambda map for robot
@@ -118,26 +355,30 @@ namespace object
 
         /**
          * @brief moves robot 1 unit in the direct it is facing
+         * @return true if the robot moved
         */
-        void move();
+        bool move();
 
         /**
          * @brief rotates robot to the left/anti-clockwise direction
+         * @return true if the robot rotated
         */
-        void rotateLeft();
+        bool rotateLeft();
 
         /**
          * @brief rotates robot to the right/clockwise direction
+         * @return true if the robot rotated
         */
-        void rotateRight();
+        bool rotateRight();
 
         /**
          * @brief places the robot at a specific location on the table top
          * @param uint8_t x axis on table top
          * @param uint8_t y axis on table top
          * @param HEADING direction to face
+         * @return true if the robot was placed
         */
-        void placeHere(const uint8_t _x, const uint8_t _y, const type::HEADING _rotation);
+        bool placeHere(const uint8_t _x, const uint8_t _y, const type::HEADING _rotation);
 
         /**
          * @brief get the tabl top position of the robot
@@ -156,6 +397,115 @@ namespace object
          * @return string form of the global position
         */
         const std::string getReport();
+
+        /**
+         * @brief run a pre-parsed command, same behaviour as the action map
+         * @param _command command from parseCommand
+         * @return true if the command was accepted
+        */
+        virtual bool execute(const type::Command& _command) override;
+
+        /**
+         * @brief copy the robot state
+         * @return state that can be restored into any robot
+        */
+        Snapshot snapshot() const
+        {
+            return Snapshot{ m_transform, m_hasBeenPlaced };
+        };
+
+        /**
+         * @brief overwrite the robot state, listeners and callbacks are kept and the history is cleared
+         * @brief this is how robots are forked: restore a snapshot into an already built robot
+         * @param _snapshot state to apply
+        */
+        void restore(const Snapshot& _snapshot)
+        {
+            m_transform = _snapshot.m_transform;
+            m_hasBeenPlaced = _snapshot.m_hasBeenPlaced;
+            m_historyCursor = 0;
+            m_history[0] = _snapshot;
+            m_undoCount = 0;
+            m_redoCount = 0;
+        };
+
+        /**
+         * @brief return to the state of a new robot without rebuilding the action map
+         * @brief the robot is unplaced, its history, macros, listeners and report callback are cleared and the UNDO depth
+         *        goes back to DEFAULT_HISTORY_CAPACITY. the obstacle map is kept
+        */
+        void reset();
+
+        /**
+         * @brief define or replace a macro, also available as "DEFINE name body" through proccessInput
+         * @param _name macro name, without spaces
+         * @param _body ";" separated PLACE, MOVE, LEFT, RIGHT and "CALL name" commands
+         * @return false if the body holds anything else, the macro is then not defined
+        */
+        bool define(std::string_view _name, std::string_view _body);
+
+        /**
+         * @brief run a macro as one command, also available as "CALL name" through proccessInput
+         * @brief the body is composed into one transition over every robot state the first time it is called
+         *        and cached until a macro is defined or the obstacles change, so a call costs the same however
+         *        long the body is. the result matches running the body command by command, but the call is a
+         *        single UNDO step and listeners see one CALL
+         * @param _name macro to run
+         * @return true if the robot state changed
+        */
+        bool call(std::string_view _name);
+
+        /**
+         * @brief step back to the state before the last accepted command
+         * @return false if there is nothing left to undo
+        */
+        bool undo();
+
+        /**
+         * @brief re-apply the last undone command
+         * @return false if there is nothing to redo
+        */
+        bool redo();
+
+        /**
+         * @brief resize the UNDO/REDO ring, this is the only place it allocates and it clears the history
+         * @param _capacity amount of commands that can be undone, 0 disables UNDO
+        */
+        void setHistoryCapacity(const size_t _capacity);
+
+        /**
+         * @brief accessors for history depth
+        */
+        size_t getHistoryCapacity() const { return m_history.size() - 1; };
+        size_t getUndoCount() const { return m_undoCount; };
+        size_t getRedoCount() const { return m_redoCount; };
+
+        /**
+         * @brief check if this robot has been placed
+        */
+        bool isPlaced() const { return m_hasBeenPlaced; };
+
+        /**
+         * @brief register an observer notified after every command
+         * @param _listener observer to add, not owned
+        */
+        void addListener(TransformListener* _listener);
+
+        /**
+         * @brief unregister an observer
+         * @param _listener observer to remove
+        */
+        void removeListener(TransformListener* _listener);
+
+        /**
+         * @brief redirect REPORT output
+         * @param _callback receives each report string, empty to print to the window
+        */
+        void setReportCallback(std::function<void(const std::string&)> _callback)
+        {
+            m_reportCallback = std::move(_callback);
+        };
+        const std::function<void(const std::string&)>& getReportCallback() const { return m_reportCallback; };
     };
 
     /**
@@ -169,13 +519,22 @@ namespace object
         const unsigned m_axisY;
         /// ownership of player toy robot
         std::unique_ptr<object::ToyRobot> m_toyRobot;
+        /// ownership of static obstacles
+        std::unique_ptr<object::ObstacleMap> m_obstacles;
+        /// ownership of the compact robot fleet
+        std::unique_ptr<object::Fleet> m_fleet;
 
     public:
         TableTop(const unsigned _x, const unsigned _y)
             :   m_axisX(_x), 
                 m_axisY(_y), 
-                m_toyRobot(std::make_unique<object::ToyRobot>())
-        {};
+                m_toyRobot(std::make_unique<object::ToyRobot>()),
+                m_obstacles(std::make_unique<object::ObstacleMap>()),
+                m_fleet(std::make_unique<object::Fleet>(_x, _y))
+        {
+            m_toyRobot->setObstacleMap(m_obstacles.get());
+            m_fleet->setObstacleMap(m_obstacles.get());
+        };
 
         /**
          * @brief accessors for X and Y boundries
@@ -192,6 +551,24 @@ namespace object
         {
             return *m_toyRobot.get();
         };
+
+        /**
+         * @brief accessors for static obstacles
+         * @return ObstacleMap refference to table top obstacles
+        */
+        object::ObstacleMap& getObstacles() const
+        {
+            return *m_obstacles.get();
+        };
+
+        /**
+         * @brief accessors for the robot fleet
+         * @return Fleet refference to table top fleet
+        */
+        object::Fleet& getFleet() const
+        {
+            return *m_fleet.get();
+        };
     };
 }
 
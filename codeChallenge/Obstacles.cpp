@@ -0,0 +1,180 @@
+#include "Obstacles.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+
+namespace object
+{
+    void ObstacleMap::_promote(Tile& _tile)
+    {
+        _tile.m_bitmap.assign(TILE_WORDS, 0);
+        for(const uint16_t cell : _tile.m_cells)
+            _tile.m_bitmap[cell >> 6] |= (uint64_t(1) << (cell & 63));
+        // release sparse storage
+        std::vector<uint16_t>().swap(_tile.m_cells);
+    }
+
+    bool ObstacleMap::addObstacle(const uint32_t _x, const uint32_t _y)
+    {
+        ++m_version;
+        Tile& tile = m_tiles[_tileKey(_x, _y)];
+        const uint16_t local = _localIndex(_x, _y);
+        // dense tile, set bit
+        if(!tile.m_bitmap.empty())
+        {
+            uint64_t& word = tile.m_bitmap[local >> 6];
+            const uint64_t bit = uint64_t(1) << (local & 63);
+            if(word & bit)
+                return false;
+            word |= bit;
+            ++m_count;
+            return true;
+        }
+        // sparse tile, keep cells sorted
+        auto itr = std::lower_bound(tile.m_cells.begin(), tile.m_cells.end(), local);
+        if(itr != tile.m_cells.end() && *itr == local)
+            return false;
+        tile.m_cells.insert(itr, local);
+        ++m_count;
+        if(tile.m_cells.size() > SPARSE_LIMIT)
+            _promote(tile);
+        return true;
+    }
+
+    void ObstacleMap::addObstacles(std::vector<std::pair<uint32_t, uint32_t>> _cells)
+    {
+        ++m_version;
+        // group by tile then local index so each tile is touched once
+        std::sort(_cells.begin(), _cells.end(), [](const auto& _a, const auto& _b)
+        {
+            const uint32_t keyA = _tileKey(_a.first, _a.second);
+            const uint32_t keyB = _tileKey(_b.first, _b.second);
+            if(keyA != keyB)
+                return keyA < keyB;
+            return _localIndex(_a.first, _a.second) < _localIndex(_b.first, _b.second);
+        });
+        size_t begin = 0;
+        while(begin < _cells.size())
+        {
+            const uint32_t key = _tileKey(_cells[begin].first, _cells[begin].second);
+            size_t end = begin;
+            while(end < _cells.size() && _tileKey(_cells[end].first, _cells[end].second) == key)
+                ++end;
+            // tile already exists, fall back to single inserts
+            if(m_tiles.count(key) != 0)
+            {
+                for(size_t i = begin; i < end; ++i)
+                    addObstacle(_cells[i].first, _cells[i].second);
+                begin = end;
+                continue;
+            }
+            Tile& tile = m_tiles[key];
+            tile.m_cells.reserve(end - begin);
+            for(size_t i = begin; i < end; ++i)
+            {
+                const uint16_t local = _localIndex(_cells[i].first, _cells[i].second);
+                if(tile.m_cells.empty() || tile.m_cells.back() != local)
+                    tile.m_cells.push_back(local);
+            }
+            m_count += tile.m_cells.size();
+            if(tile.m_cells.size() > SPARSE_LIMIT)
+                _promote(tile);
+            else
+                tile.m_cells.shrink_to_fit();
+            begin = end;
+        }
+    }
+
+    long ObstacleMap::loadFromFile(const std::string& _path)
+    {
+        std::ifstream file(_path);
+        if(!file.is_open())
+            return -1;
+        std::vector<std::pair<uint32_t, uint32_t>> cells;
+        std::string line;
+        // accept both new line and "|" separated cells
+        while(std::getline(file, line))
+        {
+            if(line.empty() || line[0] == '#')
+                continue;
+            size_t start = 0;
+            while(start < line.size())
+            {
+                size_t end = line.find('|', start);
+                if(end == std::string::npos)
+                    end = line.size();
+                // parse "x,y", both fields need digits and must fit in 32 bits
+                uint32_t values[2] = {0, 0};
+                uint32_t digits[2] = {0, 0};
+                unsigned index = 0;
+                bool isValid = end > start;
+                for(size_t i = start; i < end && isValid; ++i)
+                {
+                    const char c = line[i];
+                    if(c == ',')
+                        isValid = ++index < 2;
+                    else if(std::isdigit(static_cast<unsigned char>(c)))
+                    {
+                        const uint32_t digit = uint32_t(c - '0');
+                        isValid = values[index] <= (UINT32_MAX - digit) / 10;
+                        values[index] = values[index] * 10 + digit;
+                        ++digits[index];
+                    }
+                    else if(!std::isspace(static_cast<unsigned char>(c)))
+                        isValid = false;
+                }
+                if(isValid && index == 1 && digits[0] > 0 && digits[1] > 0)
+                    cells.emplace_back(values[0], values[1]);
+                start = end + 1;
+            }
+        }
+        const long loaded = long(cells.size());
+        addObstacles(std::move(cells));
+        return loaded;
+    }
+
+    size_t ObstacleMap::denseTileCount() const
+    {
+        size_t count = 0;
+        for(const auto& tile : m_tiles)
+            count += tile.second.m_bitmap.empty() ? 0 : 1;
+        return count;
+    }
+
+    uint64_t ObstacleMap::contentHash() const
+    {
+        // order independent sum of mixed cells, tiles are not iterated in a stable order
+        auto mix = [](uint64_t _value)
+        {
+            _value ^= _value >> 33;
+            _value *= 0xff51afd7ed558ccdull;
+            _value ^= _value >> 33;
+            _value *= 0xc4ceb9fe1a85ec53ull;
+            return _value ^ (_value >> 33);
+        };
+        uint64_t hash = m_count;
+        for(const auto& tile : m_tiles)
+        {
+            const uint64_t key = uint64_t(tile.first) << 16;
+            for(const uint16_t cell : tile.second.m_cells)
+                hash += mix(key | cell);
+            for(uint32_t word = 0; word < tile.second.m_bitmap.size(); ++word)
+                for(uint64_t bits = tile.second.m_bitmap[word]; bits != 0; bits &= bits - 1)
+                    hash += mix(key | (word << 6) | uint32_t(__builtin_ctzll(bits)));
+        }
+        return hash;
+    }
+
+    size_t ObstacleMap::memoryUsage() const
+    {
+        // approximate, node and bucket overhead of the hash map included
+        size_t bytes = m_tiles.bucket_count() * sizeof(void*);
+        for(const auto& tile : m_tiles)
+        {
+            bytes += sizeof(tile) + 2 * sizeof(void*);
+            bytes += tile.second.m_cells.capacity() * sizeof(uint16_t);
+            bytes += tile.second.m_bitmap.capacity() * sizeof(uint64_t);
+        }
+        return bytes;
+    }
+}
@@ -0,0 +1,179 @@
+#ifndef OBSTACLES_H
+#define OBSTACLES_H
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace object
+{
+
+    /**
+     * Sparse static obstacle layer
+     * @brief   the table top is split into 64x64 tiles. only tiles holding obstacles are stored,
+     *          so an empty tile costs nothing. a tile keeps a small sorted list of blocked cells
+     *          until it passes SPARSE_LIMIT and is then promoted to a 512 byte bitmap.
+     *          a lookup is one hash probe plus either a bit test or a scan of at most SPARSE_LIMIT cells
+    */
+    class ObstacleMap
+    {
+    public:
+        /// tile edge is 2^TILE_BITS cells
+        static constexpr uint32_t TILE_BITS = 6;
+        static constexpr uint32_t TILE_SIZE = 1u << TILE_BITS;
+        static constexpr uint32_t TILE_MASK = TILE_SIZE - 1;
+        /// amount of 64 bit words in a dense tile bitmap
+        static constexpr uint32_t TILE_WORDS = (TILE_SIZE * TILE_SIZE) / 64;
+        /// cell count at which a sparse tile becomes a bitmap
+        static constexpr uint32_t SPARSE_LIMIT = 32;
+
+    private:
+        /**
+         * single 64x64 tile
+         * @brief only one of m_cells or m_bitmap is populated at a time
+        */
+        struct Tile
+        {
+            /// sorted local cell indices (y * TILE_SIZE + x) while sparse
+            std::vector<uint16_t> m_cells;
+            /// one bit per cell once dense
+            std::vector<uint64_t> m_bitmap;
+        };
+
+        /// tiles keyed by packed tile x/y
+        std::unordered_map<uint32_t, Tile> m_tiles;
+        /// total amount of blocked cells
+        size_t m_count = 0;
+        /// bumped on every change so cached results can tell they are stale
+        uint64_t m_version = 0;
+
+        /**
+         * @brief pack tile coordinates of a cell into a map key
+        */
+        static uint32_t _tileKey(const uint32_t _x, const uint32_t _y)
+        {
+            return ((_y >> TILE_BITS) << 16) | (_x >> TILE_BITS);
+        }
+
+        /**
+         * @brief index of a cell inside its tile
+        */
+        static uint16_t _localIndex(const uint32_t _x, const uint32_t _y)
+        {
+            return uint16_t(((_y & TILE_MASK) << TILE_BITS) | (_x & TILE_MASK));
+        }
+
+        /**
+         * @brief convert a sparse tile to a bitmap tile
+        */
+        static void _promote(Tile& _tile);
+
+    public:
+        ObstacleMap(){};
+
+        /**
+         * @brief block a single cell
+         * @param _x x axis of cell
+         * @param _y y axis of cell
+         * @return true if the cell was not already blocked
+        */
+        bool addObstacle(const uint32_t _x, const uint32_t _y);
+
+        /**
+         * @brief block many cells at once
+         * @brief cells are grouped per tile first so each tile is built in a single pass
+         * @param _cells x/y pairs to block, duplicates are ignored
+        */
+        void addObstacles(std::vector<std::pair<uint32_t, uint32_t>> _cells);
+
+        /**
+         * @brief load obstacles from a text file
+         * @brief one "x,y" cell per line or separated by "|", lines starting with "#" are ignored.
+         *        cells with an empty field, a value past 32 bits or anything but digits are skipped
+         * @param _path path to the obstacle file
+         * @return amount of cells read from the file, -1 if it could not be opened
+        */
+        long loadFromFile(const std::string& _path);
+
+        /**
+         * @brief check if a cell is blocked
+         * @param _x x axis of cell
+         * @param _y y axis of cell
+         * @return true if the cell holds an obstacle
+        */
+        bool isBlocked(const uint32_t _x, const uint32_t _y) const
+        {
+            // fast exit for tables without obstacles
+            if(m_tiles.empty())
+                return false;
+            auto itr = m_tiles.find(_tileKey(_x, _y));
+            if(itr == m_tiles.cend())
+                return false;
+            const Tile& tile = itr->second;
+            const uint16_t local = _localIndex(_x, _y);
+            if(!tile.m_bitmap.empty())
+                return (tile.m_bitmap[local >> 6] >> (local & 63)) & 1u;
+            for(const uint16_t cell : tile.m_cells)
+            {
+                if(cell >= local)
+                    return cell == local;
+            }
+            return false;
+        }
+
+        /**
+         * @brief remove all obstacles
+        */
+        void clear() { m_tiles.clear(); m_count = 0; ++m_version; };
+
+        /**
+         * @brief accessors for layer statistics
+        */
+        size_t size() const { return m_count; };
+        uint64_t getVersion() const { return m_version; };
+
+        /**
+         * @brief hash of the blocked cells, equal for equal layers however they were built
+        */
+        uint64_t contentHash() const;
+        size_t tileCount() const { return m_tiles.size(); };
+        size_t denseTileCount() const;
+        size_t memoryUsage() const;
+    };
+
+    /**
+     * Dense obstacle bitmap
+     * @brief one bit per cell over the whole table. used as the lookup baseline for ObstacleMap
+    */
+    class DenseObstacleMap
+    {
+        /// cells per row
+        const uint32_t m_width;
+        /// one bit per cell
+        std::vector<uint64_t> m_bits;
+
+    public:
+        DenseObstacleMap(const uint32_t _width, const uint32_t _height)
+            :   m_width(_width),
+                m_bits(((uint64_t(_width) * _height) + 63) / 64, 0)
+        {};
+
+        void addObstacle(const uint32_t _x, const uint32_t _y)
+        {
+            const uint64_t bit = uint64_t(_y) * m_width + _x;
+            m_bits[bit >> 6] |= (uint64_t(1) << (bit & 63));
+        }
+
+        bool isBlocked(const uint32_t _x, const uint32_t _y) const
+        {
+            const uint64_t bit = uint64_t(_y) * m_width + _x;
+            return (m_bits[bit >> 6] >> (bit & 63)) & 1u;
+        }
+
+        size_t memoryUsage() const { return m_bits.size() * sizeof(uint64_t); };
+    };
+}
+
+#endif  // OBSTACLES_H
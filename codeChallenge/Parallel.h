@@ -0,0 +1,51 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace object
+{
+    /**
+     * @brief amount of worker threads to use when none is requested
+     * @return hardware concurrency, at least 1
+    */
+    inline unsigned defaultThreadCount()
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /**
+     * @brief run a task for every index on a set of worker threads
+     * @brief indices are handed out one at a time from a shared counter so uneven tasks balance out.
+     *        the calling thread acts as worker 0, so a single worker never spawns a thread
+     * @param _count amount of indices to process
+     * @param _threadCount maximum amount of workers, 0 for defaultThreadCount()
+     * @param _task called with the index and the worker running it, worker is below the returned value
+     * @return amount of workers used
+    */
+    inline unsigned parallelFor(const size_t _count, unsigned _threadCount, const std::function<void(size_t, unsigned)>& _task)
+    {
+        if(_threadCount == 0)
+            _threadCount = defaultThreadCount();
+        const unsigned workerCount = unsigned(std::max<size_t>(1, std::min<size_t>(_count, _threadCount)));
+        std::atomic<size_t> next(0);
+        auto worker = [&](const unsigned _worker)
+        {
+            for(size_t index = next++; index < _count; index = next++)
+                _task(index, _worker);
+        };
+        std::vector<std::thread> threads;
+        for(unsigned i = 1; i < workerCount; ++i)
+            threads.emplace_back(worker, i);
+        worker(0);
+        for(auto& thread : threads)
+            thread.join();
+        return workerCount;
+    }
+}
+
+#endif  // PARALLEL_H
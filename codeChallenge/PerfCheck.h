@@ -0,0 +1,398 @@
+#ifndef PERF_CHECK_H
+#define PERF_CHECK_H
+
+#include "Objects.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef PERF_BASELINE_PATH
+#define PERF_BASELINE_PATH "perf_baseline.json"
+#endif
+
+
+/**
+ * Fraction a perf check result may exceed its scaled baseline by, negative values are unset
+*/
+struct PerfTolerance
+{
+    double m_median = -1;
+    double m_p99 = -1;
+};
+
+/**
+ * Performance regression gate
+ * @brief   runs fixed throughput scenarios through ToyRobot::proccessInput, timing many equal slices of each
+ *          to get a median and p99 cost per command. results are compared against a baseline JSON file.
+ *          baselines hold a calibration time of a fixed integer loop, and are scaled by the ratio of the
+ *          current calibration to the stored one so a baseline recorded on one machine stays usable on another.
+ *          the best of several rounds is gated, with the tolerance widened by the spread between rounds, and a
+ *          scenario over its limit is measured again before it counts as a regression
+*/
+class PerfCheck
+{
+public:
+    /// exit codes of run()
+    enum RESULT
+    {
+        PASSED      = 0,
+        REGRESSED   = 1,
+        NO_BASELINE = 2
+    };
+
+private:
+    /// commands timed per sample
+    static constexpr uint32_t SLICE = 5000;
+    /// samples per round
+    static constexpr uint32_t SAMPLES = 101;
+    /// rounds per scenario, the least disturbed round is kept
+    static constexpr uint32_t ROUNDS = 3;
+    /// a scenario over its limit is measured again in more rounds, up to this many in total
+    static constexpr uint32_t MAX_ROUNDS = 12;
+
+    struct Scenario
+    {
+        const char* m_name;
+        /// percent of PLACE, MOVE and REPORT commands, LEFT and RIGHT share the rest
+        uint32_t m_place;
+        uint32_t m_move;
+        uint32_t m_report;
+    };
+
+    struct Result
+    {
+        double m_median = 0;
+        double m_p99 = 0;
+        /// how far the median round was above the best one, as a fraction of the best
+        double m_spread = 0;
+    };
+
+    /// results are folded into this so the compiler keeps the measured work
+    volatile uint64_t m_sink = 0;
+
+    static const std::vector<Scenario>& _scenarios()
+    {
+        static const std::vector<Scenario> scenarios =
+        {
+            { "place_heavy",  80, 10, 5 },
+            { "move_heavy",   5,  80, 5 },
+            { "report_heavy", 5,  25, 60 },
+            { "mixed",        5,  55, 10 }
+        };
+        return scenarios;
+    }
+
+    /**
+     * @brief build a script following a scenario mix, the first command is always a PLACE
+    */
+    static std::vector<std::string> _buildScript(const Scenario& _scenario, const uint32_t _count)
+    {
+        static const char* const headings[] = { "NORTH", "EAST", "SOUTH", "WEST" };
+        std::mt19937 random(37);
+        std::vector<std::string> script;
+        script.reserve(_count);
+        for(uint32_t i = 0; i < _count; ++i)
+        {
+            const uint32_t roll = random() % 100;
+            if(i == 0 || roll < _scenario.m_place)
+                script.push_back("PLACE " + std::to_string(random() % (TABLE_TOP_X + 1)) + ","
+                    + std::to_string(random() % (TABLE_TOP_Y + 1)) + "," + headings[random() % 4]);
+            else if(roll < _scenario.m_place + _scenario.m_move)
+                script.push_back("MOVE");
+            else if(roll < _scenario.m_place + _scenario.m_move + _scenario.m_report)
+                script.push_back("REPORT");
+            else
+                script.push_back(random() % 2 ? "LEFT" : "RIGHT");
+        }
+        return script;
+    }
+
+    /**
+     * @brief nearest rank percentile of sorted samples
+    */
+    static double _percentile(const std::vector<double>& _sorted, const double _percent)
+    {
+        const size_t rank = size_t(std::ceil(_percent / 100.0 * double(_sorted.size())));
+        return _sorted[std::min(_sorted.size(), std::max<size_t>(rank, 1)) - 1];
+    }
+
+    /**
+     * @brief time more rounds of one scenario, keeping the lowest median and p99 of every round so far
+     * @brief a p99 of 101 samples is a single sample, so one preemption would otherwise decide the result
+     * @param _rounds rounds measured so far, the new ones are appended
+    */
+    Result _measure(const Scenario& _scenario, std::vector<Result>& _rounds, const uint32_t _count = ROUNDS)
+    {
+        for(uint32_t round = 0; round < _count; ++round)
+            _rounds.push_back(_measureRound(_scenario));
+        Result best = _rounds[0];
+        std::vector<double> medians;
+        for(const Result& round : _rounds)
+        {
+            best.m_median = std::min(best.m_median, round.m_median);
+            best.m_p99 = std::min(best.m_p99, round.m_p99);
+            medians.push_back(round.m_median);
+        }
+        std::nth_element(medians.begin(), medians.begin() + medians.size() / 2, medians.end());
+        best.m_spread = best.m_median > 0 ? medians[medians.size() / 2] / best.m_median - 1.0 : 0.0;
+        return best;
+    }
+
+    /**
+     * @brief time one round of a scenario
+    */
+    Result _measureRound(const Scenario& _scenario)
+    {
+        const std::vector<std::string> script = _buildScript(_scenario, SLICE);
+        object::ToyRobot robot;
+        uint64_t reportBytes = 0;
+        robot.setReportCallback([&](const std::string& _report){ reportBytes += _report.size(); });
+        // warm up caches and the allocator
+        for(const std::string& command : script)
+            robot.proccessInput(command);
+        std::vector<double> samples;
+        samples.reserve(SAMPLES);
+        for(uint32_t sample = 0; sample < SAMPLES; ++sample)
+        {
+            const auto start(std::chrono::steady_clock::now());
+            for(const std::string& command : script)
+                robot.proccessInput(command);
+            const auto end(std::chrono::steady_clock::now());
+            samples.push_back(double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / SLICE);
+        }
+        m_sink = m_sink + reportBytes;
+        std::sort(samples.begin(), samples.end());
+        return Result{ _percentile(samples, 50), _percentile(samples, 99) };
+    }
+
+    /**
+     * @brief time a fixed integer workload, used to scale baselines between machines
+     * @brief the fastest sample is kept, it is the one least disturbed by other processes
+     * @return ns per loop
+    */
+    double _calibrate()
+    {
+        const uint32_t LOOPS = 1 << 20;
+        std::vector<double> samples;
+        for(uint32_t sample = 0; sample < 31; ++sample)
+        {
+            const auto start(std::chrono::steady_clock::now());
+            uint64_t state = 88172645463325252ull + sample;
+            for(uint32_t i = 0; i < LOOPS; ++i)
+            {
+                // xorshift keeps every iteration dependent on the last
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+            }
+            const auto end(std::chrono::steady_clock::now());
+            m_sink = m_sink + state;
+            samples.push_back(double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / LOOPS);
+        }
+        return *std::min_element(samples.begin(), samples.end());
+    }
+
+    /**
+     * @brief true when built with optimisation, baselines from other build types are not comparable
+    */
+    static bool _isOptimised()
+    {
+#ifdef __OPTIMIZE__
+        return true;
+#else
+        return false;
+#endif
+    }
+
+public:
+    PerfCheck(){}
+
+    /**
+     * @brief read every number of a JSON document, keyed by its dotted object path
+     * @brief only objects, numbers and strings are accepted, string values are skipped
+     * @return false if the document is malformed or holds an array, true, false or null
+    */
+    static bool parseJson(const std::string& _text, std::map<std::string, double>& _values)
+    {
+        size_t i = 0;
+        auto skipSpace = [&](){ while(i < _text.size() && std::isspace((unsigned char)_text[i])) ++i; };
+        auto readString = [&](std::string& _out)
+        {
+            if(_text[i] != '"')
+                return false;
+            const size_t end = _text.find('"', i + 1);
+            if(end == std::string::npos)
+                return false;
+            _out = _text.substr(i + 1, end - i - 1);
+            i = end + 1;
+            return true;
+        };
+        std::vector<std::string> path;
+        skipSpace();
+        if(i >= _text.size() || _text[i] != '{')
+            return false;
+        ++i;
+        path.emplace_back();
+        while(!path.empty())
+        {
+            skipSpace();
+            if(i >= _text.size())
+                return false;
+            if(_text[i] == ',')
+            {
+                ++i;
+                continue;
+            }
+            if(_text[i] == '}')
+            {
+                ++i;
+                path.pop_back();
+                continue;
+            }
+            std::string key;
+            if(!readString(key))
+                return false;
+            skipSpace();
+            if(i >= _text.size() || _text[i] != ':')
+                return false;
+            ++i;
+            skipSpace();
+            const std::string fullKey = path.back().empty() ? key : path.back() + "." + key;
+            if(i >= _text.size())
+                return false;
+            if(_text[i] == '{')
+            {
+                ++i;
+                path.push_back(fullKey);
+            }
+            else if(_text[i] == '"')
+            {
+                std::string ignored;
+                if(!readString(ignored))
+                    return false;
+            }
+            else
+            {
+                char* end = nullptr;
+                const double value = strtod(_text.c_str() + i, &end);
+                if(end == _text.c_str() + i)
+                    return false;
+                _values[fullKey] = value;
+                i = size_t(end - _text.c_str());
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief run every scenario and record the results as a new baseline
+     * @param _path baseline file to write
+     * @param _tolerance tolerances stored with the baseline, negative values use 20% for median and 40% for p99
+     * @return PASSED, or NO_BASELINE if the file cannot be written
+    */
+    int writeBaseline(const std::string& _path, const PerfTolerance& _tolerance = PerfTolerance())
+    {
+        const double calibration = _calibrate();
+        std::ostringstream json;
+        json << "{\n";
+        json << "    \"optimised\": " << (_isOptimised() ? 1 : 0) << ",\n";
+        json << "    \"calibration_ns\": " << calibration << ",\n";
+        json << "    \"tolerance\": { \"median\": " << (_tolerance.m_median < 0 ? 0.20 : _tolerance.m_median)
+            << ", \"p99\": " << (_tolerance.m_p99 < 0 ? 0.40 : _tolerance.m_p99) << " },\n";
+        json << "    \"scenarios\": {\n";
+        const auto& scenarios = _scenarios();
+        for(size_t i = 0; i < scenarios.size(); ++i)
+        {
+            std::vector<Result> rounds;
+            const Result result = _measure(scenarios[i], rounds);
+            printf("PERF: %-14s median %8.2f ns  p99 %8.2f ns\n", scenarios[i].m_name, result.m_median, result.m_p99);
+            json << "        \"" << scenarios[i].m_name << "\": { \"median_ns\": " << result.m_median
+                << ", \"p99_ns\": " << result.m_p99 << " }" << (i + 1 < scenarios.size() ? "," : "") << "\n";
+        }
+        json << "    }\n}\n";
+        std::ofstream file(_path);
+        file << json.str();
+        if(!file)
+        {
+            printf("PERF: could not write baseline %s\n", _path.c_str());
+            return NO_BASELINE;
+        }
+        printf("PERF: baseline written to %s\n", _path.c_str());
+        return PASSED;
+    }
+
+    /**
+     * @brief run every scenario and compare against a baseline
+     * @param _path baseline file to read
+     * @param _tolerance overrides the tolerances stored in the baseline when not negative
+     * @return PASSED, REGRESSED if any median or p99 exceeds its tolerance, NO_BASELINE if the file is unusable
+    */
+    int run(const std::string& _path, const PerfTolerance& _tolerance = PerfTolerance())
+    {
+        std::ifstream file(_path);
+        std::stringstream text;
+        text << file.rdbuf();
+        std::map<std::string, double> baseline;
+        if(!file || !parseJson(text.str(), baseline) || baseline.count("calibration_ns") == 0)
+        {
+            printf("PERF: could not read baseline %s\n", _path.c_str());
+            return NO_BASELINE;
+        }
+        if((baseline["optimised"] != 0) != _isOptimised())
+        {
+            printf("PERF: baseline %s was recorded with a%s build, rebuild to match or record a new baseline\n",
+                _path.c_str(), baseline["optimised"] != 0 ? "n optimised" : " debug");
+            return NO_BASELINE;
+        }
+        const double medianTolerance = _tolerance.m_median >= 0 ? _tolerance.m_median : baseline["tolerance.median"];
+        const double p99Tolerance = _tolerance.m_p99 >= 0 ? _tolerance.m_p99 : baseline["tolerance.p99"];
+        const double calibration = _calibrate();
+        const double scale = calibration / baseline["calibration_ns"];
+        printf("PERF: machine speed %.2fx the baseline machine, tolerance median %.0f%% p99 %.0f%%\n",
+            1.0 / scale, medianTolerance * 100.0, p99Tolerance * 100.0);
+
+        int result = PASSED;
+        for(const Scenario& scenario : _scenarios())
+        {
+            const std::string key = std::string("scenarios.") + scenario.m_name;
+            if(baseline.count(key + ".median_ns") == 0 || baseline.count(key + ".p99_ns") == 0)
+            {
+                printf("PERF: %-14s missing from baseline\n", scenario.m_name);
+                result = NO_BASELINE;
+                continue;
+            }
+            // the tolerance widens by the spread between rounds, so a noisy machine does not fail on noise alone.
+            // a scenario over its limit is measured in more rounds before it counts as a regression
+            std::vector<Result> rounds;
+            Result measured;
+            double medianLimit = 0;
+            double p99Limit = 0;
+            bool hasPassed = false;
+            while(!hasPassed && rounds.size() < MAX_ROUNDS)
+            {
+                measured = _measure(scenario, rounds);
+                medianLimit = baseline[key + ".median_ns"] * scale * (1.0 + medianTolerance + measured.m_spread);
+                p99Limit = baseline[key + ".p99_ns"] * scale * (1.0 + p99Tolerance + measured.m_spread);
+                hasPassed = measured.m_median <= medianLimit && measured.m_p99 <= p99Limit;
+            }
+            printf("PERF: %-14s median %8.2f ns (limit %8.2f)  p99 %8.2f ns (limit %8.2f)  spread %4.1f%% over %2lu rounds  %s\n",
+                scenario.m_name, measured.m_median, medianLimit, measured.m_p99, p99Limit, measured.m_spread * 100.0,
+                (unsigned long)rounds.size(), hasPassed ? "PASS" : "REGRESSION");
+            if(!hasPassed && result == PASSED)
+                result = REGRESSED;
+        }
+        printf("PERF: %s\n", result == PASSED ? "PASSED" : (result == REGRESSED ? "REGRESSED" : "INCOMPLETE BASELINE"));
+        return result;
+    }
+};
+
+#endif // PERF_CHECK_H
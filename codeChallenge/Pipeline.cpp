@@ -0,0 +1,180 @@
+#include "Pipeline.h"
+#include "SpscQueue.h"
+#include "Tokenizer.h"
+#include "Trace.h"
+#include <chrono>
+#include <thread>
+
+namespace object
+{
+    namespace
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        /**
+         * @brief seconds between two time points
+        */
+        double _seconds(const Clock::time_point& _start, const Clock::time_point& _end)
+        {
+            return std::chrono::duration<double>(_end - _start).count();
+        }
+
+        /**
+         * @brief push an item, adding any time spent blocked to _waitSeconds
+        */
+        template <typename T>
+        void _timedPush(SpscQueue<T>& _queue, T& _item, double& _waitSeconds)
+        {
+            if(_queue.tryPush(_item))
+                return;
+            const auto start = Clock::now();
+            while(!_queue.tryPush(_item))
+                std::this_thread::yield();
+            _waitSeconds += _seconds(start, Clock::now());
+        }
+
+        /**
+         * @brief pop an item, adding any time spent blocked to _waitSeconds
+        */
+        template <typename T>
+        bool _timedPop(SpscQueue<T>& _queue, T& _item, double& _waitSeconds)
+        {
+            if(_queue.tryPop(_item))
+                return true;
+            const auto start = Clock::now();
+            const bool hasItem = _queue.pop(_item);
+            _waitSeconds += _seconds(start, Clock::now());
+            return hasItem;
+        }
+    }
+
+    void PipelineStats::print() const
+    {
+        printf("\nPIPELINE: %lu commands (%lu accepted, %lu rejected) in %.3f s, %.0f commands/s\n",
+            (unsigned long)m_commands, (unsigned long)m_accepted, (unsigned long)m_rejected, m_wallSeconds,
+            m_wallSeconds > 0 ? double(m_commands) / m_wallSeconds : 0.0);
+        for(const Stage* stage : { &m_reader, &m_parser, &m_executor })
+        {
+            const double utilisation = m_wallSeconds > 0 ? stage->m_busySeconds * 100.0 / m_wallSeconds : 0.0;
+            printf("PIPELINE: %-8s busy %8.3f s  waiting %8.3f s  utilisation %5.1f%%  items %lu\n",
+                stage->m_name, stage->m_busySeconds, stage->m_waitSeconds, utilisation, (unsigned long)stage->m_items);
+        }
+    }
+
+    PipelineStats Pipeline::run(std::istream& _input, InputHandler& _handler) const
+    {
+        PipelineStats stats;
+        stats.m_reader.m_name = "reader";
+        stats.m_parser.m_name = "parser";
+        stats.m_executor.m_name = "executor";
+        SpscQueue<std::string> chunks(m_config.m_queueDepth);
+        SpscQueue<std::vector<type::Command>> batches(m_config.m_queueDepth);
+        uint64_t parseFailures = 0;
+        const auto start = Clock::now();
+
+        // reader stage, raw bytes only
+        std::thread reader([&]()
+        {
+            Tracer::setThreadName("reader");
+            PipelineStats::Stage& stage = stats.m_reader;
+            const auto stageStart = Clock::now();
+            while(_input.good())
+            {
+                std::string chunk;
+                {
+                    TraceSpan span("read");
+                    if(m_config.m_chunkSize == 0)
+                    {
+                        if(!std::getline(_input, chunk))
+                            break;
+                        chunk.push_back('\n');
+                    }
+                    else
+                    {
+                        chunk.resize(m_config.m_chunkSize);
+                        _input.read(&chunk[0], std::streamsize(chunk.size()));
+                        chunk.resize(size_t(_input.gcount()));
+                        if(chunk.empty())
+                            break;
+                    }
+                }
+                ++stage.m_items;
+                _timedPush(chunks, chunk, stage.m_waitSeconds);
+            }
+            chunks.close();
+            stage.m_busySeconds = _seconds(stageStart, Clock::now()) - stage.m_waitSeconds;
+        });
+
+        // parser stage, split on delimiters and parse into batches
+        std::thread parser([&]()
+        {
+            Tracer::setThreadName("parser");
+            PipelineStats::Stage& stage = stats.m_parser;
+            const auto stageStart = Clock::now();
+            std::string chunk;
+            Tokenizer tokenizer;
+            std::vector<type::Command> batch;
+            batch.reserve(m_config.m_batchSize);
+            auto emit = [&](std::string_view _text)
+            {
+                ++stage.m_items;
+                type::Command command;
+                if(!InputHandler::parseCommand(_text, command))
+                {
+                    ++parseFailures;
+                    return;
+                }
+                batch.push_back(command);
+                if(batch.size() >= m_config.m_batchSize)
+                {
+                    _timedPush(batches, batch, stage.m_waitSeconds);
+                    batch.clear();
+                    batch.reserve(m_config.m_batchSize);
+                }
+            };
+            while(_timedPop(chunks, chunk, stage.m_waitSeconds))
+            {
+                TraceSpan span("parse");
+                tokenizer.feed(chunk, emit);
+                // nothing else queued, hand over what we have so the executor is not starved
+                if(!batch.empty() && chunks.isEmpty())
+                {
+                    _timedPush(batches, batch, stage.m_waitSeconds);
+                    batch.clear();
+                    batch.reserve(m_config.m_batchSize);
+                }
+            }
+            tokenizer.finish(emit);
+            if(!batch.empty())
+                _timedPush(batches, batch, stage.m_waitSeconds);
+            batches.close();
+            stage.m_busySeconds = _seconds(stageStart, Clock::now()) - stage.m_waitSeconds;
+        });
+
+        // executor stage on the calling thread
+        {
+            PipelineStats::Stage& stage = stats.m_executor;
+            const auto stageStart = Clock::now();
+            std::vector<type::Command> batch;
+            while(_timedPop(batches, batch, stage.m_waitSeconds))
+            {
+                TraceSpan span("dispatch");
+                for(const type::Command& command : batch)
+                {
+                    if(_handler.execute(command))
+                        ++stats.m_accepted;
+                    else
+                        ++stats.m_rejected;
+                }
+                stage.m_items += batch.size();
+            }
+            stage.m_busySeconds = _seconds(stageStart, Clock::now()) - stage.m_waitSeconds;
+        }
+        reader.join();
+        parser.join();
+        stats.m_wallSeconds = _seconds(start, Clock::now());
+        stats.m_rejected += parseFailures;
+        stats.m_commands = stats.m_parser.m_items;
+        return stats;
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "Objects.h"
+#include <istream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace object
+{
+
+    /**
+     * Timing of one pipeline run
+     * @brief a stage is busy while it works on data and waiting while it is blocked on a queue.
+     *        the stage with the highest utilisation is the bottleneck
+    */
+    struct PipelineStats
+    {
+        struct Stage
+        {
+            const char* m_name = "";
+            double m_busySeconds = 0;
+            double m_waitSeconds = 0;
+            uint64_t m_items = 0;
+        };
+        Stage m_reader;
+        Stage m_parser;
+        Stage m_executor;
+        double m_wallSeconds = 0;
+        /// commands found in the input
+        uint64_t m_commands = 0;
+        /// commands the handler accepted
+        uint64_t m_accepted = 0;
+        /// commands that failed to parse or were rejected by the handler
+        uint64_t m_rejected = 0;
+
+        /**
+         * @brief print utilisation per stage
+        */
+        void print() const;
+    };
+
+    /**
+     * Pipeline tuning
+    */
+    struct PipelineConfig
+    {
+        /// bytes per read, 0 reads one line at a time for interactive input
+        size_t m_chunkSize = 1 << 16;
+        /// commands per batch handed to the executor
+        size_t m_batchSize = 1024;
+        /// chunks or batches each queue can hold
+        size_t m_queueDepth = 8;
+    };
+
+    /**
+     * Three stage command pipeline
+     * @brief   a reader thread pulls raw chunks from the input, a parser thread splits them into commands on
+     *          "|" and new lines and parses them into batches of type::Command, and the calling thread executes
+     *          the batches. stages are joined by bounded SpscQueues so a slow executor stalls the parser and
+     *          the parser stalls the reader, keeping memory bounded
+    */
+    class Pipeline
+    {
+        const PipelineConfig m_config;
+
+    public:
+        Pipeline(const PipelineConfig& _config = PipelineConfig())
+            :   m_config(_config)
+        {};
+
+        /**
+         * @brief run every command of a stream through a handler
+         * @param _input stream to read until end of file
+         * @param _handler robot executing the commands
+         * @return timings and command counts
+        */
+        PipelineStats run(std::istream& _input, InputHandler& _handler) const;
+    };
+}
+
+#endif  // PIPELINE_H
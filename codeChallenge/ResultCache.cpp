@@ -0,0 +1,330 @@
+#include "ResultCache.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdio.h>
+#include <vector>
+
+namespace object
+{
+    namespace
+    {
+        const char FILE_MAGIC[8] = "TRCACHE";
+        const uint32_t FILE_VERSION = 1;
+        const char* const FILE_EXTENSION = ".trc";
+        const uint64_t UNPLACED = ~uint64_t(0);
+
+        /**
+         * fixed part of a result file, the REPORT output follows it
+        */
+        struct FileHeader
+        {
+            char m_magic[8];
+            uint32_t m_version;
+            /// ToyRobot::REPLAY_VERSION of the build that ran the replay
+            uint32_t m_replayVersion;
+            ResultCache::Key m_key;
+            uint64_t m_finalState;
+            uint64_t m_commands;
+            uint64_t m_reportBytes;
+        };
+
+        uint64_t _mix(uint64_t _hash, const uint64_t _word)
+        {
+            _hash ^= _word * 0x9e3779b97f4a7c15ull;
+            _hash = (_hash << 31) | (_hash >> 33);
+            return _hash * 0xbf58476d1ce4e5b9ull;
+        }
+
+        uint64_t _finalise(uint64_t _hash)
+        {
+            _hash ^= _hash >> 33;
+            _hash *= 0xff51afd7ed558ccdull;
+            _hash ^= _hash >> 33;
+            _hash *= 0xc4ceb9fe1a85ec53ull;
+            return _hash ^ (_hash >> 33);
+        }
+
+        uint64_t _packState(const ToyRobot::Snapshot& _state)
+        {
+            if(!_state.m_hasBeenPlaced)
+                return UNPLACED;
+            const auto position = _state.m_transform.getPosition();
+            return uint64_t(position.x) | (uint64_t(position.y) << 16) | (uint64_t(_state.m_transform.getRotation()) << 32);
+        }
+
+        ToyRobot::Snapshot _unpackState(const uint64_t _state)
+        {
+            ToyRobot::Snapshot state;
+            if(_state == UNPLACED)
+                return state;
+            state.m_transform.setPosition(type::T_Position<uint8_t>(uint8_t(_state & 0xffff), uint8_t((_state >> 16) & 0xffff)));
+            state.m_transform.setRotation(type::HEADING((_state >> 32) & 0xff));
+            state.m_hasBeenPlaced = true;
+            return state;
+        }
+    }
+
+    void ContentHasher::update(std::string_view _bytes)
+    {
+        m_size += _bytes.size();
+        // finish a word left over from the last update
+        while(m_tailSize != 0 && !_bytes.empty())
+        {
+            m_tail |= uint64_t(uint8_t(_bytes.front())) << (m_tailSize * 8);
+            _bytes.remove_prefix(1);
+            if(++m_tailSize == 8)
+            {
+                m_hash = _mix(m_hash, m_tail);
+                m_tail = 0;
+                m_tailSize = 0;
+            }
+        }
+        while(_bytes.size() >= 8)
+        {
+            uint64_t word;
+            memcpy(&word, _bytes.data(), sizeof(word));
+            m_hash = _mix(m_hash, word);
+            _bytes.remove_prefix(8);
+        }
+        for(const char c : _bytes)
+            m_tail |= uint64_t(uint8_t(c)) << (m_tailSize++ * 8);
+    }
+
+    bool ContentHasher::updateFromFile(const std::string& _path)
+    {
+        std::ifstream file(_path, std::ios::binary);
+        if(!file)
+            return false;
+        std::string chunk(1 << 20, '\0');
+        while(file.read(&chunk[0], std::streamsize(chunk.size())) || file.gcount() > 0)
+            update(std::string_view(chunk.data(), size_t(file.gcount())));
+        return true;
+    }
+
+    uint64_t ContentHasher::digest() const
+    {
+        // the size tells "a" from "a\0"
+        return _finalise(_mix(_mix(m_hash, m_tail), m_size));
+    }
+
+    void ResultCache::Stats::print() const
+    {
+        const uint64_t lookups = m_hits + m_misses;
+        printf("\nCACHE: %lu hits (%lu from disk), %lu misses, %.1f%% hit rate\n", (unsigned long)m_hits,
+            (unsigned long)m_diskHits, (unsigned long)m_misses, lookups > 0 ? double(m_hits) * 100.0 / double(lookups) : 0.0);
+        printf("CACHE: %lu stores, %lu entries in %lu bytes, %lu evicted, %lu disk bytes, %lu files evicted\n",
+            (unsigned long)m_stores, (unsigned long)m_entries, (unsigned long)m_bytes, (unsigned long)m_evictions,
+            (unsigned long)m_diskBytes, (unsigned long)m_diskEvictions);
+    }
+
+    size_t ResultCache::KeyHash::operator()(const Key& _key) const
+    {
+        // the script hash is already well mixed
+        return size_t(_mix(_mix(_mix(_key.m_scriptHash, _key.m_obstacleHash), _key.m_startState),
+            _key.m_extentX | (uint64_t(_key.m_extentY) << 32)));
+    }
+
+    ResultCache::ResultCache(const ResultCacheConfig& _config)
+        :   m_config(_config)
+    {
+        if(m_config.m_directory.empty())
+            return;
+        std::error_code error;
+        std::filesystem::create_directories(m_config.m_directory, error);
+        for(const auto& entry : std::filesystem::directory_iterator(m_config.m_directory, error))
+            if(entry.path().extension() == FILE_EXTENSION)
+                m_stats.m_diskBytes += entry.file_size(error);
+    }
+
+    ResultCache::Key ResultCache::makeKey(const ContentHasher& _script, const ToyRobot::Snapshot& _start,
+        const uint32_t _extentX, const uint32_t _extentY, const ObstacleMap* _obstacles)
+    {
+        Key key;
+        key.m_scriptHash = _script.digest();
+        key.m_scriptBytes = _script.size();
+        key.m_obstacleHash = _obstacles != nullptr ? _obstacles->contentHash() : 0;
+        key.m_extentX = _extentX;
+        key.m_extentY = _extentY;
+        key.m_startState = _packState(_start);
+        return key;
+    }
+
+    void ResultCache::_insert(const Key& _key, const Result& _result)
+    {
+        auto itr = m_index.find(_key);
+        if(itr != m_index.end())
+        {
+            m_stats.m_bytes -= _entryBytes(*itr->second);
+            m_entries.erase(itr->second);
+            m_index.erase(itr);
+        }
+        m_entries.push_front(Entry{ _key, _result });
+        m_index.emplace(_key, m_entries.begin());
+        m_stats.m_bytes += _entryBytes(m_entries.front());
+        // keep the newest entry even when it is over the limit on its own
+        while(m_entries.size() > 1 && (m_entries.size() > m_config.m_maxEntries || m_stats.m_bytes > m_config.m_maxBytes))
+        {
+            m_stats.m_bytes -= _entryBytes(m_entries.back());
+            m_index.erase(m_entries.back().m_key);
+            m_entries.pop_back();
+            ++m_stats.m_evictions;
+        }
+        m_stats.m_entries = m_entries.size();
+    }
+
+    std::string ResultCache::_path(const Key& _key) const
+    {
+        char name[40];
+        snprintf(name, sizeof(name), "%016llx%s", (unsigned long long)KeyHash()(_key), FILE_EXTENSION);
+        return (std::filesystem::path(m_config.m_directory) / name).string();
+    }
+
+    bool ResultCache::_readFile(const Key& _key, Result& _result) const
+    {
+        std::ifstream file(_path(_key), std::ios::binary);
+        FileHeader header;
+        if(!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+            return false;
+        if(memcmp(header.m_magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.m_version != FILE_VERSION
+            || header.m_replayVersion != ToyRobot::REPLAY_VERSION || !(header.m_key == _key))
+            return false;
+        _result.m_reports.resize(header.m_reportBytes);
+        if(!file.read(_result.m_reports.data(), std::streamsize(header.m_reportBytes)))
+            return false;
+        _result.m_finalState = _unpackState(header.m_finalState);
+        _result.m_commands = header.m_commands;
+        return true;
+    }
+
+    int64_t ResultCache::_writeFile(const Key& _key, const Result& _result) const
+    {
+        FileHeader header{};
+        memcpy(header.m_magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.m_version = FILE_VERSION;
+        header.m_replayVersion = ToyRobot::REPLAY_VERSION;
+        header.m_key = _key;
+        header.m_finalState = _packState(_result.m_finalState);
+        header.m_commands = _result.m_commands;
+        header.m_reportBytes = _result.m_reports.size();
+        const std::string path = _path(_key);
+        // write aside and rename so other processes never read half a file
+        const std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(_result.m_reports.data(), std::streamsize(_result.m_reports.size()));
+            if(!file)
+            {
+                printf("CACHE: could not write %s\n", temporary.c_str());
+                return 0;
+            }
+        }
+        std::error_code error;
+        const uintmax_t previous = std::filesystem::file_size(path, error);
+        std::filesystem::rename(temporary, path, error);
+        if(error)
+            return 0;
+        return int64_t(sizeof(header) + _result.m_reports.size()) - (previous == uintmax_t(-1) ? 0 : int64_t(previous));
+    }
+
+    void ResultCache::_evictFiles(const std::string& _keep, const uint64_t _excess)
+    {
+        // delete the files used longest ago
+        std::error_code error;
+        std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> files;
+        for(const auto& entry : std::filesystem::directory_iterator(m_config.m_directory, error))
+            if(entry.path().extension() == FILE_EXTENSION && entry.path() != _keep)
+                files.emplace_back(entry.last_write_time(error), entry.path());
+        std::sort(files.begin(), files.end());
+        uint64_t freed = 0;
+        uint64_t evictions = 0;
+        for(const auto& file : files)
+        {
+            if(freed >= _excess)
+                break;
+            const uintmax_t size = std::filesystem::file_size(file.second, error);
+            // another store may have deleted it first
+            if(std::filesystem::remove(file.second, error))
+            {
+                freed += error ? 0 : size;
+                ++evictions;
+            }
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.m_diskBytes -= std::min<uint64_t>(m_stats.m_diskBytes, freed);
+        m_stats.m_diskEvictions += evictions;
+    }
+
+    bool ResultCache::find(const Key& _key, Result& _result)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto itr = m_index.find(_key);
+            if(itr != m_index.end())
+            {
+                // most recently used
+                m_entries.splice(m_entries.begin(), m_entries, itr->second);
+                _result = itr->second->m_result;
+                ++m_stats.m_hits;
+                return true;
+            }
+        }
+        // file reads run outside the lock so other threads' memory hits do not wait on the disk
+        const bool isOnDisk = !m_config.m_directory.empty() && _readFile(_key, _result);
+        if(isOnDisk)
+        {
+            // the write time orders files for eviction
+            std::error_code error;
+            std::filesystem::last_write_time(_path(_key), std::filesystem::file_time_type::clock::now(), error);
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(!isOnDisk)
+        {
+            ++m_stats.m_misses;
+            return false;
+        }
+        _insert(_key, _result);
+        ++m_stats.m_hits;
+        ++m_stats.m_diskHits;
+        return true;
+    }
+
+    void ResultCache::store(const Key& _key, const Result& _result)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            _insert(_key, _result);
+            ++m_stats.m_stores;
+        }
+        if(m_config.m_directory.empty())
+            return;
+        // file writes, renames and the eviction scan run outside the lock, only the byte counts are updated under it
+        const int64_t added = _writeFile(_key, _result);
+        uint64_t excess = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.m_diskBytes = uint64_t(std::max<int64_t>(0, int64_t(m_stats.m_diskBytes) + added));
+            if(m_stats.m_diskBytes > m_config.m_maxDiskBytes)
+                excess = m_stats.m_diskBytes - m_config.m_maxDiskBytes;
+        }
+        if(excess != 0)
+            _evictFiles(_path(_key), excess);
+    }
+
+    void ResultCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.clear();
+        m_index.clear();
+        m_stats.m_entries = 0;
+        m_stats.m_bytes = 0;
+    }
+
+    ResultCache::Stats ResultCache::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+}
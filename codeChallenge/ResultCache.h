@@ -0,0 +1,209 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include "Objects.h"
+#include <list>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace object
+{
+
+    /**
+     * Streaming 64 bit hash of script bytes
+     * @brief   bytes are mixed 8 at a time, so hashing runs at memory speed. feeding the same bytes in any
+     *          split gives the same digest
+    */
+    class ContentHasher
+    {
+        uint64_t m_hash = 0x243f6a8885a308d3ull;
+        uint64_t m_size = 0;
+        /// bytes of an unfinished 8 byte word
+        uint64_t m_tail = 0;
+        uint32_t m_tailSize = 0;
+
+    public:
+        /**
+         * @brief hash more bytes
+        */
+        void update(std::string_view _bytes);
+
+        /**
+         * @brief hash every byte of a file
+         * @return false if the file could not be opened
+        */
+        bool updateFromFile(const std::string& _path);
+
+        /**
+         * @brief hash of everything fed so far, more bytes can still be added afterwards
+        */
+        uint64_t digest() const;
+
+        /**
+         * @brief amount of bytes fed so far
+        */
+        uint64_t size() const { return m_size; };
+    };
+
+    /**
+     * Result cache tuning
+    */
+    struct ResultCacheConfig
+    {
+        /// memory held by cached results before the least recently used ones are dropped
+        size_t m_maxBytes = 64 << 20;
+        /// cached results held in memory
+        size_t m_maxEntries = 4096;
+        /// directory results are also written to, empty keeps them in memory only
+        std::string m_directory;
+        /// bytes of result files kept in m_directory before the least recently used ones are deleted
+        uint64_t m_maxDiskBytes = uint64_t(1) << 30;
+    };
+
+    /**
+     * Content addressed cache of script replays
+     * @brief   a replay is fully decided by the script bytes, the robot state it starts from, the table extents
+     *          and the obstacles, so its final state and REPORT output can be looked up instead of run.
+     *          results live in a least recently used list in memory and, when a directory is given, in one
+     *          file per key so they survive the process. disk hits are copied into memory, files written by a
+     *          build with another ToyRobot::REPLAY_VERSION are ignored.
+     *          every method is thread safe, files are read, written and evicted outside the lock
+    */
+    class ResultCache
+    {
+    public:
+        /// what decides a replay
+        struct Key
+        {
+            uint64_t m_scriptHash = 0;
+            uint64_t m_scriptBytes = 0;
+            uint64_t m_obstacleHash = 0;
+            uint32_t m_extentX = 0;
+            uint32_t m_extentY = 0;
+            /// start state, x | y << 16 | heading << 32 when placed and ~0 when not
+            uint64_t m_startState = 0;
+
+            bool operator==(const Key&) const = default;
+        };
+
+        /// what a replay produced
+        struct Result
+        {
+            ToyRobot::Snapshot m_finalState;
+            uint64_t m_commands = 0;
+            /// REPORT output exactly as the replay wrote it
+            std::string m_reports;
+        };
+
+        struct Stats
+        {
+            uint64_t m_hits = 0;
+            /// hits served from m_directory, also counted in m_hits
+            uint64_t m_diskHits = 0;
+            uint64_t m_misses = 0;
+            uint64_t m_stores = 0;
+            uint64_t m_evictions = 0;
+            uint64_t m_diskEvictions = 0;
+            size_t m_entries = 0;
+            size_t m_bytes = 0;
+            uint64_t m_diskBytes = 0;
+
+            /**
+             * @brief print hit rate and storage use
+            */
+            void print() const;
+        };
+
+    private:
+        struct KeyHash
+        {
+            size_t operator()(const Key& _key) const;
+        };
+
+        struct Entry
+        {
+            Key m_key;
+            Result m_result;
+        };
+
+        const ResultCacheConfig m_config;
+        mutable std::mutex m_mutex;
+        /// most recently used first
+        std::list<Entry> m_entries;
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index;
+        Stats m_stats;
+
+        /**
+         * @brief memory charged for an entry
+        */
+        static size_t _entryBytes(const Entry& _entry) { return sizeof(Entry) + _entry.m_result.m_reports.size(); };
+
+        /**
+         * @brief add an entry in front and drop least recently used entries past the limits
+        */
+        void _insert(const Key& _key, const Result& _result);
+
+        /**
+         * @brief path of the file holding a key
+        */
+        std::string _path(const Key& _key) const;
+
+        /**
+         * @brief read a result file, called without m_mutex held
+         * @return false if there is none or it belongs to another key
+        */
+        bool _readFile(const Key& _key, Result& _result) const;
+
+        /**
+         * @brief write a result file, called without m_mutex held
+         * @return bytes the file adds to m_directory, less the file it replaced
+        */
+        int64_t _writeFile(const Key& _key, const Result& _result) const;
+
+        /**
+         * @brief delete least recently used files other than _keep until _excess bytes are freed, called without m_mutex held
+        */
+        void _evictFiles(const std::string& _keep, const uint64_t _excess);
+
+    public:
+        /**
+         * @param _config limits and storage, the directory is created if needed
+        */
+        explicit ResultCache(const ResultCacheConfig& _config = ResultCacheConfig());
+
+        /**
+         * @brief key of a replay
+         * @param _script hasher fed with the whole script
+         * @param _start robot state before the first command
+         * @param _extentX largest x of the table
+         * @param _extentY largest y of the table
+         * @param _obstacles obstacles the robot checks, nullptr for none
+        */
+        static Key makeKey(const ContentHasher& _script, const ToyRobot::Snapshot& _start, const uint32_t _extentX,
+            const uint32_t _extentY, const ObstacleMap* _obstacles);
+
+        /**
+         * @brief look up a replay
+         * @param _result receives the cached result on a hit
+         * @return true on a hit
+        */
+        bool find(const Key& _key, Result& _result);
+
+        /**
+         * @brief cache the result of a replay, replacing any result of the same key
+        */
+        void store(const Key& _key, const Result& _result);
+
+        /**
+         * @brief drop every result held in memory, files are kept
+        */
+        void clear();
+
+        Stats getStats() const;
+    };
+}
+
+#endif  // RESULT_CACHE_H
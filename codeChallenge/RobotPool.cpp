@@ -0,0 +1,55 @@
+#include "RobotPool.h"
+#include <new>
+
+namespace object
+{
+    RobotPool::RobotPool(const uint32_t _capacity, const ObstacleMap* _obstacleMap)
+        :   m_slots(std::make_unique<Slot[]>(_capacity)),
+            m_capacity(_capacity),
+            m_obstacleMap(_obstacleMap)
+    {}
+
+    RobotPool::~RobotPool()
+    {
+        for(uint32_t index = 0; index < m_used; ++index)
+            if(m_slots[index].m_isBuilt)
+                m_slots[index].robot().~ToyRobot();
+    }
+
+    RobotPool::Handle RobotPool::create()
+    {
+        uint32_t index = m_freeHead;
+        if(index != NO_SLOT)
+            m_freeHead = m_slots[index].m_nextFree;
+        else if(m_used < m_capacity)
+            index = m_used++;
+        else
+            return Handle();
+        Slot& slot = m_slots[index];
+        if(!slot.m_isBuilt)
+        {
+            // first use of the slot, the only time it allocates
+            new (slot.m_storage) ToyRobot();
+            slot.robot().setObstacleMap(m_obstacleMap);
+            slot.m_isBuilt = true;
+        }
+        slot.m_isLive = true;
+        slot.m_nextFree = NO_SLOT;
+        ++m_size;
+        return Handle{ index, slot.m_generation };
+    }
+
+    bool RobotPool::destroy(const Handle _handle)
+    {
+        Slot* slot = _slot(_handle);
+        if(slot == nullptr)
+            return false;
+        slot->robot().reset();
+        slot->m_isLive = false;
+        ++slot->m_generation;
+        slot->m_nextFree = m_freeHead;
+        m_freeHead = _handle.m_index;
+        --m_size;
+        return true;
+    }
+}
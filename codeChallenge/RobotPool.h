@@ -0,0 +1,111 @@
+#ifndef ROBOT_POOL_H
+#define ROBOT_POOL_H
+
+#include "Objects.h"
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace object
+{
+
+    /**
+     * Fixed capacity pool of ToyRobots for short lived sessions
+     * @brief   robots live in one contiguous array of slots and are built the first time a slot is used.
+     *          destroying a robot resets it and pushes its slot on a freelist, so later sessions reuse the
+     *          robot and its action map instead of allocating. handles carry a generation, a handle to a
+     *          destroyed robot stays invalid even after its slot is reused
+    */
+    class RobotPool
+    {
+    public:
+        /// stable reference to a pooled robot
+        struct Handle
+        {
+            uint32_t m_index = NO_SLOT;
+            uint32_t m_generation = 0;
+
+            bool isValid() const { return m_index != NO_SLOT; };
+        };
+
+        /// marks the end of the freelist and handles that refer to nothing
+        static constexpr uint32_t NO_SLOT = ~uint32_t(0);
+
+    private:
+        /**
+         * storage for one robot
+        */
+        struct Slot
+        {
+            alignas(ToyRobot) unsigned char m_storage[sizeof(ToyRobot)];
+            /// bumped on every destroy so old handles stop matching
+            uint32_t m_generation = 0;
+            /// next free slot while this one is free
+            uint32_t m_nextFree = NO_SLOT;
+            bool m_isBuilt = false;
+            bool m_isLive = false;
+
+            ToyRobot& robot() { return *reinterpret_cast<ToyRobot*>(m_storage); };
+        };
+
+        std::unique_ptr<Slot[]> m_slots;
+        const uint32_t m_capacity;
+        /// slots below this were used at least once, the rest have never been built
+        uint32_t m_used = 0;
+        uint32_t m_freeHead = NO_SLOT;
+        size_t m_size = 0;
+        /// obstacles given to every robot, not owned
+        const ObstacleMap* m_obstacleMap = nullptr;
+
+        /**
+         * @brief live slot of a handle, nullptr if the handle is stale
+        */
+        Slot* _slot(const Handle _handle) const
+        {
+            if(_handle.m_index >= m_used)
+                return nullptr;
+            Slot& slot = m_slots[_handle.m_index];
+            return (slot.m_isLive && slot.m_generation == _handle.m_generation) ? &slot : nullptr;
+        }
+
+    public:
+        /**
+         * @param _capacity most robots alive at once, storage for all of them is reserved up front
+         * @param _obstacleMap obstacles for every robot, not owned
+        */
+        RobotPool(const uint32_t _capacity, const ObstacleMap* _obstacleMap = nullptr);
+        RobotPool(const RobotPool&) = delete;
+        void operator=(const RobotPool&) = delete;
+        ~RobotPool();
+
+        /**
+         * @brief take a robot in the state of a new one
+         * @return handle of the robot, invalid when the pool is full
+        */
+        Handle create();
+
+        /**
+         * @brief reset a robot and return its slot to the freelist
+         * @return false if the handle is stale
+        */
+        bool destroy(const Handle _handle);
+
+        /**
+         * @brief access a live robot
+         * @return the robot, nullptr if the handle is stale
+        */
+        ToyRobot* get(const Handle _handle) const
+        {
+            Slot* slot = _slot(_handle);
+            return slot != nullptr ? &slot->robot() : nullptr;
+        };
+
+        /**
+         * @brief amount of live robots and most robots alive at once
+        */
+        size_t size() const { return m_size; };
+        size_t capacity() const { return m_capacity; };
+    };
+}
+
+#endif  // ROBOT_POOL_H
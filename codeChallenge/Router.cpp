@@ -0,0 +1,200 @@
+#include "Router.h"
+#include <algorithm>
+#include <bit>
+#include <stdio.h>
+
+namespace object
+{
+    RobotIdMap::RobotIdMap(const size_t _expected)
+    {
+        _rehash(std::bit_ceil(std::max<size_t>(8, _expected + _expected / 3 + 1)));
+    }
+
+    void RobotIdMap::_rehash(const size_t _capacity)
+    {
+        std::vector<Entry> previous(_capacity, Entry{ EMPTY_ID, NO_SLOT });
+        previous.swap(m_entries);
+        m_mask = _capacity - 1;
+        m_shift = 64 - uint32_t(std::countr_zero(_capacity));
+        m_size = 0;
+        for(const Entry& entry : previous)
+            if(entry.m_id != EMPTY_ID)
+                insert(entry.m_id, entry.m_slot);
+    }
+
+    bool RobotIdMap::insert(const uint32_t _id, const uint32_t _slot)
+    {
+        if(_id == EMPTY_ID)
+            return false;
+        // keep at most 3/4 full so probes stay short
+        if((m_size + 1) * 4 > m_entries.size() * 3)
+            _rehash(m_entries.size() * 2);
+        for(uint64_t index = _home(_id); ; index = (index + 1) & m_mask)
+        {
+            Entry& entry = m_entries[index];
+            if(entry.m_id == _id)
+            {
+                entry.m_slot = _slot;
+                return true;
+            }
+            if(entry.m_id == EMPTY_ID)
+            {
+                entry = Entry{ _id, _slot };
+                ++m_size;
+                return true;
+            }
+        }
+    }
+
+    bool RobotIdMap::erase(const uint32_t _id)
+    {
+        if(m_size == 0 || _id == EMPTY_ID)
+            return false;
+        uint64_t hole = _home(_id);
+        while(m_entries[hole].m_id != _id)
+        {
+            if(m_entries[hole].m_id == EMPTY_ID)
+                return false;
+            hole = (hole + 1) & m_mask;
+        }
+        // shift back every later entry of the run whose home is not between the hole and itself
+        for(uint64_t index = (hole + 1) & m_mask; m_entries[index].m_id != EMPTY_ID; index = (index + 1) & m_mask)
+        {
+            const uint64_t home = _home(m_entries[index].m_id);
+            const bool isReachable = hole <= index ? (home > hole && home <= index) : (home > hole || home <= index);
+            if(isReachable)
+                continue;
+            m_entries[hole] = m_entries[index];
+            hole = index;
+        }
+        m_entries[hole] = Entry{ EMPTY_ID, NO_SLOT };
+        --m_size;
+        return true;
+    }
+
+    CommandRouter::CommandRouter(Fleet& _fleet, const size_t _expected)
+        :   m_fleet(_fleet),
+            m_ids(_expected)
+    {}
+
+    bool CommandRouter::isAddressed(std::string_view _input)
+    {
+        if(_input.size() < 3 || _input[0] != 'R' || _input[1] < '0' || _input[1] > '9')
+            return false;
+        const size_t space = _input.find(' ');
+        return space != std::string_view::npos
+            && std::all_of(_input.begin() + 1, _input.begin() + space, [](const char _c){ return _c >= '0' && _c <= '9'; });
+    }
+
+    bool CommandRouter::parse(std::string_view _input, AddressedCommand& _command)
+    {
+        if(!isAddressed(_input))
+            return false;
+        const size_t space = _input.find(' ');
+        uint64_t id = 0;
+        for(const char c : _input.substr(1, space - 1))
+        {
+            id = id * 10 + uint64_t(c - '0');
+            if(id >= RobotIdMap::EMPTY_ID)
+                return false;
+        }
+        _command.m_robot = uint32_t(id);
+        return InputHandler::parseCommand(_input.substr(space + 1), _command.m_command);
+    }
+
+    uint32_t CommandRouter::addRobot(const uint32_t _id)
+    {
+        if(_id == RobotIdMap::EMPTY_ID || m_ids.find(_id) != RobotIdMap::NO_SLOT)
+            return RobotIdMap::NO_SLOT;
+        const uint32_t slot = m_fleet.addRobot();
+        assign(_id, slot);
+        return slot;
+    }
+
+    bool CommandRouter::assign(const uint32_t _id, const uint32_t _slot)
+    {
+        return _slot < m_fleet.size() && m_ids.insert(_id, _slot);
+    }
+
+    bool CommandRouter::_execute(const uint32_t _id, uint32_t _slot, const type::Command& _command, std::string* _reports)
+    {
+        if(_slot == RobotIdMap::NO_SLOT)
+        {
+            // the first PLACE of an id on the table adds its robot
+            // and only once it would be accepted, a rejected PLACE takes no slot or id
+            if(_command.action != type::ACTION::PLACE || !m_fleet.isPlaceable(_command.x, _command.y, _command.heading))
+                return false;
+            _slot = addRobot(_id);
+            if(_slot == RobotIdMap::NO_SLOT)
+                return false;
+        }
+        switch (_command.action)
+        {
+        case type::ACTION::PLACE:   return m_fleet.placeHere(_slot, _command.x, _command.y, _command.heading);
+        case type::ACTION::MOVE:    return m_fleet.move(_slot);
+        case type::ACTION::LEFT:    return m_fleet.rotateLeft(_slot);
+        case type::ACTION::RIGHT:   return m_fleet.rotateRight(_slot);
+        case type::ACTION::REPORT:
+            if(!m_fleet.isPlaced(_slot))
+                return false;
+            if(_reports != nullptr)
+                _reports->append("R").append(std::to_string(_id)).append(" ").append(m_fleet.getReport(_slot)).push_back('\n');
+            else
+                printf("Output : R%u %s\n", _id, m_fleet.getReport(_slot).c_str());
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool CommandRouter::route(const AddressedCommand& _command, std::string* _reports)
+    {
+        return _execute(_command.m_robot, m_ids.find(_command.m_robot), _command.m_command, _reports);
+    }
+
+    bool CommandRouter::route(std::string_view _input, std::string* _reports)
+    {
+        AddressedCommand command;
+        return parse(_input, command) && route(command, _reports);
+    }
+
+    InputHandler::BatchResult CommandRouter::routeBatch(std::span<const AddressedCommand> _commands, std::string* _reports)
+    {
+        InputHandler::BatchResult result;
+        for(size_t i = 0; i < _commands.size(); ++i)
+        {
+            // two stage lookahead: the id entry far ahead, then the robot once its entry has arrived
+            if(i + PREFETCH_DISTANCE < _commands.size())
+                m_ids.prefetch(_commands[i + PREFETCH_DISTANCE].m_robot);
+            if(i + PREFETCH_DISTANCE / 2 < _commands.size())
+            {
+                const uint32_t slot = m_ids.find(_commands[i + PREFETCH_DISTANCE / 2].m_robot);
+                if(slot != RobotIdMap::NO_SLOT)
+                    __builtin_prefetch(&m_fleet.getTransform(slot), 1);
+            }
+            const AddressedCommand& command = _commands[i];
+            const bool isAccepted = _execute(command.m_robot, m_ids.find(command.m_robot), command.m_command, _reports);
+            ++(isAccepted ? result.m_accepted : result.m_rejected);
+            result.m_reports += isAccepted && command.m_command.action == type::ACTION::REPORT;
+        }
+        return result;
+    }
+
+    InputHandler::BatchResult CommandRouter::routeBatch(std::span<const std::string_view> _inputs, std::string* _reports)
+    {
+        InputHandler::BatchResult result;
+        AddressedCommand command;
+        for(const std::string_view input : _inputs)
+        {
+            if(!parse(input, command))
+            {
+                ++result.m_ignored;
+                continue;
+            }
+            const bool isAccepted = route(command, _reports);
+            ++(isAccepted ? result.m_accepted : result.m_rejected);
+            result.m_reports += isAccepted && command.m_command.action == type::ACTION::REPORT;
+        }
+        return result;
+    }
+}
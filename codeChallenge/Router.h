@@ -0,0 +1,194 @@
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include "Fleet.h"
+#include "Objects.h"
+#include <span>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace object
+{
+
+    /**
+     * Open addressing map from robot id to fleet slot
+     * @brief   entries are 8 bytes, id and slot, in one power of two array probed linearly, so a lookup is
+     *          usually a single cache line. the table is kept at most 3/4 full and erasing shifts later entries
+     *          back instead of leaving tombstones
+    */
+    class RobotIdMap
+    {
+    public:
+        /// id that is never stored, marks empty entries
+        static constexpr uint32_t EMPTY_ID = ~0u;
+        /// slot returned for unknown ids
+        static constexpr uint32_t NO_SLOT = ~0u;
+
+    private:
+        struct Entry
+        {
+            uint32_t m_id;
+            uint32_t m_slot;
+        };
+
+        std::vector<Entry> m_entries;
+        uint64_t m_mask = 0;
+        /// right shift that turns the 64 bit hash into an index
+        uint32_t m_shift = 64;
+        size_t m_size = 0;
+
+        /**
+         * @brief home index of an id, fibonacci hashing spreads sequential ids
+        */
+        uint64_t _home(const uint32_t _id) const { return (uint64_t(_id) * 0x9e3779b97f4a7c15ull) >> m_shift; };
+
+        /**
+         * @brief reinsert every entry into a table of _capacity entries
+        */
+        void _rehash(const size_t _capacity);
+
+    public:
+        /**
+         * @param _expected ids expected, sizes the table so it does not grow before that
+        */
+        explicit RobotIdMap(const size_t _expected = 0);
+
+        /**
+         * @brief add or move an id
+         * @param _id robot id, anything but EMPTY_ID
+         * @param _slot fleet slot of the robot
+         * @return false if _id is EMPTY_ID
+        */
+        bool insert(const uint32_t _id, const uint32_t _slot);
+
+        /**
+         * @brief slot of an id
+         * @return NO_SLOT if the id is unknown
+        */
+        uint32_t find(const uint32_t _id) const
+        {
+            if(m_size == 0)
+                return NO_SLOT;
+            for(uint64_t index = _home(_id); ; index = (index + 1) & m_mask)
+            {
+                const Entry& entry = m_entries[index];
+                if(entry.m_id == _id)
+                    return entry.m_slot;
+                if(entry.m_id == EMPTY_ID)
+                    return NO_SLOT;
+            }
+        }
+
+        /**
+         * @brief start loading the cache line a later find of _id reads
+        */
+        void prefetch(const uint32_t _id) const
+        {
+            if(m_size != 0)
+                __builtin_prefetch(&m_entries[_home(_id)]);
+        }
+
+        /**
+         * @brief remove an id
+         * @return false if it was unknown
+        */
+        bool erase(const uint32_t _id);
+
+        size_t size() const { return m_size; };
+        size_t capacity() const { return m_entries.size(); };
+    };
+
+    /**
+     * Routes addressed commands to fleet robots
+     * @brief   "R42 MOVE" runs MOVE on the fleet robot with id 42. ids are mapped to fleet slots by a RobotIdMap.
+     *          a PLACE for an unknown id adds a robot to the fleet under that id, any other command for an unknown
+     *          id is rejected. fleet robots have no history, so UNDO and REDO are rejected
+    */
+    class CommandRouter
+    {
+    public:
+        /// command for one robot
+        struct AddressedCommand
+        {
+            uint32_t m_robot = 0;
+            type::Command m_command;
+        };
+
+        /// commands looked up this far ahead of the one being run in a batch
+        static constexpr size_t PREFETCH_DISTANCE = 16;
+
+    private:
+        Fleet& m_fleet;
+        RobotIdMap m_ids;
+
+        /**
+         * @brief run a command on a slot
+         * @param _slot slot of _id, NO_SLOT adds a robot for a PLACE on the table
+         * @param _reports REPORT output buffer, printf when nullptr
+        */
+        bool _execute(const uint32_t _id, uint32_t _slot, const type::Command& _command, std::string* _reports);
+
+    public:
+        /**
+         * @param _fleet robots commands are routed to, slots added outside the router are only reachable
+         *        once an id is assigned to them
+         * @param _expected robots expected, sizes the id map
+        */
+        explicit CommandRouter(Fleet& _fleet, const size_t _expected = 0);
+
+        /**
+         * @brief check for the "R<id> " prefix without parsing the command
+        */
+        static bool isAddressed(std::string_view _input);
+
+        /**
+         * @brief parse "R<id> <command>", the command the same way as InputHandler::parseCommand
+         * @return false if the input is not addressed or the command would be ignored
+        */
+        static bool parse(std::string_view _input, AddressedCommand& _command);
+
+        /**
+         * @brief add a fleet robot under an id
+         * @return fleet slot of the robot, RobotIdMap::NO_SLOT if the id is taken or EMPTY_ID
+        */
+        uint32_t addRobot(const uint32_t _id);
+
+        /**
+         * @brief give an existing fleet slot an id
+         * @return false if the slot does not exist or the id is EMPTY_ID
+        */
+        bool assign(const uint32_t _id, const uint32_t _slot);
+
+        /**
+         * @brief fleet slot of an id, RobotIdMap::NO_SLOT if unknown
+        */
+        uint32_t findSlot(const uint32_t _id) const { return m_ids.find(_id); };
+
+        /**
+         * @brief run an addressed string command
+         * @param _reports optional REPORT output buffer, lines read "R<id> x,y,heading". printf is used when nullptr
+         * @return true if it was accepted
+        */
+        bool route(std::string_view _input, std::string* _reports = nullptr);
+        bool route(const AddressedCommand& _command, std::string* _reports = nullptr);
+
+        /**
+         * @brief run commands for many robots in order, looking ids and robots up ahead so their cache misses overlap
+         * @param _commands commands in order, targets may be mixed freely
+         * @param _reports optional REPORT output buffer, see route
+         * @return accepted, rejected and REPORT counts
+        */
+        InputHandler::BatchResult routeBatch(std::span<const AddressedCommand> _commands, std::string* _reports = nullptr);
+
+        /**
+         * @brief parse and run many addressed string commands, inputs that do not parse are counted as ignored
+        */
+        InputHandler::BatchResult routeBatch(std::span<const std::string_view> _inputs, std::string* _reports = nullptr);
+
+        size_t size() const { return m_ids.size(); };
+    };
+}
+
+#endif  // ROUTER_H
@@ -0,0 +1,83 @@
+#include "Script.h"
+#include "Tokenizer.h"
+#include <string_view>
+
+namespace object
+{
+    ScriptTask runScript(ToyRobot& _robot, std::string _script, size_t _sliceSize)
+    {
+        std::vector<std::string_view> commands;
+        Tokenizer::split(_script, commands);
+        ScriptYield yield;
+        bool hasReported = false;
+        // the callback points into this frame, put the caller's one back when the frame goes away even if the
+        // script did not finish
+        struct CallbackGuard
+        {
+            ToyRobot& m_robot;
+            std::function<void(const std::string&)> m_previous;
+            ~CallbackGuard() { m_robot.setReportCallback(std::move(m_previous)); };
+        } guard{ _robot, _robot.getReportCallback() };
+        _robot.setReportCallback([&](const std::string& _report)
+        {
+            yield.m_report = _report;
+            hasReported = true;
+        });
+        size_t sliceLeft = _sliceSize;
+        for(const std::string_view text : commands)
+        {
+            type::Command command;
+            if(InputHandler::parseCommand(text, command))
+                _robot.execute(command);
+            ++yield.m_commands;
+            if(hasReported)
+            {
+                hasReported = false;
+                sliceLeft = _sliceSize;
+                yield.m_reason = ScriptYield::REASON::REPORT;
+                co_yield yield;
+            }
+            else if(_sliceSize != 0 && --sliceLeft == 0)
+            {
+                sliceLeft = _sliceSize;
+                yield.m_reason = ScriptYield::REASON::SLICE;
+                co_yield yield;
+            }
+        }
+    }
+
+    size_t ScriptScheduler::add(ScriptTask&& _task)
+    {
+        m_tasks.push_back(Entry{ std::move(_task), m_nextId });
+        return m_nextId++;
+    }
+
+    uint64_t ScriptScheduler::step(const std::function<void(size_t, const ScriptYield&)>& _onYield)
+    {
+        uint64_t yields = 0;
+        size_t kept = 0;
+        for(size_t i = 0; i < m_tasks.size(); ++i)
+        {
+            Entry& entry = m_tasks[i];
+            if(!entry.m_task.resume())
+                continue;
+            ++yields;
+            if(_onYield)
+                _onYield(entry.m_id, entry.m_task.current());
+            // keep the order stable while compacting out finished scripts
+            if(kept != i)
+                m_tasks[kept] = std::move(entry);
+            ++kept;
+        }
+        m_tasks.erase(m_tasks.begin() + kept, m_tasks.end());
+        return yields;
+    }
+
+    uint64_t ScriptScheduler::run(const std::function<void(size_t, const ScriptYield&)>& _onYield)
+    {
+        uint64_t yields = 0;
+        while(!m_tasks.empty())
+            yields += step(_onYield);
+        return yields;
+    }
+}
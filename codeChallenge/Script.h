@@ -0,0 +1,167 @@
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include "Objects.h"
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace object
+{
+
+    /**
+     * Value handed out by a suspended script
+    */
+    struct ScriptYield
+    {
+        enum class REASON : uint8_t
+        {
+            REPORT  = 0, /// m_report holds the REPORT output
+            SLICE   = 1  /// the slice of commands ran out
+        };
+        REASON m_reason = REASON::SLICE;
+        std::string m_report;
+        /// commands run by the script so far
+        uint64_t m_commands = 0;
+    };
+
+    /**
+     * Resumable command script
+     * @brief   a C++20 coroutine that runs a script against a robot and suspends on every REPORT, and every
+     *          slice of commands when a slice size is given. nothing runs until the first resume(), and each
+     *          resume() runs until the next suspension on the calling thread
+    */
+    class ScriptTask
+    {
+    public:
+        struct promise_type
+        {
+            /// lives in the coroutine frame, valid while suspended
+            const ScriptYield* m_current = nullptr;
+            std::exception_ptr m_exception;
+
+            ScriptTask get_return_object() { return ScriptTask(std::coroutine_handle<promise_type>::from_promise(*this)); };
+            std::suspend_always initial_suspend() noexcept { return {}; };
+            std::suspend_always final_suspend() noexcept { return {}; };
+            std::suspend_always yield_value(const ScriptYield& _yield) noexcept
+            {
+                m_current = &_yield;
+                return {};
+            }
+            void return_void() { m_current = nullptr; };
+            void unhandled_exception() { m_exception = std::current_exception(); };
+        };
+
+        ScriptTask() {};
+        ScriptTask(ScriptTask&& _other) noexcept
+            :   m_handle(_other.m_handle)
+        {
+            _other.m_handle = nullptr;
+        }
+        ScriptTask& operator=(ScriptTask&& _other) noexcept
+        {
+            if(this != &_other)
+            {
+                if(m_handle)
+                    m_handle.destroy();
+                m_handle = _other.m_handle;
+                _other.m_handle = nullptr;
+            }
+            return *this;
+        }
+        ScriptTask(const ScriptTask&) = delete;
+        void operator=(const ScriptTask&) = delete;
+        ~ScriptTask()
+        {
+            if(m_handle)
+                m_handle.destroy();
+        }
+
+        /**
+         * @brief run the script until it next suspends
+         * @return true if it yielded, false once it has finished
+        */
+        bool resume()
+        {
+            if(isDone())
+                return false;
+            m_handle.resume();
+            if(m_handle.promise().m_exception)
+                std::rethrow_exception(m_handle.promise().m_exception);
+            return !m_handle.done();
+        }
+
+        /**
+         * @brief value of the last yield, only valid after resume() returned true
+        */
+        const ScriptYield& current() const { return *m_handle.promise().m_current; };
+
+        bool isDone() const { return !m_handle || m_handle.done(); };
+
+    private:
+        explicit ScriptTask(std::coroutine_handle<promise_type> _handle)
+            :   m_handle(_handle)
+        {};
+
+        std::coroutine_handle<promise_type> m_handle;
+    };
+
+    /**
+     * @brief make a script coroutine
+     * @brief the script takes over the report callback of the robot while it runs. the robot must outlive the task
+     * @param _robot robot to run the commands on
+     * @param _script commands separated by "|" or new lines
+     * @param _sliceSize also yield after this many commands, 0 only yields on REPORT
+     * @return suspended script, resume() to start it
+    */
+    ScriptTask runScript(ToyRobot& _robot, std::string _script, size_t _sliceSize = 0);
+
+    /**
+     * Cooperative round robin scheduler for scripts
+     * @brief   single threaded. every pass resumes each unfinished script once, in the order they were added,
+     *          and drops the ones that finished
+    */
+    class ScriptScheduler
+    {
+        struct Entry
+        {
+            ScriptTask m_task;
+            size_t m_id;
+        };
+        std::vector<Entry> m_tasks;
+        size_t m_nextId = 0;
+
+    public:
+        ScriptScheduler(){};
+
+        /**
+         * @brief take ownership of a script
+         * @return id passed to the yield callback
+        */
+        size_t add(ScriptTask&& _task);
+
+        /**
+         * @brief amount of unfinished scripts
+        */
+        size_t size() const { return m_tasks.size(); };
+
+        /**
+         * @brief resume every script once, dropping finished ones
+         * @param _onYield called with the script id and its yield, may be empty
+         * @return amount of yields
+        */
+        uint64_t step(const std::function<void(size_t, const ScriptYield&)>& _onYield = {});
+
+        /**
+         * @brief step until every script has finished
+         * @param _onYield called with the script id and its yield, may be empty
+         * @return amount of yields
+        */
+        uint64_t run(const std::function<void(size_t, const ScriptYield&)>& _onYield = {});
+    };
+}
+
+#endif  // SCRIPT_H
@@ -0,0 +1,507 @@
+#include "Shard.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <deque>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace object
+{
+    namespace
+    {
+        typedef ShardRunner::Message Message;
+
+        /// messages per write, a write of at most PIPE_BUF bytes is never interleaved with other writers
+        const size_t BATCH = PIPE_BUF / sizeof(Message);
+        static_assert(sizeof(Fleet::Transform) == sizeof(uint32_t), "transforms are sent as 32 bits");
+
+        /// parent waits this long for a result before checking its workers are still alive
+        const int WAIT_MS = 100;
+        /// messages the parent queues for a worker before waiting for the pipe, bounds its send buffers
+        const size_t SEND_MESSAGES = 4096;
+        /// largest coordinate a packed command keeps, fleet extents are far below it so larger ones stay rejected
+        const uint64_t PACKED_AXIS = (uint64_t(1) << 28) - 1;
+
+        uint32_t _packTransform(const Fleet::Transform& _transform)
+        {
+            return std::bit_cast<uint32_t>(_transform);
+        }
+
+        Fleet::Transform _unpackTransform(const uint32_t _bits)
+        {
+            return std::bit_cast<Fleet::Transform>(_bits);
+        }
+
+        /**
+         * @brief action and heading in 4 bits each, then 28 bits per axis
+        */
+        uint64_t _packCommand(const type::Command& _command)
+        {
+            return uint64_t(_command.action) | (uint64_t(_command.heading) << 4)
+                | (std::min<uint64_t>(_command.x, PACKED_AXIS) << 8) | (std::min<uint64_t>(_command.y, PACKED_AXIS) << 36);
+        }
+
+        type::Command _unpackCommand(const uint64_t _bits)
+        {
+            type::Command command;
+            command.action = type::ACTION(_bits & 0xf);
+            command.heading = type::HEADING((_bits >> 4) & 0xf);
+            command.x = uint32_t((_bits >> 8) & PACKED_AXIS);
+            command.y = uint32_t((_bits >> 36) & PACKED_AXIS);
+            return command;
+        }
+
+        /**
+         * messages waiting for a non blocking pipe
+        */
+        struct Outbox
+        {
+            int m_fd = -1;
+            std::vector<Message> m_pending;
+            size_t m_sent = 0;
+
+            bool hasPending() const { return m_sent < m_pending.size(); };
+
+            /**
+             * @brief write whole batches until the pipe is full
+             * @return false if the pipe is broken
+            */
+            bool flush()
+            {
+                while(hasPending())
+                {
+                    const size_t count = std::min(BATCH, m_pending.size() - m_sent);
+                    const ssize_t written = write(m_fd, &m_pending[m_sent], count * sizeof(Message));
+                    if(written < 0)
+                        return errno == EAGAIN || errno == EINTR;
+                    m_sent += size_t(written) / sizeof(Message);
+                }
+                m_pending.clear();
+                m_sent = 0;
+                return true;
+            }
+
+            /**
+             * @brief flush everything, waiting for room
+             * @return false if the pipe is broken
+            */
+            bool drain()
+            {
+                if(!flush())
+                    return false;
+                while(hasPending())
+                {
+                    pollfd request{ m_fd, POLLOUT, 0 };
+                    poll(&request, 1, -1);
+                    if(!flush())
+                        return false;
+                }
+                return true;
+            }
+        };
+
+        /**
+         * whole messages read from a pipe, a read can end inside a message
+        */
+        struct Inbox
+        {
+            int m_fd = -1;
+            std::vector<char> m_bytes;
+
+            /**
+             * @brief read what is available and hand every complete message to _onMessage
+             * @return false if nothing could be read
+            */
+            template<typename F>
+            bool receive(F&& _onMessage)
+            {
+                char buffer[BATCH * sizeof(Message) * 4];
+                const ssize_t count = read(m_fd, buffer, sizeof(buffer));
+                if(count <= 0)
+                    return false;
+                m_bytes.insert(m_bytes.end(), buffer, buffer + count);
+                const size_t whole = m_bytes.size() / sizeof(Message);
+                for(size_t i = 0; i < whole; ++i)
+                {
+                    Message message;
+                    memcpy(&message, &m_bytes[i * sizeof(Message)], sizeof(Message));
+                    _onMessage(message);
+                }
+                m_bytes.erase(m_bytes.begin(), m_bytes.begin() + whole * sizeof(Message));
+                return true;
+            }
+        };
+
+        void _setNonBlocking(const int _fd)
+        {
+            fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+        }
+    }
+
+    ShardRunner::ShardRunner(Fleet& _fleet, const unsigned _columns, const unsigned _rows)
+        :   m_fleet(_fleet),
+            m_columns(std::max(1u, _columns)),
+            m_rows(std::max(1u, _rows)),
+            m_offsets(1, 0)
+    {}
+
+    uint32_t ShardRunner::addStream(const std::vector<type::Command>& _commands)
+    {
+        m_commands.insert(m_commands.end(), _commands.begin(), _commands.end());
+        m_offsets.push_back(m_commands.size());
+        return uint32_t(m_offsets.size() - 2);
+    }
+
+    unsigned ShardRunner::_owner(const uint32_t _robot) const
+    {
+        if(!m_fleet.isPlaced(_robot))
+            return _robot % workerCount();
+        const auto position = m_fleet.getPosition(_robot);
+        return _region(position.x, position.y);
+    }
+
+    uint64_t ShardRunner::_runRobot(Fleet& _fleet, const uint32_t _slot, const type::Command* _stream, uint64_t _cursor,
+        const uint64_t _end, const unsigned _home, uint64_t& _commands) const
+    {
+        while(_cursor < _end)
+        {
+            const type::Command& command = _stream[_cursor++];
+            ++_commands;
+            switch (command.action)
+            {
+            case type::ACTION::PLACE:   _fleet.placeHere(_slot, command.x, command.y, command.heading); break;
+            case type::ACTION::MOVE:    _fleet.move(_slot); break;
+            case type::ACTION::LEFT:    _fleet.rotateLeft(_slot); break;
+            case type::ACTION::RIGHT:   _fleet.rotateRight(_slot); break;
+            default:                    continue;
+            }
+            if(!_fleet.isPlaced(_slot))
+                continue;
+            const auto position = _fleet.getPosition(_slot);
+            if(_region(position.x, position.y) != _home)
+                break;
+        }
+        return _cursor;
+    }
+
+    void ShardRunner::_send(std::vector<Message>& _pending, const uint32_t _robot, const Fleet::Transform& _transform,
+        const bool _isPlaced, const type::Command* _stream, uint64_t _cursor, const uint64_t _end)
+    {
+        _pending.push_back(Message{ Message::ROBOT, _robot, _packTransform(_transform), _isPlaced ? 1u : 0u, _end - _cursor, 0 });
+        for(; _cursor < _end; _cursor += 2)
+        {
+            const bool isPair = _cursor + 1 < _end;
+            _pending.push_back(Message{ Message::COMMANDS, _robot, 0, isPair ? 2u : 1u, _packCommand(_stream[_cursor]),
+                isPair ? _packCommand(_stream[_cursor + 1]) : 0 });
+        }
+    }
+
+    ShardRunner::ShardStats ShardRunner::runInProcess()
+    {
+        ShardStats stats;
+        const uint32_t robots = uint32_t(std::min<size_t>(m_fleet.size(), m_offsets.size() - 1));
+        for(uint32_t robot = 0; robot < robots; ++robot)
+        {
+            uint64_t cursor = m_offsets[robot];
+            // keep running across region edges
+            while(cursor < m_offsets[robot + 1])
+            {
+                const auto position = m_fleet.getPosition(robot);
+                const unsigned region = m_fleet.isPlaced(robot) ? _region(position.x, position.y) : ~0u;
+                cursor = _runRobot(m_fleet, robot, m_commands.data(), cursor, m_offsets[robot + 1], region, stats.m_commands);
+            }
+        }
+        stats.m_workerCommands.push_back(stats.m_commands);
+        return stats;
+    }
+
+    void ShardRunner::_work(const unsigned _worker, const int _inbox, const std::vector<int>& _outboxes, const int _results)
+    {
+        // the worker holds only what it is sent, drop the streams forked from the calling process
+        std::vector<type::Command>().swap(m_commands);
+        std::vector<uint64_t>().swap(m_offsets);
+        std::vector<Outbox> outboxes(_outboxes.size());
+        for(size_t worker = 0; worker < outboxes.size(); ++worker)
+            outboxes[worker].m_fd = _outboxes[worker];
+        Outbox results;
+        results.m_fd = _results;
+        Inbox inbox;
+        inbox.m_fd = _inbox;
+
+        /// a robot in this worker's region, runnable once its stream holds m_expected commands
+        struct Resident
+        {
+            uint32_t m_slot = 0;
+            Fleet::Transform m_transform;
+            bool m_isPlaced = false;
+            uint64_t m_expected = 0;
+            std::vector<type::Command> m_stream;
+        };
+        // robots run on a fleet of this worker's own, slots of robots that left are reused
+        Fleet fleet(m_fleet.getExtentX(), m_fleet.getExtentY());
+        fleet.setObstacleMap(m_fleet.getObstacleMap());
+        std::vector<uint32_t> freeSlots;
+        std::unordered_map<uint32_t, Resident> residents;
+        // robots whose whole stream has arrived
+        std::deque<uint32_t> queue;
+        auto onArrived = [&](const uint32_t _robot, Resident& _resident)
+        {
+            if(freeSlots.empty())
+                _resident.m_slot = fleet.addRobot();
+            else
+            {
+                _resident.m_slot = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            fleet.setState(_resident.m_slot, _resident.m_transform, _resident.m_isPlaced);
+            queue.push_back(_robot);
+        };
+        uint64_t commands = 0;
+        uint64_t handoffs = 0;
+        bool isStopped = false;
+        while(!isStopped)
+        {
+            // messages of one robot come from one sender in order, other senders' batches can fall between them
+            while(inbox.receive([&](const Message& _message)
+            {
+                if(_message.m_kind == Message::STOP)
+                    isStopped = true;
+                if(_message.m_kind == Message::ROBOT)
+                {
+                    Resident& resident = residents[_message.m_robot];
+                    resident.m_transform = _unpackTransform(_message.m_transform);
+                    resident.m_isPlaced = _message.m_placed != 0;
+                    resident.m_expected = _message.m_cursor;
+                    resident.m_stream.reserve(resident.m_expected);
+                    if(resident.m_expected == 0)
+                        onArrived(_message.m_robot, resident);
+                }
+                else if(_message.m_kind == Message::COMMANDS)
+                {
+                    Resident& resident = residents[_message.m_robot];
+                    resident.m_stream.push_back(_unpackCommand(_message.m_cursor));
+                    if(_message.m_placed == 2)
+                        resident.m_stream.push_back(_unpackCommand(_message.m_extra));
+                    if(resident.m_stream.size() == resident.m_expected)
+                        onArrived(_message.m_robot, resident);
+                }
+            }))
+                ;
+            // run a slice of robots, then look at the pipes again so neighbours are not kept waiting
+            for(size_t slice = 0; slice < 1024 && !queue.empty(); ++slice)
+            {
+                const uint32_t robot = queue.front();
+                queue.pop_front();
+                auto itr = residents.find(robot);
+                Resident& resident = itr->second;
+                const uint64_t end = resident.m_stream.size();
+                const uint64_t cursor = _runRobot(fleet, resident.m_slot, resident.m_stream.data(), 0, end, _worker, commands);
+                const Fleet::Transform& transform = fleet.getTransform(resident.m_slot);
+                const bool isPlaced = fleet.isPlaced(resident.m_slot);
+                if(cursor < end)
+                {
+                    // the rest of the stream goes with the robot
+                    const auto position = fleet.getPosition(resident.m_slot);
+                    _send(outboxes[_region(position.x, position.y)].m_pending, robot, transform, isPlaced,
+                        resident.m_stream.data(), cursor, end);
+                    ++handoffs;
+                }
+                else
+                    results.m_pending.push_back(Message{ Message::RESULT, robot, _packTransform(transform), isPlaced ? 1u : 0u, 0, 0 });
+                freeSlots.push_back(resident.m_slot);
+                residents.erase(itr);
+            }
+            std::vector<pollfd> requests{ pollfd{ _inbox, POLLIN, 0 } };
+            for(Outbox& outbox : outboxes)
+            {
+                outbox.flush();
+                if(outbox.hasPending())
+                    requests.push_back(pollfd{ outbox.m_fd, POLLOUT, 0 });
+            }
+            results.flush();
+            if(results.hasPending())
+                requests.push_back(pollfd{ results.m_fd, POLLOUT, 0 });
+            // nothing to run, sleep until a robot arrives or a pipe has room
+            if(queue.empty() && !isStopped)
+                poll(requests.data(), requests.size(), -1);
+        }
+        results.m_pending.push_back(Message{ Message::STATS, _worker, 0, 0, commands, handoffs });
+        results.drain();
+        // skip destructors and exit hooks, they belong to the parent
+        _exit(0);
+    }
+
+    ShardRunner::ShardStats ShardRunner::run()
+    {
+        ShardStats stats;
+        const unsigned workers = workerCount();
+        const uint32_t robots = uint32_t(std::min<size_t>(m_fleet.size(), m_offsets.size() - 1));
+        // one inbox per worker and one pipe back to this process
+        std::vector<int> readEnds(workers);
+        std::vector<int> writeEnds(workers);
+        int results[2];
+        if(pipe(results) != 0)
+            return stats;
+        for(unsigned worker = 0; worker < workers; ++worker)
+        {
+            int ends[2];
+            if(pipe(ends) != 0)
+                return stats;
+            readEnds[worker] = ends[0];
+            writeEnds[worker] = ends[1];
+            _setNonBlocking(ends[0]);
+            _setNonBlocking(ends[1]);
+        }
+        _setNonBlocking(results[1]);
+        // buffered output would otherwise be flushed by every child too
+        fflush(nullptr);
+        // a worker that died closes its inbox, writing to it must fail instead of killing this process
+        const sighandler_t previousPipeHandler = signal(SIGPIPE, SIG_IGN);
+        std::vector<pid_t> children;
+        for(unsigned worker = 0; worker < workers; ++worker)
+        {
+            const pid_t child = fork();
+            if(child == 0)
+            {
+                // workers die with their neighbours, the parent then stops the rest
+                signal(SIGPIPE, SIG_DFL);
+                close(results[0]);
+                // only this worker reads its inbox, so a dead worker's inbox has no reader left
+                for(unsigned other = 0; other < workers; ++other)
+                    if(other != worker)
+                        close(readEnds[other]);
+                _work(worker, readEnds[worker], writeEnds, results[1]);
+            }
+            if(child < 0)
+            {
+                printf("SHARD: could not start worker %u\n", worker);
+                break;
+            }
+            children.push_back(child);
+        }
+        close(results[1]);
+        for(const int fd : readEnds)
+            close(fd);
+        _setNonBlocking(results[0]);
+
+        // every robot and its stream is sent to its first worker while results are read, so neither side waits on a full pipe
+        std::vector<std::vector<uint32_t>> assigned(workers);
+        for(uint32_t robot = 0; robot < robots; ++robot)
+            assigned[_owner(robot)].push_back(robot);
+        std::vector<size_t> nextAssigned(workers, 0);
+        std::vector<Outbox> inboxes(workers);
+        for(unsigned worker = 0; worker < workers; ++worker)
+            inboxes[worker].m_fd = writeEnds[worker];
+        auto send = [&]()
+        {
+            for(unsigned worker = 0; worker < workers; ++worker)
+            {
+                Outbox& outbox = inboxes[worker];
+                while(outbox.m_pending.size() < SEND_MESSAGES && nextAssigned[worker] < assigned[worker].size())
+                {
+                    const uint32_t robot = assigned[worker][nextAssigned[worker]++];
+                    _send(outbox.m_pending, robot, m_fleet.getTransform(robot), m_fleet.isPlaced(robot), m_commands.data(),
+                        m_offsets[robot], m_offsets[robot + 1]);
+                }
+                if(!outbox.flush())
+                    return false;
+            }
+            return true;
+        };
+
+        Inbox inbox;
+        inbox.m_fd = results[0];
+        uint32_t finished = 0;
+        uint32_t reported = 0;
+        auto onMessage = [&](const Message& _message)
+        {
+            if(_message.m_kind == Message::RESULT)
+            {
+                m_fleet.setState(_message.m_robot, _unpackTransform(_message.m_transform), _message.m_placed != 0);
+                ++finished;
+            }
+            else if(_message.m_kind == Message::STATS)
+            {
+                stats.m_workerCommands[_message.m_robot] = _message.m_cursor;
+                stats.m_commands += _message.m_cursor;
+                stats.m_handoffs += _message.m_extra;
+                ++reported;
+            }
+        };
+        // reap workers that have ended, a worker only exits by itself after its STATS and with status 0
+        size_t running = children.size();
+        bool hasDied = false;
+        auto reap = [&]()
+        {
+            for(pid_t& child : children)
+            {
+                int status = 0;
+                if(child <= 0 || waitpid(child, &status, WNOHANG) != child)
+                    continue;
+                child = -1;
+                --running;
+                hasDied = hasDied || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+            }
+            return !hasDied;
+        };
+        // read results until _count reaches _target, false if a worker died first
+        auto waitFor = [&](const uint32_t& _count, const uint32_t _target)
+        {
+            while(_count < _target)
+            {
+                if(!send())
+                    return false;
+                const bool wereAllReaped = running == 0;
+                std::vector<pollfd> requests{ pollfd{ results[0], POLLIN, 0 } };
+                for(const Outbox& outbox : inboxes)
+                    if(outbox.hasPending())
+                        requests.push_back(pollfd{ outbox.m_fd, POLLOUT, 0 });
+                // a pipe with room for more robots is progress too
+                if(poll(requests.data(), requests.size(), WAIT_MS) > 0 && (inbox.receive(onMessage) || requests.size() > 1))
+                    continue;
+                if(wereAllReaped || !reap())
+                    return false;
+            }
+            return true;
+        };
+        bool isFailed = children.size() != workers;
+        if(!isFailed)
+        {
+            stats.m_workerCommands.assign(workers, 0);
+            isFailed = !waitFor(finished, robots);
+            for(unsigned worker = 0; worker < workers && !isFailed; ++worker)
+            {
+                Outbox stop;
+                stop.m_fd = writeEnds[worker];
+                stop.m_pending.push_back(Message{ Message::STOP, 0, 0, 0, 0, 0 });
+                isFailed = !stop.drain();
+            }
+            isFailed = isFailed || !waitFor(reported, workers);
+            if(isFailed)
+                printf("SHARD: a worker ended before the run finished\n");
+        }
+        if(isFailed)
+        {
+            // a worker is missing or dead, the others can never finish
+            for(const pid_t child : children)
+                if(child > 0)
+                    kill(child, SIGKILL);
+            stats = ShardStats();
+        }
+        for(const int fd : writeEnds)
+            close(fd);
+        close(results[0]);
+        for(const pid_t child : children)
+            if(child > 0)
+                waitpid(child, nullptr, 0);
+        signal(SIGPIPE, previousPipeHandler);
+        return stats;
+    }
+}
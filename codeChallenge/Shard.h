@@ -0,0 +1,136 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include "Fleet.h"
+#include "Types.h"
+#include <stdint.h>
+#include <vector>
+
+namespace object
+{
+
+    /**
+     * Runs the command streams of a fleet across worker processes, one per rectangular region of the table
+     * @brief   the table is split into m_columns x m_rows regions and a worker process is forked for each.
+     *          a worker only holds the robots standing in its region and their streams, unplaced robots are
+     *          spread by slot. the calling process sends every robot's state and stream to its first worker over
+     *          a pipe and each worker runs them on a fleet of its own. when a command leaves a robot in another
+     *          region the robot, its state and the rest of its stream are sent to the worker owning that region,
+     *          which carries on from there. fleet robots do not block each other, so every robot runs its stream
+     *          in order exactly as runInProcess() does and the results are identical. final states are sent back
+     *          to the calling process and written into the fleet.
+     *          workers are forked from the calling process, so it must not have other threads running
+    */
+    class ShardRunner
+    {
+    public:
+        /// totals of a run
+        struct ShardStats
+        {
+            uint64_t m_commands = 0;
+            /// robots sent to another worker
+            uint64_t m_handoffs = 0;
+            /// commands run by each worker
+            std::vector<uint64_t> m_workerCommands;
+        };
+
+        /// one record on a pipe, sized so a full batch fits in one atomic pipe write
+        struct Message
+        {
+            enum KIND : uint32_t
+            {
+                ROBOT    = 0,
+                RESULT   = 1,
+                STATS    = 2,
+                STOP     = 3,
+                /// the next commands of the robot's stream, after its ROBOT
+                COMMANDS = 4
+            };
+            uint32_t m_kind;
+            uint32_t m_robot;
+            uint32_t m_transform;
+            /// placed flag, for COMMANDS how many of m_cursor and m_extra hold a command
+            uint32_t m_placed;
+            /// commands that follow in COMMANDS for ROBOT, commands run for STATS, a packed command for COMMANDS
+            uint64_t m_cursor;
+            /// handoffs for STATS, a packed command for COMMANDS
+            uint64_t m_extra;
+        };
+
+    private:
+        Fleet& m_fleet;
+        const unsigned m_columns;
+        const unsigned m_rows;
+        /// command streams of robots 0..n-1, stream i is m_commands[m_offsets[i]..m_offsets[i+1])
+        std::vector<type::Command> m_commands;
+        std::vector<uint64_t> m_offsets;
+
+        /**
+         * @brief region holding a cell
+        */
+        unsigned _region(const uint32_t _x, const uint32_t _y) const
+        {
+            const uint64_t column = uint64_t(_x) * m_columns / (uint64_t(m_fleet.getExtentX()) + 1);
+            const uint64_t row = uint64_t(_y) * m_rows / (uint64_t(m_fleet.getExtentY()) + 1);
+            return unsigned(row * m_columns + column);
+        }
+
+        /**
+         * @brief worker that starts with a robot
+        */
+        unsigned _owner(const uint32_t _robot) const;
+
+        /**
+         * @brief run a robot's stream from _cursor until _end or until the robot leaves the region _home
+         * @param _fleet fleet holding the robot in _slot
+         * @param _commands incremented for every command run
+         * @return stream position to continue from, _end when the stream finished
+        */
+        uint64_t _runRobot(Fleet& _fleet, const uint32_t _slot, const type::Command* _stream, uint64_t _cursor,
+            const uint64_t _end, const unsigned _home, uint64_t& _commands) const;
+
+        /**
+         * @brief queue a robot's state and the commands _stream[_cursor.._end) for a pipe, as a ROBOT and its COMMANDS
+        */
+        static void _send(std::vector<Message>& _pending, const uint32_t _robot, const Fleet::Transform& _transform,
+            const bool _isPlaced, const type::Command* _stream, uint64_t _cursor, const uint64_t _end);
+
+        /**
+         * @brief body of a worker process, runs the robots it is sent on a fleet of its own, never returns
+        */
+        [[noreturn]] void _work(const unsigned _worker, const int _inbox, const std::vector<int>& _outboxes, const int _results);
+
+    public:
+        /**
+         * @param _fleet robots to run, written with the final states
+         * @param _columns regions across the x axis
+         * @param _rows regions across the y axis
+        */
+        ShardRunner(Fleet& _fleet, const unsigned _columns, const unsigned _rows);
+
+        /**
+         * @brief add the command stream of the next robot slot, streams are added in slot order
+         * @return slot the stream belongs to
+        */
+        uint32_t addStream(const std::vector<type::Command>& _commands);
+
+        /**
+         * @brief amount of worker processes run() forks
+        */
+        unsigned workerCount() const { return m_columns * m_rows; };
+
+        /**
+         * @brief run every stream to its end in worker processes
+         * @return totals, m_workerCommands is empty if the workers could not be started or one of them died,
+         *         the fleet then holds the results received so far
+        */
+        ShardStats run();
+
+        /**
+         * @brief run every stream to its end in this process, the reference run() must match
+        */
+        ShardStats runInProcess();
+    };
+}
+
+#endif  // SHARD_H
@@ -0,0 +1,150 @@
+#include "SpatialIndex.h"
+#include <algorithm>
+#include <queue>
+#include <utility>
+
+namespace object
+{
+    SpatialIndex::SpatialIndex(const uint32_t _extentX, const uint32_t _extentY, const uint32_t _cellSize)
+        :   m_cellSize(_cellSize > 0 ? _cellSize : 1),
+            m_bucketsX((_extentX / m_cellSize) + 1),
+            m_bucketsY((_extentY / m_cellSize) + 1),
+            m_buckets(size_t(m_bucketsX) * m_bucketsY)
+    {}
+
+    void SpatialIndex::_detach(const uint32_t _robot)
+    {
+        std::vector<Entry>& bucket = m_buckets[m_bucketOf[_robot]];
+        const uint32_t slot = m_slotOf[_robot];
+        // move the last entry into the freed slot
+        bucket[slot] = bucket.back();
+        m_slotOf[bucket[slot].robot] = slot;
+        bucket.pop_back();
+        m_bucketOf[_robot] = NOT_INDEXED;
+    }
+
+    void SpatialIndex::update(const uint32_t _robot, const uint32_t _x, const uint32_t _y)
+    {
+        if(_robot >= m_bucketOf.size())
+        {
+            m_bucketOf.resize(_robot + 1, NOT_INDEXED);
+            m_slotOf.resize(_robot + 1, 0);
+        }
+        const uint32_t bucket = _bucket(_x, _y);
+        const uint32_t current = m_bucketOf[_robot];
+        // same bucket, just refresh the stored position
+        if(current == bucket)
+        {
+            Entry& entry = m_buckets[bucket][m_slotOf[_robot]];
+            entry.x = uint16_t(_x);
+            entry.y = uint16_t(_y);
+            return;
+        }
+        if(current != NOT_INDEXED)
+            _detach(_robot);
+        else
+            ++m_count;
+        std::vector<Entry>& target = m_buckets[bucket];
+        m_bucketOf[_robot] = bucket;
+        m_slotOf[_robot] = uint32_t(target.size());
+        target.push_back(Entry{ _robot, uint16_t(_x), uint16_t(_y) });
+    }
+
+    void SpatialIndex::remove(const uint32_t _robot)
+    {
+        if(_robot >= m_bucketOf.size() || m_bucketOf[_robot] == NOT_INDEXED)
+            return;
+        _detach(_robot);
+        --m_count;
+    }
+
+    void SpatialIndex::queryRect(const uint32_t _x0, const uint32_t _y0, const uint32_t _x1, const uint32_t _y1,
+        std::vector<uint32_t>& _result) const
+    {
+        if(_x0 > _x1 || _y0 > _y1)
+            return;
+        const uint32_t bx0 = std::min(_x0 / m_cellSize, m_bucketsX - 1);
+        const uint32_t by0 = std::min(_y0 / m_cellSize, m_bucketsY - 1);
+        const uint32_t bx1 = std::min(_x1 / m_cellSize, m_bucketsX - 1);
+        const uint32_t by1 = std::min(_y1 / m_cellSize, m_bucketsY - 1);
+        for(uint32_t by = by0; by <= by1; ++by)
+        {
+            for(uint32_t bx = bx0; bx <= bx1; ++bx)
+            {
+                const std::vector<Entry>& bucket = m_buckets[size_t(by) * m_bucketsX + bx];
+                // inner buckets are fully covered and need no per robot test
+                const bool isInner = bx > bx0 && bx < bx1 && by > by0 && by < by1;
+                for(const Entry& entry : bucket)
+                {
+                    if(isInner || (entry.x >= _x0 && entry.x <= _x1 && entry.y >= _y0 && entry.y <= _y1))
+                        _result.push_back(entry.robot);
+                }
+            }
+        }
+    }
+
+    void SpatialIndex::nearest(const uint32_t _x, const uint32_t _y, const uint32_t _k, std::vector<uint32_t>& _result) const
+    {
+        if(_k == 0 || m_count == 0)
+            return;
+        // max heap of the best candidates so far, worst on top
+        typedef std::pair<uint64_t, uint32_t> Candidate;
+        std::priority_queue<Candidate> best;
+        const int64_t qbx = std::min(_x / m_cellSize, m_bucketsX - 1);
+        const int64_t qby = std::min(_y / m_cellSize, m_bucketsY - 1);
+        const int64_t maxRing = std::max<int64_t>(
+            std::max<int64_t>(qbx, int64_t(m_bucketsX) - 1 - qbx),
+            std::max<int64_t>(qby, int64_t(m_bucketsY) - 1 - qby));
+
+        auto visit = [&](const int64_t _bx, const int64_t _by)
+        {
+            if(_bx < 0 || _by < 0 || _bx >= int64_t(m_bucketsX) || _by >= int64_t(m_bucketsY))
+                return;
+            for(const Entry& entry : m_buckets[size_t(_by) * m_bucketsX + size_t(_bx)])
+            {
+                const int64_t dx = int64_t(entry.x) - int64_t(_x);
+                const int64_t dy = int64_t(entry.y) - int64_t(_y);
+                const Candidate candidate(uint64_t(dx * dx + dy * dy), entry.robot);
+                if(best.size() < _k)
+                    best.push(candidate);
+                else if(candidate < best.top())
+                {
+                    best.pop();
+                    best.push(candidate);
+                }
+            }
+        };
+
+        // walk rings of buckets outwards from the query bucket
+        for(int64_t ring = 0; ring <= maxRing; ++ring)
+        {
+            if(ring == 0)
+                visit(qbx, qby);
+            else
+            {
+                for(int64_t i = -ring; i <= ring; ++i)
+                {
+                    visit(qbx + i, qby - ring);
+                    visit(qbx + i, qby + ring);
+                }
+                for(int64_t i = -ring + 1; i <= ring - 1; ++i)
+                {
+                    visit(qbx - ring, qby + i);
+                    visit(qbx + ring, qby + i);
+                }
+            }
+            // every robot beyond this ring is further than ring * m_cellSize away
+            const uint64_t bound = uint64_t(ring) * m_cellSize;
+            if(best.size() == _k && bound * bound > best.top().first)
+                break;
+        }
+
+        const size_t first = _result.size();
+        _result.resize(first + best.size());
+        for(size_t i = _result.size(); i > first; --i)
+        {
+            _result[i - 1] = best.top().second;
+            best.pop();
+        }
+    }
+}
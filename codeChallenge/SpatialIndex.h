@@ -0,0 +1,109 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace object
+{
+
+    /**
+     * Bucketed uniform grid over robot positions
+     * @brief   the table is split into square buckets of m_cellSize cells. every robot knows its bucket
+     *          and its slot inside the bucket, so moving between buckets is a swap-remove plus a push
+     *          and moving inside a bucket is a single write. positions are copied into the buckets
+     *          so queries never touch the fleet
+    */
+    class SpatialIndex
+    {
+    public:
+        /// marks a robot that is not in the index
+        static constexpr uint32_t NOT_INDEXED = ~uint32_t(0);
+
+    private:
+        /**
+         * robot position inside a bucket
+        */
+        struct Entry
+        {
+            uint32_t robot;
+            uint16_t x;
+            uint16_t y;
+        };
+
+        /// bucket edge in cells
+        const uint32_t m_cellSize;
+        /// amount of buckets on each axis
+        const uint32_t m_bucketsX;
+        const uint32_t m_bucketsY;
+        /// robots per bucket
+        std::vector<std::vector<Entry>> m_buckets;
+        /// bucket of each robot, NOT_INDEXED if absent
+        std::vector<uint32_t> m_bucketOf;
+        /// slot of each robot inside its bucket
+        std::vector<uint32_t> m_slotOf;
+        /// amount of indexed robots
+        size_t m_count = 0;
+
+        /**
+         * @brief bucket holding a cell
+        */
+        uint32_t _bucket(const uint32_t _x, const uint32_t _y) const
+        {
+            return (_y / m_cellSize) * m_bucketsX + (_x / m_cellSize);
+        }
+
+        /**
+         * @brief remove a robot from its bucket with a swap-remove
+        */
+        void _detach(const uint32_t _robot);
+
+    public:
+        /**
+         * @param _extentX largest x axis value, inclusive like TABLE_TOP_X
+         * @param _extentY largest y axis value, inclusive like TABLE_TOP_Y
+         * @param _cellSize bucket edge in cells
+        */
+        SpatialIndex(const uint32_t _extentX, const uint32_t _extentY, const uint32_t _cellSize = 64);
+
+        /**
+         * @brief insert or move a robot
+         * @param _robot fleet slot of the robot
+         * @param _x x axis of the robot
+         * @param _y y axis of the robot
+        */
+        void update(const uint32_t _robot, const uint32_t _x, const uint32_t _y);
+
+        /**
+         * @brief remove a robot
+         * @param _robot fleet slot of the robot
+        */
+        void remove(const uint32_t _robot);
+
+        /**
+         * @brief collect every robot inside an inclusive rectangle
+         * @param _x0,_y0 lower corner
+         * @param _x1,_y1 upper corner
+         * @param _result robots found, appended in bucket order
+        */
+        void queryRect(const uint32_t _x0, const uint32_t _y0, const uint32_t _x1, const uint32_t _y1,
+            std::vector<uint32_t>& _result) const;
+
+        /**
+         * @brief collect the k robots closest to a cell
+         * @brief distance is euclidean, ties are broken by the lowest robot slot
+         * @param _x,_y cell to search from
+         * @param _k amount of robots wanted
+         * @param _result robots found, closest first
+        */
+        void nearest(const uint32_t _x, const uint32_t _y, const uint32_t _k, std::vector<uint32_t>& _result) const;
+
+        /**
+         * @brief amount of indexed robots
+        */
+        size_t size() const { return m_count; };
+    };
+}
+
+#endif  // SPATIAL_INDEX_H
@@ -0,0 +1,114 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace object
+{
+
+    /**
+     * Bounded single producer single consumer queue
+     * @brief   a ring of m_capacity slots with one atomic index per side. the producer only writes m_tail and
+     *          the consumer only writes m_head, so neither side takes a lock. a full queue makes push() wait,
+     *          which is how a slow consumer applies backpressure to its producer
+    */
+    template <typename T>
+    class SpscQueue
+    {
+        /// keeps the indices on separate cache lines
+        static constexpr size_t CACHE_LINE = 64;
+
+        std::vector<T> m_slots;
+        const size_t m_capacity;
+        /// next slot to read, written by the consumer
+        alignas(CACHE_LINE) std::atomic<size_t> m_head{0};
+        /// next slot to write, written by the producer
+        alignas(CACHE_LINE) std::atomic<size_t> m_tail{0};
+        /// set by the producer once nothing more will be pushed
+        alignas(CACHE_LINE) std::atomic<bool> m_isClosed{false};
+
+    public:
+        SpscQueue(const size_t _capacity)
+            :   m_slots(_capacity + 1),
+                m_capacity(_capacity + 1)
+        {};
+        SpscQueue(const SpscQueue&) = delete;
+        void operator=(const SpscQueue&) = delete;
+
+        /**
+         * @brief try to add an item without waiting
+         * @param _item item to move into the queue
+         * @return false if the queue is full, _item is left untouched
+        */
+        bool tryPush(T& _item)
+        {
+            const size_t tail = m_tail.load(std::memory_order_relaxed);
+            const size_t next = (tail + 1) % m_capacity;
+            if(next == m_head.load(std::memory_order_acquire))
+                return false;
+            m_slots[tail] = std::move(_item);
+            m_tail.store(next, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief add an item, waiting while the queue is full
+         * @param _item item to move into the queue
+        */
+        void push(T _item)
+        {
+            while(!tryPush(_item))
+                std::this_thread::yield();
+        }
+
+        /**
+         * @brief try to take an item without waiting
+         * @param _item receives the item
+         * @return false if the queue is empty
+        */
+        bool tryPop(T& _item)
+        {
+            const size_t head = m_head.load(std::memory_order_relaxed);
+            if(head == m_tail.load(std::memory_order_acquire))
+                return false;
+            _item = std::move(m_slots[head]);
+            m_head.store((head + 1) % m_capacity, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief take an item, waiting while the queue is empty and open
+         * @param _item receives the item
+         * @return false once the queue is closed and drained
+        */
+        bool pop(T& _item)
+        {
+            while(!tryPop(_item))
+            {
+                if(m_isClosed.load(std::memory_order_acquire))
+                    return tryPop(_item);
+                std::this_thread::yield();
+            }
+            return true;
+        }
+
+        /**
+         * @brief check if there is nothing to pop right now
+        */
+        bool isEmpty() const
+        {
+            return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief mark the end of the stream, called by the producer after its last push
+        */
+        void close() { m_isClosed.store(true, std::memory_order_release); };
+    };
+}
+
+#endif  // SPSC_QUEUE_H
@@ -0,0 +1,180 @@
+#ifndef STATIC_ROBOT_H
+#define STATIC_ROBOT_H
+
+#include "Objects.h"
+#include "Types.h"
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+
+namespace object
+{
+
+    /**
+     * Toy robot specialised for one table size at compile time
+     * @brief   the extents are template arguments, so every bounds check compares against a constant and the
+     *          transform width defaults to the smallest T_Transform that holds them. there is no action map,
+     *          obstacle map, history or listener, only the PLACE, MOVE, LEFT, RIGHT and REPORT rules of ToyRobot.
+     *          use ToyRobot when the table size is only known at runtime or those features are needed
+     * @param EXTENT_X largest x axis value, inclusive like TABLE_TOP_X
+     * @param EXTENT_Y largest y axis value, inclusive like TABLE_TOP_Y
+     * @param T transform width, picked from the extents when omitted
+    */
+    template <uint32_t EXTENT_X, uint32_t EXTENT_Y,
+        typename T = typename type::T_SmallestTransform<(EXTENT_X > EXTENT_Y ? EXTENT_X : EXTENT_Y)>::type>
+    class StaticRobot
+    {
+        static_assert(type::axisLimit<T>() >= EXTENT_X && type::axisLimit<T>() >= EXTENT_Y,
+            "transform type is too small for the table extents");
+
+        /// position and rotation
+        type::T_Transform<T> m_transform;
+        /// robot is on the table
+        bool m_hasBeenPlaced = false;
+        /// receives REPORT output, printed when empty
+        std::function<void(const std::string&)> m_reportCallback;
+
+    public:
+        typedef T TransformType;
+
+        StaticRobot(){};
+
+        /**
+         * @brief place the robot
+         * @param _x x axis position
+         * @param _y y axis position
+         * @param _rotation heading to face
+         * @return false if the placement is off the table or the heading is invalid
+        */
+        bool placeHere(const uint32_t _x, const uint32_t _y, const type::HEADING _rotation)
+        {
+            if(_x > EXTENT_X || _y > EXTENT_Y || _rotation > type::HEADING::WEST)
+                return false;
+            m_transform.setPosition(type::T_Position<T>(T(_x), T(_y)));
+            m_transform.setRotation(_rotation);
+            m_hasBeenPlaced = true;
+            return true;
+        }
+
+        /**
+         * @brief move one unit forward
+         * @return false if unplaced or the move would leave the table
+        */
+        bool move()
+        {
+            if(!m_hasBeenPlaced)
+                return false;
+            auto position = m_transform.getPosition();
+            switch (m_transform.getRotation())
+            {
+            case type::HEADING::NORTH:
+                if(position.y == EXTENT_Y)
+                    return false;
+                ++position.y;
+                break;
+            case type::HEADING::EAST:
+                if(position.x == EXTENT_X)
+                    return false;
+                ++position.x;
+                break;
+            case type::HEADING::SOUTH:
+                if(position.y == 0)
+                    return false;
+                --position.y;
+                break;
+            default:
+                if(position.x == 0)
+                    return false;
+                --position.x;
+                break;
+            }
+            m_transform.setPosition(position);
+            return true;
+        }
+
+        /**
+         * @brief rotate 90 degrees counter clockwise
+         * @return false if unplaced
+        */
+        bool rotateLeft()
+        {
+            if(!m_hasBeenPlaced)
+                return false;
+            m_transform.setRotation(type::HEADING((m_transform.getRotation() + 3) & 3));
+            return true;
+        }
+
+        /**
+         * @brief rotate 90 degrees clockwise
+         * @return false if unplaced
+        */
+        bool rotateRight()
+        {
+            if(!m_hasBeenPlaced)
+                return false;
+            m_transform.setRotation(type::HEADING((m_transform.getRotation() + 1) & 3));
+            return true;
+        }
+
+        /**
+         * @brief position and heading in REPORT form
+        */
+        std::string getReport() const
+        {
+            const auto position = m_transform.getPosition();
+            std::string result;
+            result.append(std::to_string(position.x)).append(",");
+            result.append(std::to_string(position.y)).append(",");
+            result.append(type::headingMap.at(m_transform.getRotation()));
+            return result;
+        }
+
+        /**
+         * @brief run a pre-parsed command, UNDO and REDO are not supported
+         * @param _command command from InputHandler::parseCommand
+         * @return true if the command was accepted
+        */
+        bool execute(const type::Command& _command)
+        {
+            switch (_command.action)
+            {
+            case type::ACTION::PLACE:
+                return placeHere(_command.x, _command.y, _command.heading);
+            case type::ACTION::MOVE:
+                return move();
+            case type::ACTION::LEFT:
+                return rotateLeft();
+            case type::ACTION::RIGHT:
+                return rotateRight();
+            case type::ACTION::REPORT:
+                if(!m_hasBeenPlaced)
+                    return false;
+                if(m_reportCallback)
+                    m_reportCallback(getReport());
+                else
+                    printf( "Output : %s\n" ,getReport().c_str());
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        /**
+         * @brief parse and run a command string
+         * @param _input user input
+         * @return true if the command was accepted
+        */
+        bool proccessInput(std::string_view _input)
+        {
+            type::Command command;
+            return InputHandler::parseCommand(_input, command) && execute(command);
+        }
+
+        const type::T_Transform<T>& getTransform() const { return m_transform; };
+        bool isPlaced() const { return m_hasBeenPlaced; };
+        void setReportCallback(std::function<void(const std::string&)> _callback) { m_reportCallback = std::move(_callback); };
+    };
+}
+
+#endif  // STATIC_ROBOT_H
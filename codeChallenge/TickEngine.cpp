@@ -0,0 +1,277 @@
+#include "TickEngine.h"
+#include "Parallel.h"
+
+namespace object
+{
+    TickEngine::TickEngine(Fleet& _fleet, const ObstacleMap* _obstacleMap, const unsigned _threadCount)
+        :   m_fleet(_fleet),
+            m_obstacleMap(_obstacleMap),
+            m_threadCount(_threadCount),
+            m_width(_fleet.getExtentX() + 1),
+            m_height(_fleet.getExtentY() + 1),
+            m_offsets(1, 0),
+            m_targets(_fleet.size(), NO_CELL)
+    {
+        size_t capacity = 64;
+        while(capacity < size_t(_fleet.size()) * 8)
+            capacity *= 2;
+        const size_t cells = size_t(m_width) * m_height;
+        m_isDense = cells <= capacity;
+        m_cells.reset(new CellSlot[m_isDense ? cells : capacity]);
+        m_cellMask = capacity - 1;
+        for(unsigned buffer = 0; buffer < 2; ++buffer)
+        {
+            m_transforms[buffer].resize(_fleet.size());
+            m_placed[buffer].resize(_fleet.size());
+        }
+        for(uint32_t robot = 0; robot < _fleet.size(); ++robot)
+        {
+            if(!_fleet.isPlaced(robot))
+                continue;
+            const auto position = _fleet.getPosition(robot);
+            m_transforms[m_current][robot].setPosition(position);
+            m_transforms[m_current][robot].setRotation(_fleet.getRotation(robot));
+            m_placed[m_current][robot] = 1;
+        }
+        _rebuildCells();
+    }
+
+    void TickEngine::_rebuildCells()
+    {
+        const size_t slots = m_isDense ? size_t(m_width) * m_height : m_cellMask + 1;
+        for(size_t index = 0; index < slots; ++index)
+        {
+            m_cells[index].m_cell.store(NO_CELL, std::memory_order_relaxed);
+            m_cells[index].m_claim.store(NO_CELL, std::memory_order_relaxed);
+            m_cells[index].m_occupancy.store(0, std::memory_order_relaxed);
+        }
+        m_cellCount = 0;
+        for(uint32_t robot = 0; robot < size(); ++robot)
+        {
+            if(!m_placed[m_current][robot])
+                continue;
+            const auto position = m_transforms[m_current][robot].getPosition();
+            _slot(_cell(position.x, position.y), m_cellCount).m_occupancy.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    uint32_t TickEngine::addStream(const std::vector<type::Command>& _commands)
+    {
+        if(m_offsets.size() > size())
+            return NO_ROBOT;
+        m_commands.insert(m_commands.end(), _commands.begin(), _commands.end());
+        m_offsets.push_back(m_commands.size());
+        return uint32_t(m_offsets.size() - 2);
+    }
+
+    const type::Command* TickEngine::_command(const uint32_t _robot) const
+    {
+        if(_robot + 1 >= m_offsets.size())
+            return nullptr;
+        const uint64_t begin = m_offsets[_robot];
+        const uint64_t length = m_offsets[_robot + 1] - begin;
+        if(length == 0 || (!m_isLooping && m_tick >= length))
+            return nullptr;
+        return &m_commands[begin + (m_isLooping ? m_tick % length : m_tick)];
+    }
+
+    void TickEngine::_propose(const size_t _begin, const size_t _end, TickStats& _stats, uint64_t& _inserted)
+    {
+        const std::vector<Transform>& current = m_transforms[m_current];
+        const std::vector<uint8_t>& currentPlaced = m_placed[m_current];
+        std::vector<Transform>& next = m_transforms[m_current ^ 1];
+        std::vector<uint8_t>& nextPlaced = m_placed[m_current ^ 1];
+        for(size_t robot = _begin; robot < _end; ++robot)
+        {
+            Transform transform = current[robot];
+            const bool isPlaced = currentPlaced[robot] != 0;
+            uint32_t target = NO_CELL;
+            bool isAccepted = false;
+            const type::Command* command = _command(uint32_t(robot));
+            if(command != nullptr)
+            {
+                ++_stats.m_commands;
+                switch (command->action)
+                {
+                case type::ACTION::PLACE:
+                    if(_isFree(command->x, command->y) && command->heading <= type::HEADING::WEST)
+                    {
+                        const auto position = transform.getPosition();
+                        transform.setPosition(type::T_Position<uint32_t>(command->x, command->y));
+                        transform.setRotation(command->heading);
+                        // re-placing on its own cell cannot collide
+                        if(isPlaced && position.x == command->x && position.y == command->y)
+                            isAccepted = true;
+                        else
+                            target = _cell(command->x, command->y);
+                    }
+                    break;
+                case type::ACTION::MOVE:
+                    if(isPlaced)
+                    {
+                        auto position = transform.getPosition();
+                        // unsigned wrap takes a step off the west or south edge out of range
+                        uint32_t x = position.x;
+                        uint32_t y = position.y;
+                        switch (transform.getRotation())
+                        {
+                        case type::HEADING::NORTH:  ++y; break;
+                        case type::HEADING::SOUTH:  --y; break;
+                        case type::HEADING::EAST:   ++x; break;
+                        default:                    --x; break;
+                        }
+                        if(_isFree(x, y))
+                        {
+                            transform.setPosition(type::T_Position<uint32_t>(x, y));
+                            target = _cell(x, y);
+                        }
+                    }
+                    break;
+                case type::ACTION::LEFT:
+                    if(isPlaced)
+                    {
+                        transform.setRotation(type::HEADING((transform.getRotation() + 3) & 0b11));
+                        isAccepted = true;
+                    }
+                    break;
+                case type::ACTION::RIGHT:
+                    if(isPlaced)
+                    {
+                        transform.setRotation(type::HEADING((transform.getRotation() + 1) & 0b11));
+                        isAccepted = true;
+                    }
+                    break;
+                case type::ACTION::REPORT:
+                    isAccepted = isPlaced;
+                    break;
+                default:
+                    break;
+                }
+                if(target == NO_CELL)
+                {
+                    if(isAccepted)
+                        ++_stats.m_accepted;
+                    else
+                        ++_stats.m_rejected;
+                }
+            }
+            if(target != NO_CELL)
+            {
+                // keep the lowest slot, the result does not depend on which thread claims first
+                std::atomic<uint32_t>& claim = _slot(target, _inserted).m_claim;
+                uint32_t owner = claim.load(std::memory_order_relaxed);
+                while(robot < owner && !claim.compare_exchange_weak(owner, uint32_t(robot), std::memory_order_relaxed))
+                    ;
+            }
+            m_targets[robot] = target;
+            next[robot] = transform;
+            nextPlaced[robot] = isPlaced || target != NO_CELL;
+        }
+    }
+
+    void TickEngine::_resolve(const size_t _begin, const size_t _end, TickStats& _stats)
+    {
+        std::vector<Transform>& next = m_transforms[m_current ^ 1];
+        std::vector<uint8_t>& nextPlaced = m_placed[m_current ^ 1];
+        for(size_t robot = _begin; robot < _end; ++robot)
+        {
+            const uint32_t target = m_targets[robot];
+            if(target == NO_CELL)
+                continue;
+            uint64_t inserted = 0;
+            CellSlot& slot = _slot(target, inserted);
+            if(slot.m_claim.load(std::memory_order_relaxed) == robot && slot.m_occupancy.load(std::memory_order_relaxed) == 0)
+            {
+                ++_stats.m_accepted;
+                continue;
+            }
+            // lost the cell, keep the state from the start of the tick
+            next[robot] = m_transforms[m_current][robot];
+            nextPlaced[robot] = m_placed[m_current][robot];
+            m_targets[robot] = target | REJECTED;
+            ++_stats.m_rejected;
+            ++_stats.m_collisions;
+        }
+    }
+
+    void TickEngine::_settle(const size_t _begin, const size_t _end)
+    {
+        for(size_t robot = _begin; robot < _end; ++robot)
+        {
+            const uint32_t target = m_targets[robot];
+            if(target == NO_CELL)
+                continue;
+            // every cell here already has a slot from propose or the last rebuild
+            uint64_t inserted = 0;
+            CellSlot& slot = _slot(target & ~REJECTED, inserted);
+            slot.m_claim.store(NO_CELL, std::memory_order_relaxed);
+            if(target & REJECTED)
+                continue;
+            slot.m_occupancy.fetch_add(1, std::memory_order_relaxed);
+            if(m_placed[m_current][robot])
+            {
+                const auto position = m_transforms[m_current][robot].getPosition();
+                _slot(_cell(position.x, position.y), inserted).m_occupancy.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    TickEngine::TickStats TickEngine::tick()
+    {
+        const size_t robots = size();
+        const size_t blocks = (robots + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        // a tick takes at most one slot per robot, keep the table at most half full
+        if(!m_isDense && (m_cellCount + robots) * 2 > m_cellMask + 1)
+            _rebuildCells();
+        // one counter set per block, summed once the phases are done
+        std::vector<TickStats> blockStats(blocks);
+        std::vector<uint64_t> blockInserts(blocks, 0);
+        auto forEachBlock = [&](auto&& _phase)
+        {
+            parallelFor(blocks, m_threadCount, [&](const size_t _block, const unsigned)
+            {
+                _phase(_block * BLOCK_SIZE, std::min(robots, (_block + 1) * BLOCK_SIZE), blockStats[_block]);
+            });
+        };
+        parallelFor(blocks, m_threadCount, [&](const size_t _block, const unsigned)
+        {
+            _propose(_block * BLOCK_SIZE, std::min(robots, (_block + 1) * BLOCK_SIZE), blockStats[_block], blockInserts[_block]);
+        });
+        forEachBlock([&](size_t _begin, size_t _end, TickStats& _stats){ _resolve(_begin, _end, _stats); });
+        forEachBlock([&](size_t _begin, size_t _end, TickStats&){ _settle(_begin, _end); });
+        m_current ^= 1;
+        ++m_tick;
+        for(const uint64_t inserted : blockInserts)
+            m_cellCount += inserted;
+
+        TickStats stats;
+        for(const TickStats& block : blockStats)
+        {
+            stats.m_commands += block.m_commands;
+            stats.m_accepted += block.m_accepted;
+            stats.m_rejected += block.m_rejected;
+            stats.m_collisions += block.m_collisions;
+        }
+        return stats;
+    }
+
+    TickEngine::TickStats TickEngine::run(const uint64_t _ticks)
+    {
+        TickStats stats;
+        for(uint64_t i = 0; i < _ticks; ++i)
+        {
+            const TickStats result = tick();
+            stats.m_commands += result.m_commands;
+            stats.m_accepted += result.m_accepted;
+            stats.m_rejected += result.m_rejected;
+            stats.m_collisions += result.m_collisions;
+        }
+        return stats;
+    }
+
+    void TickEngine::syncToFleet()
+    {
+        for(uint32_t robot = 0; robot < size(); ++robot)
+            m_fleet.setState(robot, m_transforms[m_current][robot], m_placed[m_current][robot] != 0);
+    }
+}
@@ -0,0 +1,188 @@
+#ifndef TICK_ENGINE_H
+#define TICK_ENGINE_H
+
+#include "Fleet.h"
+#include "Obstacles.h"
+#include "Types.h"
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+namespace object
+{
+
+    /**
+     * Lockstep simulation of a fleet
+     * @brief   every robot with a command stream runs exactly one command per tick. a tick has three phases,
+     *          each run in parallel over blocks of robots:
+     *          - propose: read the current state buffer, write the next state of each robot into the other
+     *            buffer and claim the target cell of every PLACE and MOVE. the lowest slot wins a cell
+     *          - resolve: a claim is accepted when the robot won its cell and the cell was empty at the start
+     *            of the tick, otherwise the robot keeps its current state
+     *          - settle: clear claims and move accepted robots in the per cell occupancy counts
+     *          claims and occupancy are kept per cell in a table sized by the robot count rather than the table
+     *          area. when the whole table fits it is indexed by cell directly, otherwise it is open addressed
+     *          by the cells robots stand on or target and rebuilt from the robot positions between ticks before
+     *          it gets half full, so a sparse fleet on a large table stays small.
+     *          robots cannot follow into a cell vacated in the same tick and cannot swap cells, so the result
+     *          does not depend on the thread count or scheduling. the buffers are swapped after each tick
+     *          and the fleet is only written by syncToFleet()
+    */
+    class TickEngine
+    {
+    public:
+        typedef Fleet::Transform Transform;
+        /// slot returned by addStream when every robot already has a stream
+        static constexpr uint32_t NO_ROBOT = UINT32_MAX;
+
+        /// totals of one or more ticks
+        struct TickStats
+        {
+            /// robots that had a command
+            uint64_t m_commands = 0;
+            uint64_t m_accepted = 0;
+            /// includes collisions
+            uint64_t m_rejected = 0;
+            /// PLACE or MOVE lost to another robot or an occupied cell
+            uint64_t m_collisions = 0;
+        };
+
+    private:
+        /// robots per parallel block
+        static constexpr size_t BLOCK_SIZE = 1 << 15;
+        /// no claim on a cell, or no target for a robot
+        static constexpr uint32_t NO_CELL = UINT32_MAX;
+        /// set on a robot target when its claim was rejected
+        static constexpr uint32_t REJECTED = 1u << 31;
+        static_assert(uint64_t(Fleet::MAX_EXTENT + 1) * (Fleet::MAX_EXTENT + 1) < REJECTED, "cell ids must not reach REJECTED");
+
+        /// claim and occupancy of one cell, m_cell is NO_CELL while the slot is free
+        struct CellSlot
+        {
+            std::atomic<uint32_t> m_cell{ NO_CELL };
+            /// lowest robot claiming the cell this tick
+            std::atomic<uint32_t> m_claim{ NO_CELL };
+            /// robots in the cell at the start of the tick
+            std::atomic<uint32_t> m_occupancy{ 0 };
+        };
+
+        Fleet& m_fleet;
+        /// optional static obstacles, not owned
+        const ObstacleMap* m_obstacleMap;
+        const unsigned m_threadCount;
+        /// cells per axis
+        const uint32_t m_width;
+        const uint32_t m_height;
+        /// double buffered robot state, m_current is read and the other buffer written during a tick
+        std::vector<Transform> m_transforms[2];
+        std::vector<uint8_t> m_placed[2];
+        unsigned m_current = 0;
+        /// command streams of robots 0..n-1, stream i is m_commands[m_offsets[i]..m_offsets[i+1])
+        std::vector<type::Command> m_commands;
+        std::vector<uint64_t> m_offsets;
+        bool m_isLooping = false;
+        uint64_t m_tick = 0;
+        /// cell table, one slot per cell when m_isDense, otherwise open addressed with a power of two slots
+        /// at least eight times the robot count
+        std::unique_ptr<CellSlot[]> m_cells;
+        size_t m_cellMask = 0;
+        bool m_isDense = false;
+        /// open addressed slots in use, counted between ticks
+        uint64_t m_cellCount = 0;
+        /// cell claimed by each robot this tick
+        std::vector<uint32_t> m_targets;
+
+        uint32_t _cell(const uint32_t _x, const uint32_t _y) const { return _y * m_width + _x; };
+
+        /**
+         * @brief slot of a cell, taken if the cell has none yet. safe to call from several threads
+         * @param _inserted incremented when a slot is taken
+        */
+        CellSlot& _slot(const uint32_t _cell, uint64_t& _inserted)
+        {
+            if(m_isDense)
+                return m_cells[_cell];
+            size_t index = (uint64_t(_cell) * 0x9e3779b97f4a7c15ull >> 32) & m_cellMask;
+            while(true)
+            {
+                CellSlot& slot = m_cells[index];
+                uint32_t cell = slot.m_cell.load(std::memory_order_relaxed);
+                if(cell == NO_CELL && slot.m_cell.compare_exchange_strong(cell, _cell, std::memory_order_relaxed))
+                {
+                    ++_inserted;
+                    return slot;
+                }
+                if(cell == _cell)
+                    return slot;
+                index = (index + 1) & m_cellMask;
+            }
+        }
+
+        /**
+         * @brief empty the cell table and fill it with the occupancy of the current state
+        */
+        void _rebuildCells();
+
+        bool _isFree(const uint32_t _x, const uint32_t _y) const
+        {
+            return _x < m_width && _y < m_height && (m_obstacleMap == nullptr || !m_obstacleMap->isBlocked(_x, _y));
+        }
+
+        /**
+         * @brief command of a robot for the current tick
+         * @return nullptr if the robot has nothing to run
+        */
+        const type::Command* _command(const uint32_t _robot) const;
+
+        void _propose(const size_t _begin, const size_t _end, TickStats& _stats, uint64_t& _inserted);
+        void _resolve(const size_t _begin, const size_t _end, TickStats& _stats);
+        void _settle(const size_t _begin, const size_t _end);
+
+    public:
+        /**
+         * @brief copy the fleet state into the engine
+         * @brief robots added to the fleet later are not simulated
+         * @param _fleet robots to simulate
+         * @param _obstacleMap obstacles to respect, may be nullptr
+         * @param _threadCount worker threads per phase, 0 for all cores
+        */
+        TickEngine(Fleet& _fleet, const ObstacleMap* _obstacleMap = nullptr, const unsigned _threadCount = 0);
+        TickEngine(const TickEngine&) = delete;
+        void operator=(const TickEngine&) = delete;
+
+        /**
+         * @brief append the command stream of the next robot without one, robots are assigned in slot order
+         * @return slot of the robot that runs the stream, NO_ROBOT if every simulated robot has one
+        */
+        uint32_t addStream(const std::vector<type::Command>& _commands);
+
+        /**
+         * @brief restart streams from their first command once they run out, instead of idling
+        */
+        void setLooping(const bool _isLooping) { m_isLooping = _isLooping; };
+
+        /**
+         * @brief advance every robot by one command
+        */
+        TickStats tick();
+
+        /**
+         * @brief advance every robot by _ticks commands
+        */
+        TickStats run(const uint64_t _ticks);
+
+        /**
+         * @brief copy the simulated state back into the fleet
+        */
+        void syncToFleet();
+
+        uint64_t getTick() const { return m_tick; };
+        size_t size() const { return m_placed[m_current].size(); };
+        type::T_Position<uint32_t> getPosition(const uint32_t _robot) const { return m_transforms[m_current][_robot].getPosition(); };
+        type::HEADING getRotation(const uint32_t _robot) const { return m_transforms[m_current][_robot].getRotation(); };
+        bool isPlaced(const uint32_t _robot) const { return m_placed[m_current][_robot] != 0; };
+    };
+}
+
+#endif  // TICK_ENGINE_H
@@ -0,0 +1,144 @@
+#include "Tokenizer.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TOKENIZER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace object
+{
+    namespace
+    {
+        /// bytes scanned per block by the vector paths
+        constexpr size_t BLOCK = 64;
+        /// bytes split() scans per findDelimiters call, so the 32 bit offsets never wrap
+        constexpr size_t SPLIT_WINDOW = size_t(1) << 30;
+
+        /**
+         * @brief emit every set bit of a block mask as a delimiter offset
+        */
+        inline void _emitMask(uint64_t _mask, const uint32_t _base, std::vector<uint32_t>& _positions)
+        {
+            while(_mask != 0)
+            {
+                _positions.push_back(_base + uint32_t(__builtin_ctzll(_mask)));
+                // clear lowest set bit
+                _mask &= _mask - 1;
+            }
+        }
+
+        /**
+         * @brief byte by byte scan from _begin to the end of _text
+        */
+        void _findScalar(std::string_view _text, size_t _begin, std::vector<uint32_t>& _positions)
+        {
+            for(size_t i = _begin; i < _text.size(); ++i)
+            {
+                if(Tokenizer::isDelimiter(_text[i]))
+                    _positions.push_back(uint32_t(i));
+            }
+        }
+
+#ifdef TOKENIZER_X86
+        /**
+         * @brief scan 64 byte blocks with four 16 byte SSE2 compares each
+         * @return offset of the first byte not scanned
+        */
+        size_t _findSse2(std::string_view _text, std::vector<uint32_t>& _positions)
+        {
+            const __m128i pipe = _mm_set1_epi8('|');
+            const __m128i newLine = _mm_set1_epi8('\n');
+            const __m128i carriage = _mm_set1_epi8('\r');
+            const char* data = _text.data();
+            size_t i = 0;
+            for(; i + BLOCK <= _text.size(); i += BLOCK)
+            {
+                uint64_t mask = 0;
+                for(size_t lane = 0; lane < 4; ++lane)
+                {
+                    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + lane * 16));
+                    const __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, pipe),
+                        _mm_cmpeq_epi8(bytes, newLine)), _mm_cmpeq_epi8(bytes, carriage));
+                    mask |= uint64_t(uint32_t(_mm_movemask_epi8(hits))) << (lane * 16);
+                }
+                _emitMask(mask, uint32_t(i), _positions);
+            }
+            return i;
+        }
+
+        /**
+         * @brief scan 64 byte blocks with two 32 byte AVX2 compares each
+         * @return offset of the first byte not scanned
+        */
+        __attribute__((target("avx2")))
+        size_t _findAvx2(std::string_view _text, std::vector<uint32_t>& _positions)
+        {
+            const __m256i pipe = _mm256_set1_epi8('|');
+            const __m256i newLine = _mm256_set1_epi8('\n');
+            const __m256i carriage = _mm256_set1_epi8('\r');
+            const char* data = _text.data();
+            size_t i = 0;
+            for(; i + BLOCK <= _text.size(); i += BLOCK)
+            {
+                const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32));
+                const __m256i lowHits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(low, pipe),
+                    _mm256_cmpeq_epi8(low, newLine)), _mm256_cmpeq_epi8(low, carriage));
+                const __m256i highHits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(high, pipe),
+                    _mm256_cmpeq_epi8(high, newLine)), _mm256_cmpeq_epi8(high, carriage));
+                const uint64_t mask = uint64_t(uint32_t(_mm256_movemask_epi8(lowHits)))
+                    | (uint64_t(uint32_t(_mm256_movemask_epi8(highHits))) << 32);
+                _emitMask(mask, uint32_t(i), _positions);
+            }
+            return i;
+        }
+#endif
+    }
+
+    Tokenizer::ISA Tokenizer::bestIsa()
+    {
+#ifdef TOKENIZER_X86
+        static const ISA best = __builtin_cpu_supports("avx2") ? ISA::AVX2 : ISA::SSE2;
+        return best;
+#else
+        return ISA::SCALAR;
+#endif
+    }
+
+    void Tokenizer::findDelimiters(std::string_view _text, std::vector<uint32_t>& _positions, ISA _isa)
+    {
+        if(_isa > bestIsa())
+            _isa = bestIsa();
+        size_t scanned = 0;
+#ifdef TOKENIZER_X86
+        if(_isa == ISA::AVX2)
+            scanned = _findAvx2(_text, _positions);
+        else if(_isa == ISA::SSE2)
+            scanned = _findSse2(_text, _positions);
+#endif
+        // tail shorter than a block, or no vector support
+        _findScalar(_text, scanned, _positions);
+    }
+
+    size_t Tokenizer::split(std::string_view _text, std::vector<std::string_view>& _commands, ISA _isa)
+    {
+        thread_local std::vector<uint32_t> positions;
+        size_t begin = 0;
+        // offsets are relative to the window, text of any size is scanned one window at a time
+        for(size_t window = 0; window < _text.size(); window += SPLIT_WINDOW)
+        {
+            positions.clear();
+            findDelimiters(_text.substr(window, SPLIT_WINDOW), positions, _isa);
+            for(const uint32_t offset : positions)
+            {
+                const size_t position = window + offset;
+                if(position > begin)
+                    _commands.push_back(_text.substr(begin, position - begin));
+                begin = position + 1;
+            }
+        }
+        if(begin < _text.size())
+            _commands.push_back(_text.substr(begin));
+        return begin;
+    }
+}
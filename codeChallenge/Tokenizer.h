@@ -0,0 +1,108 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace object
+{
+
+    /**
+     * Command splitter for large data sets
+     * @brief   commands are separated by "|", new lines or carriage returns. delimiters are located 64 bytes at a
+     *          time with SSE2 or AVX2 compares folded into a bit mask, then each set bit is one delimiter.
+     *          the instruction set is picked at runtime, non x86 builds and short tails use the scalar loop.
+     *          a Tokenizer instance splits a stream fed in chunks, carrying commands cut by a chunk boundary
+    */
+    class Tokenizer
+    {
+        /// command cut by the end of the previous chunk
+        std::string m_pending;
+        /// delimiter offsets of the current chunk, reused between chunks
+        std::vector<uint32_t> m_positions;
+
+    public:
+        /// instruction sets the scanner can use
+        enum class ISA : uint8_t
+        {
+            SCALAR  = 0,
+            SSE2    = 1,
+            AVX2    = 2
+        };
+
+        /**
+         * @brief best instruction set supported by this cpu
+        */
+        static ISA bestIsa();
+
+        /**
+         * @brief check for a command separator
+        */
+        static bool isDelimiter(const char _c)
+        {
+            return _c == '|' || _c == '\n' || _c == '\r';
+        }
+
+        /**
+         * @brief locate every delimiter
+         * @param _text bytes to scan, under 4 GB so offsets fit in 32 bits
+         * @param _positions receives the offset of each delimiter, appended in order
+         * @param _isa instruction set to use, falls back to the best supported one
+        */
+        static void findDelimiters(std::string_view _text, std::vector<uint32_t>& _positions, ISA _isa = bestIsa());
+
+        /**
+         * @brief split text into commands, empty commands are skipped
+         * @param _text bytes to split, views point into it. any size, it is scanned in 1 GB windows
+         * @param _commands receives one view per command, appended in order
+         * @param _isa instruction set to use, falls back to the best supported one
+         * @return offset of the text after the last delimiter, it is also emitted as the last command
+        */
+        static size_t split(std::string_view _text, std::vector<std::string_view>& _commands, ISA _isa = bestIsa());
+
+        /**
+         * @brief split the next chunk of a stream, chunks must be under 4 GB
+         * @param _chunk bytes following the previous chunk
+         * @param _onCommand called with each complete, non empty command, the view is only valid during the call
+        */
+        template <typename F>
+        void feed(std::string_view _chunk, F&& _onCommand)
+        {
+            m_positions.clear();
+            findDelimiters(_chunk, m_positions);
+            size_t begin = 0;
+            for(const uint32_t position : m_positions)
+            {
+                if(m_pending.empty())
+                {
+                    if(position > begin)
+                        _onCommand(_chunk.substr(begin, position - begin));
+                }
+                else
+                {
+                    m_pending.append(_chunk.data() + begin, position - begin);
+                    _onCommand(std::string_view(m_pending));
+                    m_pending.clear();
+                }
+                begin = position + 1;
+            }
+            m_pending.append(_chunk.data() + begin, _chunk.size() - begin);
+        }
+
+        /**
+         * @brief emit the command left after the last delimiter of the stream
+         * @param _onCommand called once if a command is pending
+        */
+        template <typename F>
+        void finish(F&& _onCommand)
+        {
+            if(!m_pending.empty())
+                _onCommand(std::string_view(m_pending));
+            m_pending.clear();
+        }
+    };
+}
+
+#endif  // TOKENIZER_H
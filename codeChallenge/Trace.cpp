@@ -0,0 +1,188 @@
+#include "Trace.h"
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <stdio.h>
+
+namespace object
+{
+    namespace
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        /// shared state, only touched when a thread registers or on start, stop and write
+        struct TraceState
+        {
+            std::mutex m_mutex;
+            std::vector<std::unique_ptr<Tracer::ThreadBuffer>> m_buffers;
+            std::string m_path;
+            std::atomic<size_t> m_eventsPerThread{1 << 20};
+            Clock::time_point m_epoch = Clock::now();
+            bool m_isExitHookSet = false;
+        };
+
+        TraceState& _state()
+        {
+            static TraceState* state = new TraceState();
+            // never destroyed so the exit hook and late threads can still use it
+            return *state;
+        }
+
+        /**
+         * @brief write a string as a JSON string literal
+        */
+        void _writeJsonString(std::ofstream& _file, const std::string& _text)
+        {
+            _file << '"';
+            for(const char c : _text)
+            {
+                if(c == '"' || c == '\\')
+                    _file << '\\';
+                if((unsigned char)c >= 0x20)
+                    _file << c;
+            }
+            _file << '"';
+        }
+    }
+
+    void Tracer::start(const std::string& _path, const uint32_t _sampleEvery, const size_t _eventsPerThread)
+    {
+        TraceState& state = _state();
+        std::lock_guard<std::mutex> lock(state.m_mutex);
+        state.m_path = _path;
+        s_sampleEvery.store(_sampleEvery == 0 ? 1 : _sampleEvery, std::memory_order_relaxed);
+        state.m_eventsPerThread.store(_eventsPerThread, std::memory_order_relaxed);
+        if(!state.m_isExitHookSet)
+        {
+            state.m_isExitHookSet = true;
+            std::atexit([](){ if(isEnabled()) stop(); });
+        }
+        s_isEnabled.store(true, std::memory_order_release);
+    }
+
+    void Tracer::startFromEnvironment()
+    {
+        const char* path = getenv("TOYROBOT_TRACE");
+        if(path == nullptr || path[0] == '\0')
+            return;
+        const char* sample = getenv("TOYROBOT_TRACE_SAMPLE");
+        const char* events = getenv("TOYROBOT_TRACE_EVENTS");
+        start(path, sample ? uint32_t(strtoul(sample, nullptr, 10)) : 1,
+            events ? size_t(strtoull(events, nullptr, 10)) : size_t(1) << 20);
+    }
+
+    bool Tracer::stop()
+    {
+        s_isEnabled.store(false, std::memory_order_release);
+        std::string path;
+        {
+            TraceState& state = _state();
+            std::lock_guard<std::mutex> lock(state.m_mutex);
+            path = state.m_path;
+        }
+        return path.empty() || write(path);
+    }
+
+    bool Tracer::write(const std::string& _path)
+    {
+        TraceState& state = _state();
+        std::lock_guard<std::mutex> lock(state.m_mutex);
+        std::ofstream file(_path);
+        if(!file)
+        {
+            printf("TRACE: could not write %s\n", _path.c_str());
+            return false;
+        }
+        uint64_t recorded = 0;
+        uint64_t dropped = 0;
+        file << "{\"traceEvents\":[\n";
+        bool isFirst = true;
+        char line[128];
+        for(const auto& buffer : state.m_buffers)
+        {
+            // thread name metadata
+            file << (isFirst ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->m_threadId
+                << ",\"args\":{\"name\":";
+            _writeJsonString(file, buffer->m_name.empty() ? "thread " + std::to_string(buffer->m_threadId) : buffer->m_name);
+            file << "}}";
+            isFirst = false;
+            const size_t size = buffer->m_size.load(std::memory_order_acquire);
+            for(size_t i = 0; i < size; ++i)
+            {
+                const Event& event = buffer->m_events[i];
+                // timestamps are in microseconds, keep nanosecond precision
+                snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"cat\":\"toyrobot\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    event.m_name, buffer->m_threadId, double(event.m_startNs) / 1000.0, double(event.m_durationNs) / 1000.0);
+                file << line;
+            }
+            recorded += size;
+            dropped += buffer->m_dropped.load(std::memory_order_relaxed);
+        }
+        file << "\n],\n\"displayTimeUnit\":\"ns\",\n\"otherData\":{\"sampleEvery\":" << s_sampleEvery.load()
+            << ",\"recorded\":" << recorded << ",\"dropped\":" << dropped << "}}\n";
+        printf("TRACE: %lu spans written to %s, %lu dropped\n", (unsigned long)recorded, _path.c_str(), (unsigned long)dropped);
+        return bool(file);
+    }
+
+    void Tracer::clear()
+    {
+        TraceState& state = _state();
+        std::lock_guard<std::mutex> lock(state.m_mutex);
+        for(const auto& buffer : state.m_buffers)
+        {
+            // take on the size given to the last start()
+            buffer->m_events.resize(state.m_eventsPerThread.load(std::memory_order_relaxed));
+            buffer->m_size.store(0, std::memory_order_relaxed);
+            buffer->m_dropped.store(0, std::memory_order_relaxed);
+            buffer->m_countdown = 0;
+            buffer->m_isSampled = false;
+        }
+        state.m_epoch = Clock::now();
+    }
+
+    void Tracer::setThreadName(const std::string& _name)
+    {
+        if(!isEnabled())
+            return;
+        ThreadBuffer& buffer = threadBuffer();
+        std::lock_guard<std::mutex> lock(_state().m_mutex);
+        buffer.m_name = _name;
+    }
+
+    uint64_t Tracer::recordedCount()
+    {
+        TraceState& state = _state();
+        std::lock_guard<std::mutex> lock(state.m_mutex);
+        uint64_t count = 0;
+        for(const auto& buffer : state.m_buffers)
+            count += buffer->m_size.load(std::memory_order_acquire);
+        return count;
+    }
+
+    uint64_t Tracer::droppedCount()
+    {
+        TraceState& state = _state();
+        std::lock_guard<std::mutex> lock(state.m_mutex);
+        uint64_t count = 0;
+        for(const auto& buffer : state.m_buffers)
+            count += buffer->m_dropped.load(std::memory_order_relaxed);
+        return count;
+    }
+
+    Tracer::ThreadBuffer& Tracer::_createThreadBuffer()
+    {
+        // first span of this thread, the buffer outlives the thread so write() can still read it
+        TraceState& state = _state();
+        std::lock_guard<std::mutex> lock(state.m_mutex);
+        state.m_buffers.push_back(std::make_unique<ThreadBuffer>());
+        t_buffer = state.m_buffers.back().get();
+        t_buffer->m_threadId = uint32_t(state.m_buffers.size());
+        t_buffer->m_events.resize(state.m_eventsPerThread.load(std::memory_order_relaxed));
+        return *t_buffer;
+    }
+
+    uint64_t Tracer::now()
+    {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - _state().m_epoch).count());
+    }
+}
@@ -0,0 +1,200 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace object
+{
+
+    /**
+     * Optional timeline tracing
+     * @brief   spans are recorded into one fixed size buffer per thread, so recording never takes a lock or
+     *          allocates. a full buffer drops further spans and counts them. per command spans are sampled,
+     *          only every m_sampleEvery-th command of a thread is recorded together with its nested spans.
+     *          the buffers are written as Chrome trace event JSON, which chrome://tracing and Perfetto open.
+     *          when tracing is off a span costs one relaxed atomic load
+    */
+    class Tracer
+    {
+    public:
+        /// one complete span
+        struct Event
+        {
+            const char* m_name;
+            uint64_t m_startNs;
+            uint64_t m_durationNs;
+        };
+
+        /// events of one thread, only that thread writes m_events and m_size
+        struct ThreadBuffer
+        {
+            uint32_t m_threadId = 0;
+            std::string m_name;
+            std::vector<Event> m_events;
+            std::atomic<size_t> m_size{0};
+            std::atomic<uint64_t> m_dropped{0};
+            /// commands left until the next sampled one
+            uint32_t m_countdown = 0;
+            /// the current command is sampled, nested spans are recorded
+            bool m_isSampled = false;
+        };
+
+        /// set while tracing, checked by every span
+        static inline std::atomic<bool> s_isEnabled{false};
+        /// commands per sampled command
+        static inline std::atomic<uint32_t> s_sampleEvery{1};
+        /// buffer of the calling thread, nullptr until it records its first span
+        static inline thread_local ThreadBuffer* t_buffer = nullptr;
+
+        /**
+         * @brief start recording
+         * @param _path trace file written by stop() or at exit, empty to only write on request
+         * @param _sampleEvery record one command in this many per thread, 1 records all
+         * @param _eventsPerThread buffer size per thread, spans beyond it are dropped
+        */
+        static void start(const std::string& _path, const uint32_t _sampleEvery = 1, const size_t _eventsPerThread = 1 << 20);
+
+        /**
+         * @brief start from TOYROBOT_TRACE (path), TOYROBOT_TRACE_SAMPLE (sample every) and TOYROBOT_TRACE_EVENTS
+         *        (events per thread), does nothing when TOYROBOT_TRACE is unset
+        */
+        static void startFromEnvironment();
+
+        /**
+         * @brief stop recording and write the trace file given to start(), if any
+         * @return false if the file could not be written
+        */
+        static bool stop();
+
+        /**
+         * @brief write every recorded span, safe while other threads still record
+         * @param _path file to write
+         * @return false if the file could not be written
+        */
+        static bool write(const std::string& _path);
+
+        /**
+         * @brief drop every recorded span and resize the buffers, only call while no thread is recording
+        */
+        static void clear();
+
+        /**
+         * @brief name the calling thread in the trace, ignored while tracing is off
+        */
+        static void setThreadName(const std::string& _name);
+
+        /**
+         * @brief amount of recorded and dropped spans over all threads
+        */
+        static uint64_t recordedCount();
+        static uint64_t droppedCount();
+
+        static bool isEnabled() { return s_isEnabled.load(std::memory_order_relaxed); };
+
+        /**
+         * @brief buffer of the calling thread, created on first use
+        */
+        static ThreadBuffer& threadBuffer() { return t_buffer != nullptr ? *t_buffer : _createThreadBuffer(); };
+
+        /**
+         * @brief nanoseconds since tracing started
+        */
+        static uint64_t now();
+
+        /**
+         * @brief decide if the next command of the calling thread is sampled
+        */
+        static bool sampleCommand(ThreadBuffer& _buffer)
+        {
+            _buffer.m_isSampled = _buffer.m_countdown == 0;
+            if(_buffer.m_isSampled)
+                _buffer.m_countdown = s_sampleEvery.load(std::memory_order_relaxed);
+            --_buffer.m_countdown;
+            return _buffer.m_isSampled;
+        }
+
+        /**
+         * @brief check for room in a buffer, counting a dropped span when there is none
+        */
+        static bool hasRoom(ThreadBuffer& _buffer)
+        {
+            if(_buffer.m_size.load(std::memory_order_relaxed) < _buffer.m_events.size())
+                return true;
+            _buffer.m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        /**
+         * @brief append a finished span, dropped if the buffer is full
+        */
+        static void record(ThreadBuffer& _buffer, const char* _name, const uint64_t _startNs, const uint64_t _endNs)
+        {
+            const size_t size = _buffer.m_size.load(std::memory_order_relaxed);
+            // nested spans may have filled the buffer since this span started
+            if(size >= _buffer.m_events.size())
+            {
+                _buffer.m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            _buffer.m_events[size] = Event{ _name, _startNs, _endNs - _startNs };
+            // publish the event to a concurrent write()
+            _buffer.m_size.store(size + 1, std::memory_order_release);
+        }
+
+    private:
+        static ThreadBuffer& _createThreadBuffer();
+    };
+
+    /**
+     * Scoped span
+     * @brief   ALWAYS spans are recorded whenever tracing is on and suit coarse work like reading a chunk.
+     *          COMMAND spans wrap one command and decide if it is sampled, NESTED spans inside a command are
+     *          only recorded when that command was sampled
+    */
+    class TraceSpan
+    {
+    public:
+        enum class MODE : uint8_t
+        {
+            ALWAYS  = 0,
+            COMMAND = 1,
+            NESTED  = 2
+        };
+
+        TraceSpan(const char* _name, const MODE _mode = MODE::ALWAYS)
+        {
+            if(!Tracer::isEnabled())
+                return;
+            Tracer::ThreadBuffer& buffer = Tracer::threadBuffer();
+            if(_mode == MODE::COMMAND && !Tracer::sampleCommand(buffer))
+                return;
+            if(_mode == MODE::NESTED && !buffer.m_isSampled)
+                return;
+            // skip the clock reads once the buffer is full
+            if(!Tracer::hasRoom(buffer))
+                return;
+            m_buffer = &buffer;
+            m_name = _name;
+            m_startNs = Tracer::now();
+        }
+        TraceSpan(const TraceSpan&) = delete;
+        void operator=(const TraceSpan&) = delete;
+        ~TraceSpan()
+        {
+            if(m_buffer != nullptr)
+                Tracer::record(*m_buffer, m_name, m_startNs, Tracer::now());
+        }
+
+    private:
+        Tracer::ThreadBuffer* m_buffer = nullptr;
+        const char* m_name = nullptr;
+        uint64_t m_startNs = 0;
+    };
+}
+
+#endif  // TRACE_H
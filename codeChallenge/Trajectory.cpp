@@ -0,0 +1,147 @@
+#include "Trajectory.h"
+
+namespace object
+{
+    namespace
+    {
+        static_assert(TABLE_TOP_X <= 7 && TABLE_TOP_Y <= 7, "ABSOLUTE payloads pack each axis of the table in 3 bits");
+
+        /**
+         * @brief pack a transform into the 8 bit ABSOLUTE payload, x and y take 3 bits each
+        */
+        uint64_t _packState(const TrajectoryRecorder::Transform& _state)
+        {
+            const auto position = _state.getPosition();
+            return uint64_t(position.x) | (uint64_t(position.y) << 3) | (uint64_t(_state.getRotation() & 0b11) << 6);
+        }
+
+        TrajectoryRecorder::Transform _unpackState(const uint64_t _bits)
+        {
+            TrajectoryRecorder::Transform state;
+            state.setPosition(type::T_Position<uint8_t>(uint8_t(_bits & 0b111), uint8_t((_bits >> 3) & 0b111)));
+            state.setRotation(type::HEADING((_bits >> 6) & 0b11));
+            return state;
+        }
+
+        /**
+         * @brief state one cell along the heading, unsigned wrap is fine as the result is only compared
+        */
+        TrajectoryRecorder::Transform _forward(TrajectoryRecorder::Transform _state)
+        {
+            auto position = _state.getPosition();
+            switch (_state.getRotation())
+            {
+            case type::HEADING::NORTH:  position.y = position.y + 1; break;
+            case type::HEADING::EAST:   position.x = position.x + 1; break;
+            case type::HEADING::SOUTH:  position.y = position.y - 1; break;
+            default:                    position.x = position.x - 1; break;
+            }
+            _state.setPosition(position);
+            return _state;
+        }
+
+        TrajectoryRecorder::Transform _turn(TrajectoryRecorder::Transform _state, const uint32_t _quarters)
+        {
+            _state.setRotation(type::HEADING((_state.getRotation() + _quarters) & 0b11));
+            return _state;
+        }
+
+        bool _isSame(const TrajectoryRecorder::Transform& _a, const TrajectoryRecorder::Transform& _b)
+        {
+            return _packState(_a) == _packState(_b);
+        }
+    }
+
+    void TrajectoryRecorder::_push(const uint64_t _value, const uint32_t _count)
+    {
+        const uint64_t word = m_bitCount >> 6;
+        const uint32_t shift = uint32_t(m_bitCount & 63);
+        if(word == m_bits.size())
+            m_bits.push_back(0);
+        m_bits[word] |= _value << shift;
+        // spill into the next word
+        if(shift + _count > 64)
+            m_bits.push_back(_value >> (64 - shift));
+        m_bitCount += _count;
+    }
+
+    uint64_t TrajectoryRecorder::_read(const uint64_t _offset, const uint32_t _count) const
+    {
+        const uint64_t word = _offset >> 6;
+        const uint32_t shift = uint32_t(_offset & 63);
+        uint64_t value = m_bits[word] >> shift;
+        if(shift + _count > 64)
+            value |= m_bits[word + 1] << (64 - shift);
+        return value & ((uint64_t(1) << _count) - 1);
+    }
+
+    uint64_t TrajectoryRecorder::_decode(uint64_t _offset, Transform& _state) const
+    {
+        const uint64_t code = _read(_offset, 2);
+        _offset += 2;
+        switch (code)
+        {
+        case CODE::FORWARD: _state = _forward(_state); return _offset;
+        case CODE::LEFT:    _state = _turn(_state, 3); return _offset;
+        case CODE::RIGHT:   _state = _turn(_state, 1); return _offset;
+        default:            break;
+        }
+        const uint64_t kind = _read(_offset, 2);
+        _offset += 2;
+        if(kind == ESCAPE_KIND::ABSOLUTE)
+        {
+            _state = _unpackState(_read(_offset, 8));
+            _offset += 8;
+        }
+        return _offset;
+    }
+
+    void TrajectoryRecorder::onAction(const type::ACTION, const bool, const Transform& _transform, const bool)
+    {
+        if(m_steps % m_keyframeInterval == 0)
+            m_keyframes.push_back(Keyframe{ m_bitCount, m_state });
+        ++m_steps;
+        // codes follow from the change of state, so UNDO and REDO need no special case
+        if(m_hasState)
+        {
+            if(_isSame(_transform, m_state))
+            {
+                _push(CODE::ESCAPE | (ESCAPE_KIND::STAY << 2), 4);
+                return;
+            }
+            const CODE code = _isSame(_transform, _forward(m_state)) ? CODE::FORWARD
+                : _isSame(_transform, _turn(m_state, 3)) ? CODE::LEFT
+                : _isSame(_transform, _turn(m_state, 1)) ? CODE::RIGHT
+                : CODE::ESCAPE;
+            if(code != CODE::ESCAPE)
+            {
+                _push(code, 2);
+                m_state = _transform;
+                return;
+            }
+        }
+        _push(CODE::ESCAPE | (ESCAPE_KIND::ABSOLUTE << 2) | (_packState(_transform) << 4), 12);
+        m_state = _transform;
+        m_hasState = true;
+    }
+
+    TrajectoryRecorder::Transform TrajectoryRecorder::stateAt(const uint64_t _step) const
+    {
+        const Keyframe& keyframe = m_keyframes[_step / m_keyframeInterval];
+        Transform state = keyframe.m_state;
+        uint64_t offset = keyframe.m_bitOffset;
+        for(uint64_t step = _step - _step % m_keyframeInterval; step <= _step; ++step)
+            offset = _decode(offset, state);
+        return state;
+    }
+
+    void TrajectoryRecorder::clear()
+    {
+        m_bits.clear();
+        m_bitCount = 0;
+        m_steps = 0;
+        m_keyframes.clear();
+        m_state = Transform();
+        m_hasState = false;
+    }
+}
@@ -0,0 +1,119 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include "Objects.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace object
+{
+
+    /**
+     * Compact record of every state a robot passes through
+     * @brief   each command the robot reports is one step, stored as a 2 bit code against the previous state:
+     *          FORWARD (one cell along the heading, which is one of the four MOVE deltas), LEFT, RIGHT or
+     *          ESCAPE. an escape is followed by a 2 bit kind, STAY for rejected commands and REPORT, or ABSOLUTE
+     *          followed by the full 8 bit transform for PLACE, UNDO, REDO and the first step.
+     *          every m_keyframeInterval steps the state and bit offset are stored so any step decodes
+     *          from the nearest keyframe instead of from the start
+    */
+    class TrajectoryRecorder : public TransformListener
+    {
+    public:
+        typedef type::T_Transform<uint8_t> Transform;
+
+        /// 2 bit step codes
+        enum CODE : uint8_t
+        {
+            FORWARD = 0,
+            LEFT    = 1,
+            RIGHT   = 2,
+            ESCAPE  = 3
+        };
+
+        /// 2 bit kinds following an ESCAPE
+        enum ESCAPE_KIND : uint8_t
+        {
+            STAY     = 0,
+            ABSOLUTE = 1
+        };
+
+        /// steps between keyframes used by default
+        static constexpr uint32_t DEFAULT_KEYFRAME_INTERVAL = 256;
+
+    private:
+        /**
+         * decoder entry point, state before the step at m_step * interval
+        */
+        struct Keyframe
+        {
+            uint64_t m_bitOffset;
+            Transform m_state;
+        };
+
+        const uint32_t m_keyframeInterval;
+        /// packed codes, least significant bits first
+        std::vector<uint64_t> m_bits;
+        uint64_t m_bitCount = 0;
+        uint64_t m_steps = 0;
+        std::vector<Keyframe> m_keyframes;
+        /// state after the last step
+        Transform m_state;
+        /// false until the first step, which is always ABSOLUTE
+        bool m_hasState = false;
+
+        /**
+         * @brief append the low _count bits of _value
+        */
+        void _push(const uint64_t _value, const uint32_t _count);
+
+        /**
+         * @brief read _count bits at _offset
+        */
+        uint64_t _read(const uint64_t _offset, const uint32_t _count) const;
+
+        /**
+         * @brief apply the step at _offset to _state
+         * @return offset of the next step
+        */
+        uint64_t _decode(uint64_t _offset, Transform& _state) const;
+
+    public:
+        /**
+         * @param _keyframeInterval steps between keyframes, trades size against random access speed
+        */
+        explicit TrajectoryRecorder(const uint32_t _keyframeInterval = DEFAULT_KEYFRAME_INTERVAL)
+            :   m_keyframeInterval(_keyframeInterval == 0 ? 1 : _keyframeInterval)
+        {};
+
+        /**
+         * @brief record the state after a processed command as the next step
+        */
+        virtual void onAction(const type::ACTION _action, const bool _accepted, const Transform& _transform, const bool _isPlaced) override;
+
+        /**
+         * @brief rebuild the state after a step
+         * @param _step step to decode, below size()
+         * @return transform of the robot after the step
+        */
+        Transform stateAt(const uint64_t _step) const;
+
+        /**
+         * @brief amount of recorded steps
+        */
+        uint64_t size() const { return m_steps; };
+
+        /**
+         * @brief memory held by codes and keyframes, excluding unused capacity
+        */
+        size_t byteSize() const { return size_t((m_bitCount + 7) / 8) + m_keyframes.size() * sizeof(Keyframe); };
+
+        /**
+         * @brief drop every step
+        */
+        void clear();
+    };
+}
+
+#endif  // TRAJECTORY_H
@@ -7,6 +7,8 @@
 #include <climits>
 #include <limits>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 namespace type
 {
@@ -19,7 +21,11 @@ namespace type
         LEFT    = 0b001, /// 1
         RIGHT   = 0b010, /// 2
         PLACE   = 0b011, /// 3
-        REPORT  = 0b100  /// 4
+        REPORT  = 0b100, /// 4
+        UNDO    = 0b101, /// 5
+        REDO    = 0b110, /// 6
+        DEFINE  = 0b111, /// 7
+        CALL    = 0b1000 /// 8
     };
     const std::map<std::string, ACTION> actionEnumMap =
     {
@@ -27,7 +33,11 @@ namespace type
         { "LEFT", ACTION::LEFT },
         { "RIGHT", ACTION::RIGHT },
         { "PLACE", ACTION::PLACE },
-        { "REPORT", ACTION::REPORT }
+        { "REPORT", ACTION::REPORT },
+        { "UNDO", ACTION::UNDO },
+        { "REDO", ACTION::REDO },
+        { "DEFINE", ACTION::DEFINE },
+        { "CALL", ACTION::CALL }
     };
 
     /**
@@ -54,23 +64,34 @@ namespace type
      * @param _heading string to convert
      * @return HEADING converion for string
     */
-    inline HEADING getHeadingEnum(const std::string& _heading)
+    inline HEADING getHeadingEnum(std::string_view _heading)
     {
-        const std::map<std::string, HEADING> enumToStr =
-        {
-            { "NORTH", HEADING::NORTH },
-            { "EAST", HEADING::EAST,    },
-            { "SOUTH", HEADING::SOUTH },
-            { "WEST", HEADING::WEST  },
-            { "UNDEFINED", HEADING::UNDEFINED  }
-        };
         // get enum if it exists
-        auto itr = enumToStr.find(_heading);
-        if(itr != enumToStr.cend())
-            return itr->second;
+        for(const auto& heading : headingMap)
+        {
+            if(_heading == heading.second)
+                return heading.first;
+        }
         // return undefined if querry fails
         return HEADING::UNDEFINED;
     }
+    inline HEADING getHeadingEnum(const std::string& _heading)
+    {
+        return getHeadingEnum(std::string_view(_heading));
+    }
+
+    /**
+     * Pre-parsed command
+     * @brief the result of parsing one command string, so it can be executed without touching text again.
+     *        x, y and heading are only used by PLACE
+    */
+    struct Command
+    {
+        ACTION action = ACTION::REPORT;
+        uint32_t x = 0;
+        uint32_t y = 0;
+        HEADING heading = HEADING::UNDEFINED;
+    };
 
     /**
      * make bit size check precompile
@@ -83,6 +104,30 @@ namespace type
         return sizeof(T) * CHAR_BIT;
     }
 
+    /**
+     * @brief largest value a T_Position<T> or T_Transform<T> axis can hold
+    */
+    template <typename T>
+    constexpr uint64_t
+    axisLimit() noexcept
+    {
+        return (uint64_t(1) << ((type::bit_size<T>()/2)-1)) - 1;
+    }
+
+    /**
+     * Smallest transform type for a table
+     * @brief picks the narrowest unsigned type whose axis bits hold _extent at compile time
+     * @param _extent largest axis value, inclusive like TABLE_TOP_X
+    */
+    template <uint64_t _extent>
+    struct T_SmallestTransform
+    {
+        typedef typename std::conditional<_extent <= axisLimit<uint8_t>(), uint8_t,
+            typename std::conditional<_extent <= axisLimit<uint16_t>(), uint16_t,
+            typename std::conditional<_extent <= axisLimit<uint32_t>(), uint32_t, uint64_t>::type>::type>::type type;
+        static_assert(_extent <= axisLimit<uint64_t>(), "table extent does not fit any transform type");
+    };
+
     /**
      * Data structure for position
      * @brief   this struct has been templated to future proof table top extents size changes.
@@ -151,7 +196,7 @@ namespace type
          * @brief access position 
          * @return T_Position<T> position
         */
-        const T_Position<T> getPosition()
+        const T_Position<T> getPosition() const
         {
             // return Position struct
             // isolate X and Y data with masks
@@ -165,7 +210,7 @@ namespace type
          * @brief access rotation 
          * @return HEADING rotation
         */
-        type::HEADING getRotation()
+        type::HEADING getRotation() const
         {
             // isolate roation by combining a clear with X and Y mask and shifting to the right
             return type::HEADING((data & ~(MASK::AXIS_Y | MASK::AXIS_X)) >> (type::bit_size<T>()-2));
@@ -2,11 +2,37 @@
 #define UNIT_TESTS_H
 
 #include "Objects.h"
-
+#include "SpatialIndex.h"
+#include "Analytics.h"
+#include "Parallel.h"
+#include "Evaluator.h"
+#include "Pipeline.h"
+#include "Tokenizer.h"
+#include "StaticRobot.h"
+#include "Script.h"
+#include "TickEngine.h"
+#include "PerfCheck.h"
+#include "RobotPool.h"
+#include "Trajectory.h"
+#include "Shard.h"
+#include "ResultCache.h"
+#include "Router.h"
+#include "Engine.h"
+#include "EditableScript.h"
+#include "Geofence.h"
+
+#include <algorithm>
 #include <chrono>
+#include <random>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <glob.h>
+#include <unistd.h>
 #include <assert.h>
 #include <iostream>
 #include <fstream>
@@ -63,6 +89,97 @@ class UnitTests
 private:
     /// global tableTop
     const object::TableTop& m_tableTop;
+
+    /**
+     * @brief feed every command of a data set file to a robot
+     * @param _path data set file, commands separated by "|" or new lines
+     * @param _robot robot to run the commands on
+     * @param _echo print each command before running it
+     * @return amount of commands found in the file
+    */
+    static uint64_t _replayFile(const std::string& _path, object::ToyRobot& _robot, const bool _echo)
+    {
+        return _replayFile(_path, _echo, [&](std::string_view _command){ _robot.proccessInput(std::string(_command)); });
+    }
+
+    /**
+     * @brief feed every command of a data set file to an engine
+    */
+    static uint64_t _replayFile(const std::string& _path, object::Engine& _engine, const bool _echo)
+    {
+        return _replayFile(_path, _echo, [&](std::string_view _command){ _engine.run(_command); });
+    }
+
+    /**
+     * @brief feed every command of a data set file to _run
+    */
+    template <typename F>
+    static uint64_t _replayFile(const std::string& _path, const bool _echo, F&& _run)
+    {
+        std::ifstream file(_path, std::ios::binary);
+        std::string chunk(1 << 20, '\0');
+        object::Tokenizer tokenizer;
+        uint64_t commands = 0;
+        // process data set per command/action
+        auto runCommand = [&](std::string_view _command)
+        {
+            if(_echo)
+                printf("%.*s\n", int(_command.size()), _command.data());
+            _run(_command);
+            ++commands;
+        };
+        while(true)
+        {
+            {
+                object::TraceSpan span("read");
+                if(!file.read(&chunk[0], std::streamsize(chunk.size())) && file.gcount() == 0)
+                    break;
+            }
+            tokenizer.feed(std::string_view(chunk.data(), size_t(file.gcount())), runCommand);
+        }
+        tokenizer.finish(runCommand);
+        return commands;
+    }
+
+    /**
+     * @brief expand a directory or glob pattern into data set files
+     * @param _pattern directory, glob pattern or single file
+     * @return sorted list of regular files
+    */
+    static std::vector<std::string> _listDataSets(const std::string& _pattern)
+    {
+        std::vector<std::string> paths;
+        std::error_code error;
+        if(std::filesystem::is_directory(_pattern, error))
+        {
+            for(const auto& entry : std::filesystem::directory_iterator(_pattern, error))
+                if(entry.is_regular_file(error))
+                    paths.push_back(entry.path().string());
+        }
+        else
+        {
+            glob_t matches;
+            if(glob(_pattern.c_str(), 0, nullptr, &matches) == 0)
+            {
+                for(size_t i = 0; i < matches.gl_pathc; ++i)
+                    if(std::filesystem::is_regular_file(matches.gl_pathv[i], error))
+                        paths.push_back(matches.gl_pathv[i]);
+            }
+            globfree(&matches);
+        }
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+
+    /**
+     * @brief path in the temp directory unique to this process, so concurrent test runs do not collide
+     * @param _name file or directory name
+     * @param _extension appended after the process id
+    */
+    static std::filesystem::path _tempPath(const std::string& _name, const std::string& _extension = "")
+    {
+        return std::filesystem::temp_directory_path() / (_name + "." + std::to_string(getpid()) + _extension);
+    }
 public:
 
     UnitTests(const object::TableTop& _tableTop)
@@ -72,24 +189,166 @@ public:
     /**
      * @brief run an external data set .txt file
      * @param _path a path to find .txt file
+     * @param _obstaclePath optional path to an obstacle file loaded before the data set
+     * @param _engine optional engine running the commands on the player, proccessInput is used when nullptr
     */
-    void runDataSetTests(std::string _path = "./testData.txt")
+    void runDataSetTests(std::string _path = "./testData.txt", std::string _obstaclePath = "", object::Engine* _engine = nullptr)
     {
+        // load static obstacles if requested
+        if(!_obstaclePath.empty())
+        {
+            const long loaded = m_tableTop.getObstacles().loadFromFile(_obstaclePath);
+            printf("\nTEST:  loaded %ld obstacles from file:%s\n", loaded, _obstaclePath.c_str());
+        }
         // attempot to get file from _path
-        std::ifstream file(_path);
-        std::string data = "";
-        std::string str; 
-        // process data set per command/action
         printf("\nTEST:  processing data-set from file:%s\n",_path.c_str());
-        while(getline(file, data,'|'))
+        if(_engine != nullptr)
+            _replayFile(_path, *_engine, true);
+        else
+            _replayFile(_path, m_tableTop.getPlayer(), true);
+        printf("TEST: data-set from file:%s COMPLETE\n",_path.c_str());
+        if(const object::ShadowEngine* shadow = dynamic_cast<const object::ShadowEngine*>(_engine))
+            shadow->getStats().print(shadow->getName());
+    }
+
+    /**
+     * @brief replay data set files and accumulate a visit/dwell heatmap
+     * @brief each worker thread owns its own heatmap and robot so replays never contend,
+     *        heatmaps are merged once every file has been processed
+     * @param _paths data set .txt files to replay
+     * @param _outputPath heatmap output, written as a binary matrix when it ends in ".bin" and csv otherwise
+    */
+    void runDataSetAnalytics(const std::vector<std::string>& _paths, const std::string& _outputPath)
+    {
+        const unsigned workerCount = unsigned(std::max<size_t>(1, std::min<size_t>(_paths.size(), object::defaultThreadCount())));
+        std::vector<std::unique_ptr<object::Heatmap>> heatmaps;
+        for(unsigned i = 0; i < workerCount; ++i)
+            heatmaps.push_back(std::make_unique<object::Heatmap>(m_tableTop.getExtentX(), m_tableTop.getExtentY()));
+        std::atomic<uint64_t> commandCount(0);
+
+        printf("\nTEST:  analysing %lu data-set files on %u threads\n", (unsigned long)_paths.size(), workerCount);
+        const auto start(std::chrono::steady_clock::now());
+        object::parallelFor(_paths.size(), workerCount, [&](const size_t _index, const unsigned _worker)
         {
-            printf("%s\n",data.c_str());
-            object::ToyRobot& robot = m_tableTop.getPlayer();
-            robot.proccessInput(data);
+            // fresh robot per file, reports are not needed for analytics
+            object::ToyRobot robot;
+            robot.setObstacleMap(&m_tableTop.getObstacles());
+            robot.setReportCallback([](const std::string&){});
+            robot.addListener(heatmaps[_worker].get());
+            const uint64_t commands = _replayFile(_paths[_index], robot, false);
+            commandCount += commands;
+        });
+        // merge per thread counters
+        for(unsigned i = 1; i < workerCount; ++i)
+            heatmaps[0]->merge(*heatmaps[i]);
+        const auto end(std::chrono::steady_clock::now());
+        const double seconds = std::chrono::duration<double>(end - start).count();
+
+        const bool isBinary = _outputPath.size() > 4 && _outputPath.compare(_outputPath.size() - 4, 4, ".bin") == 0;
+        const bool hasWritten = isBinary ? heatmaps[0]->writeBinary(_outputPath) : heatmaps[0]->writeCsv(_outputPath);
+        printf("TEST:  %lu commands in %.3f s (%.0f commands/s), heatmap %s %s\n",
+            (unsigned long)commandCount.load(), seconds, seconds > 0 ? double(commandCount.load()) / seconds : 0.0,
+            hasWritten ? "written to" : "could not be written to", _outputPath.c_str());
+    }
+
+    /**
+     * @brief replay every data set in a directory or glob on a thread pool
+     * @brief every file runs on its own robot. REPORT output is buffered per file and printed in path order
+     *        as soon as all earlier files are done, so output does not depend on scheduling
+     * @brief with a cache, files whose bytes were replayed before from the same state on the same table
+     *        print the stored output instead of running
+     * @param _pattern directory or glob pattern of data set files
+     * @param _threadCount amount of worker threads, 0 for all cores
+     * @param _cache optional result cache
+     * @param _output stream the per file output and summary are printed to
+    */
+    void runDataSetDirectory(const std::string& _pattern, const unsigned _threadCount = 0, object::ResultCache* _cache = nullptr,
+        FILE* _output = stdout)
+    {
+        struct Result
+        {
+            std::string m_output;
+            uint64_t m_commands = 0;
+            double m_seconds = 0;
+            /// output and command count came from _cache, nothing was replayed
+            bool m_isCached = false;
+            bool m_isDone = false;
+        };
+        const std::vector<std::string> paths = _listDataSets(_pattern);
+        std::vector<Result> results(paths.size());
+        std::mutex outputMutex;
+        size_t nextToPrint = 0;
+
+        fprintf(_output, "\nTEST:  processing %lu data-set files from:%s\n", (unsigned long)paths.size(), _pattern.c_str());
+        const auto start(std::chrono::steady_clock::now());
+        const unsigned workerCount = object::parallelFor(paths.size(), _threadCount, [&](const size_t _index, const unsigned)
+        {
+            Result& result = results[_index];
+            object::ToyRobot robot;
+            robot.setObstacleMap(&m_tableTop.getObstacles());
+            robot.setReportCallback([&](const std::string& _report)
+            {
+                result.m_output.append("Output : ").append(_report).push_back('\n');
+            });
+            const auto fileStart(std::chrono::steady_clock::now());
+            object::ResultCache::Key key;
+            object::ResultCache::Result cached;
+            if(_cache != nullptr)
+            {
+                object::ContentHasher hasher;
+                hasher.updateFromFile(paths[_index]);
+                key = object::ResultCache::makeKey(hasher, robot.snapshot(), m_tableTop.getExtentX(), m_tableTop.getExtentY(),
+                    &m_tableTop.getObstacles());
+            }
+            if(_cache != nullptr && _cache->find(key, cached))
+            {
+                result.m_output = std::move(cached.m_reports);
+                result.m_commands = cached.m_commands;
+                result.m_isCached = true;
+            }
+            else
+            {
+                result.m_commands = _replayFile(paths[_index], robot, false);
+                if(_cache != nullptr)
+                    _cache->store(key, object::ResultCache::Result{ robot.snapshot(), result.m_commands, result.m_output });
+            }
+            result.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - fileStart).count();
+
+            // print every finished file that has no unfinished file before it
+            std::lock_guard<std::mutex> lock(outputMutex);
+            result.m_isDone = true;
+            while(nextToPrint < results.size() && results[nextToPrint].m_isDone)
+            {
+                fprintf(_output, "TEST:  %s\n%s", paths[nextToPrint].c_str(), results[nextToPrint].m_output.c_str());
+                std::string().swap(results[nextToPrint].m_output);
+                ++nextToPrint;
+            }
+        });
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // summary
+        // cached files ran no commands, only replayed ones count towards commands/s
+        uint64_t totalCommands = 0;
+        uint64_t cachedCommands = 0;
+        fprintf(_output, "\nTEST:  summary\n");
+        for(size_t i = 0; i < paths.size(); ++i)
+        {
+            totalCommands += results[i].m_commands;
+            if(results[i].m_isCached)
+            {
+                cachedCommands += results[i].m_commands;
+                fprintf(_output, "TEST:  %-40s %10lu commands       cache hit\n", paths[i].c_str(), (unsigned long)results[i].m_commands);
+                continue;
+            }
+            fprintf(_output, "TEST:  %-40s %10lu commands %12.0f commands/s\n", paths[i].c_str(),
+                (unsigned long)results[i].m_commands, results[i].m_seconds > 0 ? double(results[i].m_commands) / results[i].m_seconds : 0.0);
         }
-        printf("TEST: data-set from file:%s COMPLETE\n",_path.c_str());
-        
-        file.close();
+        const uint64_t replayedCommands = totalCommands - cachedCommands;
+        fprintf(_output, "TEST:  %lu files, %lu commands (%lu from cache) in %.3f s on %u threads, %.0f replayed commands/s\n",
+            (unsigned long)paths.size(), (unsigned long)totalCommands, (unsigned long)cachedCommands, seconds, workerCount,
+            seconds > 0 ? double(replayedCommands) / seconds : 0.0);
+        if(_cache != nullptr)
+            _cache->getStats().print();
     }
 
     /**
@@ -559,6 +818,1611 @@ public:
 
         };
         CREATE_TEST(test_toyRobot_invalid_input)
+
+        /**
+         * TEST: toyRobot PLACE and MOVE into a blocked cell should be rejected
+        */
+        auto test_toyRobot_obstacles = [&](){
+            object::ToyRobot& robot = m_tableTop.getPlayer();
+            object::ObstacleMap& obstacles = m_tableTop.getObstacles();
+            obstacles.addObstacle(2, 2);
+
+            // place robot on the obstacle {2,2,NORTH}
+            // EXPECTATION: transform data does not change
+            robot.placeHere(2, 1, type::HEADING::NORTH);
+            robot.placeHere(2, 2, type::HEADING::NORTH);
+            std::string output = robot.getReport();
+            std::string PARAM_OUTPUT = "2,1,NORTH";
+            ASSERT_EQUALS_STRING(output, PARAM_OUTPUT, true);
+
+            // move robot into the obstacle
+            // EXPECTATION: transform data does not change
+            robot.move();
+            output = robot.getReport();
+            ASSERT_EQUALS_STRING(output, PARAM_OUTPUT, true);
+
+            // move robot around the obstacle
+            // EXPECTATION: robot moves freely next to it
+            robot.rotateRight();
+            robot.move();
+            robot.rotateLeft();
+            robot.move();
+            output = robot.getReport();
+            PARAM_OUTPUT = "3,2,NORTH";
+            ASSERT_EQUALS_STRING(output, PARAM_OUTPUT, true);
+
+            // EXPECTATION: sparse tiles are promoted to bitmaps and lookups stay exact
+            object::ObstacleMap bulk;
+            std::vector<std::pair<uint32_t, uint32_t>> cells;
+            for(uint32_t i = 0; i < 100; ++i)
+                cells.emplace_back(i % 10, i / 10);
+            cells.emplace_back(30000, 30000);
+            bulk.addObstacles(cells);
+            ASSERT_EQUALS_INT(int(bulk.size()), 101, true);
+            ASSERT_EQUALS_INT(int(bulk.denseTileCount()), 1, true);
+            ASSERT_EQUALS_INT(bulk.isBlocked(9, 9), true, true);
+            ASSERT_EQUALS_INT(bulk.isBlocked(10, 9), false, true);
+            ASSERT_EQUALS_INT(bulk.isBlocked(30000, 30000), true, true);
+            ASSERT_EQUALS_INT(bulk.isBlocked(30001, 30000), false, true);
+
+            // EXPECTATION: files keep valid cells and skip comments and malformed cells
+            const std::filesystem::path path = _tempPath("toyRobotObstacles", ".txt");
+            std::ofstream(path) << "# comment\n1,2\n3, 4|5,6\n\n5,\n,\n,7\n4294967295,0\n4294967296,1\n1,2,3\nx,1\n";
+            object::ObstacleMap loaded;
+            const long count = loaded.loadFromFile(path.string());
+            const long missing = loaded.loadFromFile(path.string() + ".missing");
+            std::filesystem::remove(path);
+            ASSERT_EQUALS_INT(int(count), 4, true);
+            ASSERT_EQUALS_INT(int(missing), -1, true);
+            ASSERT_EQUALS_INT(int(loaded.size()), 4, true);
+            ASSERT_EQUALS_INT(int(loaded.isBlocked(3, 4) && loaded.isBlocked(5, 6) && loaded.isBlocked(4294967295u, 0)), 1, true);
+            ASSERT_EQUALS_INT(int(loaded.isBlocked(5, 0) || loaded.isBlocked(0, 0) || loaded.isBlocked(0, 1)), 0, true);
+
+            obstacles.clear();
+        };
+        CREATE_TEST(test_toyRobot_obstacles)
+
+        /**
+         * TEST: spatial index should follow fleet PLACE and MOVE and answer region queries
+        */
+        auto test_fleet_spatial_index = [&](){
+            object::Fleet fleet(1000, 1000);
+            object::SpatialIndex index(1000, 1000, 16);
+            fleet.setSpatialIndex(&index);
+            for(uint32_t i = 0; i < 100; ++i)
+            {
+                const uint32_t robot = fleet.addRobot();
+                fleet.placeHere(robot, (i % 10) * 20, (i / 10) * 20, type::HEADING::EAST);
+            }
+            ASSERT_EQUALS_INT(int(index.size()), 100, true);
+
+            // EXPECTATION: rectangle holds the 2x2 robots at {0..20,0..20}
+            std::vector<uint32_t> found;
+            index.queryRect(0, 0, 20, 20, found);
+            ASSERT_EQUALS_INT(int(found.size()), 4, true);
+
+            // move robot 0 from {0,0} to {10,0}
+            // EXPECTATION: it stays in bucket {0..15} and the nearest robot to {13,0} is robot 0
+            for(int i = 0; i < 10; ++i)
+                fleet.move(0);
+            found.clear();
+            index.nearest(13, 0, 2, found);
+            ASSERT_EQUALS_INT(int(found.size()), 2, true);
+            ASSERT_EQUALS_INT(int(found[0]), 0, true);
+            ASSERT_EQUALS_INT(int(found[1]), 1, true);
+
+            // move robot 0 on to {17,0}
+            // EXPECTATION: it leaves bucket {0..15} and joins robot 1 in bucket {16..31}
+            for(int i = 0; i < 7; ++i)
+                fleet.move(0);
+            found.clear();
+            index.queryRect(0, 0, 15, 15, found);
+            ASSERT_EQUALS_INT(int(found.size()), 0, true);
+            index.queryRect(16, 0, 31, 15, found);
+            std::sort(found.begin(), found.end());
+            ASSERT_EQUALS_INT(int(found == std::vector<uint32_t>{ 0, 1 }), 1, true);
+
+            // EXPECTATION: index matches a linear scan
+            found.clear();
+            index.queryRect(5, 5, 65, 45, found);
+            std::sort(found.begin(), found.end());
+            std::vector<uint32_t> scanned;
+            for(uint32_t robot = 0; robot < fleet.size(); ++robot)
+            {
+                const auto position = fleet.getPosition(robot);
+                if(position.x >= 5 && position.x <= 65 && position.y >= 5 && position.y <= 45)
+                    scanned.push_back(robot);
+            }
+            ASSERT_EQUALS_INT(int(found.size()), int(scanned.size()), true);
+            ASSERT_EQUALS_INT(int(found == scanned), 1, true);
+
+            // EXPECTATION: robots cannot leave the table
+            fleet.placeHere(1, 1000, 1000, type::HEADING::NORTH);
+            ASSERT_EQUALS_INT(fleet.move(1), false, true);
+            std::string output = fleet.getReport(1);
+            std::string PARAM_OUTPUT = "1000,1000,NORTH";
+            ASSERT_EQUALS_STRING(output, PARAM_OUTPUT, true);
+        };
+        CREATE_TEST(test_fleet_spatial_index)
+
+        /**
+         * TEST: heatmap should count visits on MOVE/PLACE and dwell on every accepted command
+        */
+        auto test_toyRobot_heatmap = [&](){
+            object::ToyRobot robot;
+            object::Heatmap heatmap(TABLE_TOP_X, TABLE_TOP_Y);
+            robot.addListener(&heatmap);
+            robot.setReportCallback([](const std::string&){});
+
+            // EXPECTATION: commands before PLACE are not counted
+            robot.proccessInput("MOVE");
+            robot.proccessInput("PLACE 0,0,NORTH");
+            robot.proccessInput("MOVE");
+            robot.proccessInput("RIGHT");
+            robot.proccessInput("REPORT");
+            // rejected move off the table is not counted
+            robot.proccessInput("PLACE 4,4,NORTH");
+            robot.proccessInput("MOVE");
+            ASSERT_EQUALS_INT(int(heatmap.getVisits(0, 0)), 1, true);
+            ASSERT_EQUALS_INT(int(heatmap.getVisits(0, 1)), 1, true);
+            ASSERT_EQUALS_INT(int(heatmap.getVisits(4, 4)), 1, true);
+            ASSERT_EQUALS_INT(int(heatmap.getDwell(0, 1, type::HEADING::NORTH)), 1, true);
+            ASSERT_EQUALS_INT(int(heatmap.getDwell(0, 1, type::HEADING::EAST)), 2, true);
+            ASSERT_EQUALS_INT(int(heatmap.getDwell(4, 4, type::HEADING::NORTH)), 1, true);
+
+            // EXPECTATION: merged heatmaps add up
+            object::Heatmap other(TABLE_TOP_X, TABLE_TOP_Y);
+            other.merge(heatmap);
+            other.merge(heatmap);
+            ASSERT_EQUALS_INT(int(other.getDwell(0, 1, type::HEADING::EAST)), 4, true);
+            object::Heatmap wrongSize(2, 2);
+            ASSERT_EQUALS_INT(wrongSize.merge(heatmap), false, true);
+        };
+        CREATE_TEST(test_toyRobot_heatmap)
+
+        /**
+         * TEST: forked robots and fleets should evolve independently of their origin
+        */
+        auto test_toyRobot_fork = [&](){
+            object::ToyRobot origin;
+            origin.proccessInput("PLACE 1,1,NORTH");
+            object::ToyRobot fork;
+            fork.restore(origin.snapshot());
+            fork.proccessInput("MOVE");
+            std::string output = origin.getReport();
+            std::string PARAM_OUTPUT = "1,1,NORTH";
+            ASSERT_EQUALS_STRING(output, PARAM_OUTPUT, true);
+            output = fork.getReport();
+            PARAM_OUTPUT = "1,2,NORTH";
+            ASSERT_EQUALS_STRING(output, PARAM_OUTPUT, true);
+
+            // EXPECTATION: each candidate starts from the origin state
+            object::ParallelEvaluator evaluator(2);
+            const std::vector<std::vector<std::string>> candidates =
+            {
+                { "MOVE", "MOVE" },
+                { "RIGHT", "MOVE", "MOVE", "MOVE", "MOVE" },
+                { },
+                { "PLACE 9,9,NORTH", "LEFT" }
+            };
+            const std::vector<std::string> reports = evaluator.evaluate(origin, candidates);
+            const std::vector<std::string> expected = { "1,3,NORTH", "4,1,EAST", "1,1,NORTH", "1,1,WEST" };
+            for(size_t i = 0; i < expected.size(); ++i)
+                ASSERT_EQUALS_STRING(reports[i], expected[i], true);
+
+            // EXPECTATION: more candidates than workers, each still starts from the origin state
+            std::vector<std::vector<std::string>> many(50);
+            for(size_t i = 0; i < many.size(); ++i)
+                many[i].assign(i % 3, "MOVE");
+            const std::vector<std::string> manyReports = evaluator.evaluate(origin, many);
+            int mismatches = 0;
+            for(size_t i = 0; i < many.size(); ++i)
+                mismatches += manyReports[i] != "1," + std::to_string(1 + i % 3) + ",NORTH";
+            ASSERT_EQUALS_INT(mismatches, 0, true);
+
+            // EXPECTATION: a worker robot does not keep macros of an earlier candidate
+            object::ParallelEvaluator single(1);
+            const std::vector<std::string> macroReports = single.evaluate(origin, { { "DEFINE GO MOVE" }, { "CALL GO" } });
+            ASSERT_EQUALS_STRING(macroReports[1], std::string("1,1,NORTH"), true);
+
+            // EXPECTATION: unplaced origin forks stay unplaced
+            object::ToyRobot unplaced;
+            const std::vector<std::string> unplacedReports = evaluator.evaluate(unplaced, { { "MOVE" } });
+            ASSERT_EQUALS_INT(int(unplacedReports[0].size()), 0, true);
+
+            // EXPECTATION: fleet forks do not share state
+            object::Fleet fleet(10, 10);
+            fleet.placeHere(fleet.addRobot(), 5, 5, type::HEADING::EAST);
+            auto fleetFork = fleet.fork();
+            fleetFork->move(0);
+            output = fleet.getReport(0);
+            PARAM_OUTPUT = "5,5,EAST";
+            ASSERT_EQUALS_STRING(output, PARAM_OUTPUT, true);
+            output = fleetFork->getReport(0);
+            PARAM_OUTPUT = "6,5,EAST";
+            ASSERT_EQUALS_STRING(output, PARAM_OUTPUT, true);
+        };
+        CREATE_TEST(test_toyRobot_fork)
+
+        /**
+         * TEST: UNDO and REDO should step through accepted commands only
+        */
+        auto test_toyRobot_undo_redo = [&](){
+            object::ToyRobot robot;
+            robot.setHistoryCapacity(3);
+
+            // EXPECTATION: the first PLACE can be undone back to unplaced
+            robot.proccessInput("PLACE 0,0,NORTH");
+            robot.proccessInput("UNDO");
+            ASSERT_EQUALS_INT(robot.isPlaced(), false, true);
+            robot.proccessInput("REDO");
+            std::string output = robot.getReport();
+            std::string PARAM_OUTPUT = "0,0,NORTH";
+            ASSERT_EQUALS_STRING(output, PARAM_OUTPUT, true);
+
+            // rejected commands do not take history slots
+            // EXPECTATION: UNDO steps over the rejected moves to the state before RIGHT
+            robot.proccessInput("LEFT");
+            robot.proccessInput("MOVE");
+            robot.proccessInput("MOVE");
+            robot.proccessInput("RIGHT");
+            robot.proccessInput("UNDO");
+            output = robot.getReport();
+            PARAM_OUTPUT = "0,0,WEST";
+            ASSERT_EQUALS_STRING(output, PARAM_OUTPUT, true);
+
+            // EXPECTATION: a new command clears REDO
+            robot.proccessInput("RIGHT");
+            robot.proccessInput("RIGHT");
+            ASSERT_EQUALS_INT(int(robot.getRedoCount()), 0, true);
+            robot.proccessInput("REDO");
+            output = robot.getReport();
+            PARAM_OUTPUT = "0,0,EAST";
+            ASSERT_EQUALS_STRING(output, PARAM_OUTPUT, true);
+
+            // EXPECTATION: only capacity commands can be undone
+            robot.proccessInput("MOVE");
+            robot.proccessInput("MOVE");
+            robot.proccessInput("MOVE");
+            robot.proccessInput("MOVE");
+            for(int i = 0; i < 5; ++i)
+                robot.proccessInput("UNDO");
+            output = robot.getReport();
+            PARAM_OUTPUT = "1,0,EAST";
+            ASSERT_EQUALS_STRING(output, PARAM_OUTPUT, true);
+            ASSERT_EQUALS_INT(int(robot.getUndoCount()), 0, true);
+            for(int i = 0; i < 5; ++i)
+                robot.proccessInput("REDO");
+            output = robot.getReport();
+            PARAM_OUTPUT = "4,0,EAST";
+            ASSERT_EQUALS_STRING(output, PARAM_OUTPUT, true);
+        };
+        CREATE_TEST(test_toyRobot_undo_redo)
+
+        /**
+         * TEST: parsed commands and the pipeline should match proccessInput
+        */
+        auto test_toyRobot_pipeline = [&](){
+            const std::vector<std::string> commands =
+            {
+                "PLACE 1,2,EAST", "MOVE", "MOVE", "REPORT", "PLACE 1,1,NORTH3", "PLACE ,,WEST", "REPORT",
+                "PLACE 1,1,NORTH,extra", "REPORT", "MOVEa", "MOVE now", "LEFT", "PLACE 5,0,NORTH", "PLACE 1",
+                "PLACE 999999999999,1,NORTH", "PLACE 2,3,SOUTH", "UNDO", "REDO", "RIGHT", "MOVE", "REPORT", "PLACE"
+            };
+            // reference run through the action map
+            object::ToyRobot reference;
+            std::vector<std::string> referenceReports;
+            reference.setReportCallback([&](const std::string& _report){ referenceReports.push_back(_report); });
+            std::string script;
+            for(const auto& command : commands)
+            {
+                reference.proccessInput(command);
+                script.append(command).append(script.size() % 2 ? "\n" : "|");
+            }
+
+            // EXPECTATION: same reports and final state with chunks split mid command
+            object::PipelineConfig config;
+            config.m_chunkSize = 7;
+            config.m_batchSize = 3;
+            config.m_queueDepth = 2;
+            object::ToyRobot robot;
+            std::vector<std::string> reports;
+            robot.setReportCallback([&](const std::string& _report){ reports.push_back(_report); });
+            std::istringstream input(script);
+            const object::PipelineStats stats = object::Pipeline(config).run(input, robot);
+            ASSERT_EQUALS_INT(int(stats.m_commands), int(commands.size()), true);
+            ASSERT_EQUALS_INT(int(reports.size()), int(referenceReports.size()), true);
+            for(size_t i = 0; i < reports.size(); ++i)
+                ASSERT_EQUALS_STRING(reports[i], referenceReports[i], true);
+            std::string output = robot.getReport();
+            std::string PARAM_OUTPUT = reference.getReport();
+            ASSERT_EQUALS_STRING(output, PARAM_OUTPUT, true);
+        };
+        CREATE_TEST(test_toyRobot_pipeline)
+
+        /**
+         * TEST: fuzz the vector tokenizer against getline splitting on "|" then new lines
+        */
+        auto test_tokenizer_differential = [&](){
+            const char alphabet[] = { '|', '\n', '\r', 'M', 'O', 'V', 'E', ' ', ',', '1' };
+            std::mt19937 random(32);
+            int mismatches = 0;
+            for(int round = 0; round < 2000; ++round)
+            {
+                std::string text(random() % 300, ' ');
+                for(char& c : text)
+                    c = alphabet[random() % sizeof(alphabet)];
+                // reference: the data set runner split on "|", lines and carriage returns are split the same way
+                std::vector<std::string> expected;
+                std::istringstream stream(text);
+                std::string piece, line, command;
+                while(std::getline(stream, piece, '|'))
+                {
+                    std::istringstream lines(piece);
+                    while(std::getline(lines, line, '\n'))
+                    {
+                        std::istringstream carriages(line);
+                        while(std::getline(carriages, command, '\r'))
+                            if(!command.empty())
+                                expected.push_back(command);
+                    }
+                }
+                for(const auto isa : { object::Tokenizer::ISA::SCALAR, object::Tokenizer::ISA::SSE2, object::Tokenizer::ISA::AVX2 })
+                {
+                    std::vector<std::string_view> views;
+                    object::Tokenizer::split(text, views, isa);
+                    if(std::vector<std::string>(views.begin(), views.end()) != expected)
+                        ++mismatches;
+                }
+                // streamed in random chunks
+                std::vector<std::string> streamed;
+                object::Tokenizer tokenizer;
+                size_t offset = 0;
+                while(offset < text.size())
+                {
+                    const size_t length = std::min<size_t>(text.size() - offset, 1 + random() % 80);
+                    tokenizer.feed(std::string_view(text).substr(offset, length), [&](std::string_view _command){ streamed.emplace_back(_command); });
+                    offset += length;
+                }
+                tokenizer.finish([&](std::string_view _command){ streamed.emplace_back(_command); });
+                if(streamed != expected)
+                    ++mismatches;
+            }
+            ASSERT_EQUALS_INT(mismatches, 0, true);
+        };
+        CREATE_TEST(test_tokenizer_differential)
+
+        /**
+         * TEST: data-set directories and globs list files in path order and replay them on a thread pool,
+         *       printing every file's REPORT output in path order
+        */
+        auto test_dataSet_directory = [&](){
+            const std::filesystem::path directory = _tempPath("toyRobotDataSets");
+            std::filesystem::create_directories(directory);
+            const char* scripts[] = { "PLACE 1,1,NORTH|MOVE|REPORT", "PLACE 0,0,EAST\nMOVE\nMOVE\nREPORT", "MOVE|REPORT" };
+            for(int i = 2; i >= 0; --i)
+                std::ofstream(directory / ("set" + std::to_string(i) + ".txt")) << scripts[i];
+            const std::vector<std::string> paths = _listDataSets(directory.string());
+            const std::vector<std::string> globbed = _listDataSets((directory / "set*.txt").string());
+            std::string reports;
+            uint64_t commands = 0;
+            for(const std::string& path : paths)
+            {
+                object::ToyRobot robot;
+                robot.setReportCallback([&](const std::string& _report){ reports += _report + ";"; });
+                commands += _replayFile(path, robot, false);
+            }
+            // replay on 4 threads and keep the per file blocks, they must come out in path order
+            FILE* output = tmpfile();
+            runDataSetDirectory(directory.string(), 4, nullptr, output);
+            std::string printed(size_t(ftell(output)), '\0');
+            rewind(output);
+            printed.resize(fread(&printed[0], 1, printed.size(), output));
+            fclose(output);
+            const std::string summary = printed.substr(printed.find("\nTEST:  summary"));
+            printed = printed.substr(0, printed.find("\nTEST:  summary"));
+            printed = printed.substr(printed.find('\n', 1) + 1);
+            std::string expected;
+            for(size_t i = 0; i < paths.size(); ++i)
+                expected += "TEST:  " + paths[i] + "\n" + std::string(i == 0 ? "Output : 1,2,NORTH\n" :
+                    i == 1 ? "Output : 2,0,EAST\n" : "");
+            // a second run from a cache marks every file as a hit instead of timing its lookup as a replay
+            object::ResultCache cache;
+            runDataSetDirectory(directory.string(), 2, &cache, output = tmpfile());
+            runDataSetDirectory(directory.string(), 2, &cache, output);
+            std::string cachedRun(size_t(ftell(output)), '\0');
+            rewind(output);
+            cachedRun.resize(fread(&cachedRun[0], 1, cachedRun.size(), output));
+            fclose(output);
+            cachedRun = cachedRun.substr(cachedRun.rfind("\nTEST:  summary"));
+            size_t hits = 0;
+            for(size_t at = cachedRun.find("cache hit"); at != std::string::npos; at = cachedRun.find("cache hit", at + 1))
+                ++hits;
+            std::filesystem::remove_all(directory);
+            ASSERT_EQUALS_INT(int(paths.size()), 3, true);
+            ASSERT_EQUALS_INT(int(paths == globbed), 1, true);
+            ASSERT_EQUALS_INT(int(commands), 9, true);
+            ASSERT_EQUALS_INT(int(summary.find("cache hit") == std::string::npos), 1, true);
+            ASSERT_EQUALS_INT(int(hits), 3, true);
+            ASSERT_EQUALS_INT(int(cachedRun.find("9 commands (9 from cache)") != std::string::npos), 1, true);
+            ASSERT_EQUALS_STRING(reports, std::string("1,2,NORTH;2,0,EAST;"), true);
+            ASSERT_EQUALS_STRING(printed, expected, true);
+        };
+        CREATE_TEST(test_dataSet_directory)
+
+        /**
+         * TEST: StaticRobot picks the smallest transform type and matches ToyRobot on random scripts
+        */
+        auto test_static_robot = [&](){
+            // smallest transform is picked from the extents
+            static_assert(sizeof(object::StaticRobot<4, 4>::TransformType) == 1, "5x5 table fits a uint8_t");
+            static_assert(sizeof(object::StaticRobot<7, 100>::TransformType) == 2, "101 rows need a uint16_t");
+            static_assert(sizeof(object::StaticRobot<32767, 0>::TransformType) == 4, "32768 columns need a uint32_t");
+            static_assert(sizeof(object::StaticRobot<32768, 0>::TransformType) == 8, "32769 columns need a uint64_t");
+            // same script on both robots gives the same reports and results
+            static const char* const commands[] = { "MOVE", "LEFT", "RIGHT", "REPORT", "PLACE 4,4,NORTH", "PLACE 0,0,WEST",
+                "PLACE 2,3,SOUTH", "PLACE 5,1,EAST", "PLACE 1,5,EAST", "PLACE 1,1,UP" };
+            std::mt19937 random(34);
+            object::ToyRobot runtimeRobot;
+            object::StaticRobot<TABLE_TOP_X, TABLE_TOP_Y> staticRobot;
+            std::string runtimeReports, staticReports;
+            runtimeRobot.setReportCallback([&](const std::string& _report){ runtimeReports += _report + ";"; });
+            staticRobot.setReportCallback([&](const std::string& _report){ staticReports += _report + ";"; });
+            int mismatches = 0;
+            for(int i = 0; i < 20000; ++i)
+            {
+                const char* command = commands[random() % 10];
+                type::Command parsed;
+                object::InputHandler::parseCommand(command, parsed);
+                if(runtimeRobot.execute(parsed) != staticRobot.proccessInput(command))
+                    ++mismatches;
+            }
+            ASSERT_EQUALS_INT(mismatches, 0, true);
+            ASSERT_EQUALS_INT(int(staticReports == runtimeReports), 1, true);
+            // a wide table keeps moving past the 5x5 limits
+            object::StaticRobot<999, 999> wideRobot;
+            wideRobot.placeHere(998, 0, type::HEADING::EAST);
+            const int movedInside = wideRobot.move();
+            const int movedOutside = wideRobot.move();
+            ASSERT_EQUALS_INT(movedInside, 1, true);
+            ASSERT_EQUALS_INT(movedOutside, 0, true);
+            ASSERT_EQUALS_STRING(wideRobot.getReport(), std::string("999,0,EAST"), true);
+        };
+        CREATE_TEST(test_static_robot)
+
+        /**
+         * TEST: coroutine scripts should report like a blocking run and hand back the caller's report callback
+        */
+        auto test_script_coroutines = [&](){
+            static const char* const commands[] = { "MOVE", "LEFT", "RIGHT", "REPORT", "PLACE 1,2,NORTH", "PLACE 3,0,WEST" };
+            const size_t SCRIPTS = 50;
+            std::mt19937 random(35);
+            std::vector<std::string> scripts(SCRIPTS);
+            std::vector<std::string> expected(SCRIPTS), reports(SCRIPTS);
+            for(size_t i = 0; i < SCRIPTS; ++i)
+            {
+                // blocking reference run
+                object::ToyRobot robot;
+                robot.setReportCallback([&](const std::string& _report){ expected[i] += _report + ";"; });
+                for(int c = 0; c < 40; ++c)
+                {
+                    const char* command = commands[random() % 6];
+                    scripts[i].append(command).push_back(c % 2 ? '|' : '\n');
+                    robot.proccessInput(command);
+                }
+            }
+            std::vector<std::unique_ptr<object::ToyRobot>> robots;
+            object::ScriptScheduler scheduler;
+            for(size_t i = 0; i < SCRIPTS; ++i)
+            {
+                robots.push_back(std::make_unique<object::ToyRobot>());
+                scheduler.add(object::runScript(*robots.back(), scripts[i], 3));
+            }
+            uint64_t slices = 0, lastCommands = 0;
+            const uint64_t yields = scheduler.run([&](size_t _id, const object::ScriptYield& _yield)
+            {
+                if(_yield.m_reason == object::ScriptYield::REASON::REPORT)
+                    reports[_id] += _yield.m_report + ";";
+                else
+                    ++slices;
+                if(_id == 0)
+                    lastCommands = _yield.m_commands;
+            });
+            int mismatches = 0;
+            uint64_t reportCount = 0;
+            for(size_t i = 0; i < SCRIPTS; ++i)
+            {
+                mismatches += reports[i] != expected[i];
+                reportCount += std::count(expected[i].begin(), expected[i].end(), ';');
+            }
+            ASSERT_EQUALS_INT(mismatches, 0, true);
+            ASSERT_EQUALS_INT(int(yields), int(slices + reportCount), true);
+            ASSERT_EQUALS_INT(int(slices > 0), 1, true);
+            ASSERT_EQUALS_INT(int(lastCommands <= 40 && lastCommands >= 38), 1, true);
+            ASSERT_EQUALS_INT(int(scheduler.size()), 0, true);
+            // destroying a suspended script releases the report callback
+            object::ToyRobot robot;
+            {
+                object::ScriptTask task = object::runScript(robot, "PLACE 0,0,NORTH|REPORT|MOVE|REPORT");
+                task.resume();
+                ASSERT_EQUALS_STRING(task.current().m_report, std::string("0,0,NORTH"), true);
+            }
+            robot.proccessInput("REPORT");
+            std::string captured;
+            robot.setReportCallback([&](const std::string& _report){ captured = _report; });
+            robot.proccessInput("REPORT");
+            ASSERT_EQUALS_STRING(captured, std::string("0,0,NORTH"), true);
+            // a finished script restores the callback set before it ran
+            {
+                object::ScriptTask task = object::runScript(robot, "MOVE|REPORT");
+                while(task.resume());
+            }
+            captured.clear();
+            robot.proccessInput("REPORT");
+            ASSERT_EQUALS_STRING(captured, std::string("0,1,NORTH"), true);
+        };
+        CREATE_TEST(test_script_coroutines)
+
+        /**
+         * TEST: TickEngine resolves conflicting moves by slot order and gives the same fleet on any thread count
+        */
+        auto test_tick_engine = [&](){
+            auto command = [](type::ACTION _action, uint32_t _x = 0, uint32_t _y = 0, type::HEADING _heading = type::HEADING::UNDEFINED)
+            {
+                type::Command result;
+                result.action = _action;
+                result.x = _x;
+                result.y = _y;
+                result.heading = _heading;
+                return result;
+            };
+            const type::Command MOVE = command(type::ACTION::MOVE);
+            object::Fleet fleet(9, 9);
+            for(int i = 0; i < 6; ++i)
+                fleet.addRobot();
+            // 0 and 1 both step into 2,2, the lower slot wins
+            fleet.placeHere(0, 1, 2, type::HEADING::EAST);
+            fleet.placeHere(1, 3, 2, type::HEADING::WEST);
+            // 2 and 3 face each other on adjacent cells and cannot swap
+            fleet.placeHere(2, 5, 5, type::HEADING::EAST);
+            fleet.placeHere(3, 6, 5, type::HEADING::WEST);
+            // 4 follows 5 north, 5 moves but 4 cannot take the cell 5 vacates in the same tick
+            fleet.placeHere(4, 8, 0, type::HEADING::NORTH);
+            fleet.placeHere(5, 8, 1, type::HEADING::NORTH);
+            object::TickEngine engine(fleet, nullptr, 1);
+            for(int i = 0; i < 6; ++i)
+                engine.addStream({ MOVE, MOVE });
+            const object::TickEngine::TickStats first = engine.tick();
+            ASSERT_EQUALS_INT(int(first.m_commands), 6, true);
+            ASSERT_EQUALS_INT(int(first.m_accepted), 2, true);
+            ASSERT_EQUALS_INT(int(first.m_collisions), 4, true);
+            ASSERT_EQUALS_INT(int(engine.getPosition(0).x), 2, true);
+            ASSERT_EQUALS_INT(int(engine.getPosition(1).x), 3, true);
+            ASSERT_EQUALS_INT(int(engine.getPosition(2).x), 5, true);
+            ASSERT_EQUALS_INT(int(engine.getPosition(4).y), 0, true);
+            ASSERT_EQUALS_INT(int(engine.getPosition(5).y), 2, true);
+            // on the next tick 4 can follow, 0 and 1 now face each other and both stay
+            const object::TickEngine::TickStats second = engine.tick();
+            ASSERT_EQUALS_INT(int(engine.getPosition(4).y), 1, true);
+            ASSERT_EQUALS_INT(int(engine.getPosition(0).x), 2, true);
+            ASSERT_EQUALS_INT(int(engine.getPosition(1).x), 3, true);
+            ASSERT_EQUALS_INT(int(second.m_accepted + second.m_rejected), 6, true);
+            // streams ran out, robots idle and the fleet only changes on sync
+            ASSERT_EQUALS_INT(int(engine.tick().m_commands), 0, true);
+            ASSERT_EQUALS_INT(int(fleet.getPosition(0).x), 1, true);
+            engine.syncToFleet();
+            ASSERT_EQUALS_STRING(fleet.getReport(0), std::string("2,2,EAST"), true);
+
+            // random streams over several blocks give the same result on any thread count
+            auto simulate = [&](const unsigned _threads)
+            {
+                object::Fleet randomFleet(31, 31);
+                std::mt19937 random(36);
+                std::vector<std::vector<type::Command>> streams(70000);
+                for(auto& stream : streams)
+                {
+                    randomFleet.addRobot();
+                    stream.push_back(command(type::ACTION::PLACE, random() % 32, random() % 32, type::HEADING(random() % 4)));
+                    for(int i = 0; i < 15; ++i)
+                        stream.push_back(command(type::ACTION(random() % 3)));
+                }
+                object::TickEngine randomEngine(randomFleet, nullptr, _threads);
+                for(const auto& stream : streams)
+                    randomEngine.addStream(stream);
+                randomEngine.setLooping(true);
+                randomEngine.run(12);
+                std::string state;
+                for(uint32_t robot = 0; robot < randomEngine.size(); ++robot)
+                {
+                    const auto position = randomEngine.getPosition(robot);
+                    state.append(std::to_string(position.x * 32 + position.y)).push_back(randomEngine.isPlaced(robot) ? '+' : '-');
+                }
+                return state;
+            };
+            ASSERT_EQUALS_INT(int(simulate(1) == simulate(4)), 1, true);
+
+            // 100 robots on a 100x100 table use the open addressed cell table, 1300 more unplaced robots without
+            // streams make the same table dense. both give the same result
+            auto simulateCells = [&](const uint32_t _idleRobots)
+            {
+                object::Fleet cellFleet(99, 99);
+                std::mt19937 random(36);
+                std::vector<std::vector<type::Command>> streams(100);
+                for(auto& stream : streams)
+                {
+                    stream.push_back(command(type::ACTION::PLACE, random() % 100, random() % 100, type::HEADING(random() % 4)));
+                    for(int i = 0; i < 15; ++i)
+                    {
+                        const uint32_t roll = random() % 4;
+                        stream.push_back(command(roll < 2 ? type::ACTION::MOVE : roll == 2 ? type::ACTION::LEFT : type::ACTION::RIGHT));
+                    }
+                }
+                for(uint32_t i = 0; i < 100 + _idleRobots; ++i)
+                    cellFleet.addRobot();
+                object::TickEngine cellEngine(cellFleet, nullptr, 1);
+                for(const auto& stream : streams)
+                    cellEngine.addStream(stream);
+                cellEngine.setLooping(true);
+                cellEngine.run(300);
+                std::string state;
+                for(uint32_t robot = 0; robot < 100; ++robot)
+                {
+                    const auto position = cellEngine.getPosition(robot);
+                    state.append(std::to_string(position.x * 100 + position.y)).push_back(cellEngine.isPlaced(robot) ? '+' : '-');
+                }
+                return state;
+            };
+            ASSERT_EQUALS_INT(int(simulateCells(0) == simulateCells(1300)), 1, true);
+
+            // the largest table costs memory by robot, not by cell, and streams past the fleet are refused
+            object::Fleet largeFleet(object::Fleet::MAX_EXTENT, object::Fleet::MAX_EXTENT);
+            largeFleet.placeHere(largeFleet.addRobot(), object::Fleet::MAX_EXTENT, 0, type::HEADING::NORTH);
+            object::TickEngine largeEngine(largeFleet, nullptr, 1);
+            const uint32_t largeSlot = largeEngine.addStream({ MOVE, MOVE });
+            const uint32_t extraSlot = largeEngine.addStream({ MOVE });
+            largeEngine.run(2);
+            ASSERT_EQUALS_INT(int(largeSlot), 0, true);
+            ASSERT_EQUALS_INT(int(extraSlot == object::TickEngine::NO_ROBOT), 1, true);
+            ASSERT_EQUALS_INT(int(largeEngine.getPosition(0).y), 2, true);
+        };
+        CREATE_TEST(test_tick_engine)
+
+        /**
+         * TEST: PerfCheck reads the numbers of a baseline by dotted path and rejects malformed documents
+        */
+        auto test_perf_baseline_parser = [&](){
+            std::map<std::string, double> values;
+            const bool isParsed = PerfCheck::parseJson(
+                "{ \"calibration_ns\": 2.5, \"name\": \"skip\",\n"
+                "  \"scenarios\": { \"mixed\": { \"median_ns\": 84.5, \"p99_ns\": 1e2 } }, \"optimised\": 1 }", values);
+            ASSERT_EQUALS_INT(isParsed, true, true);
+            ASSERT_EQUALS_INT(int(values.size()), 4, true);
+            ASSERT_EQUALS_INT(int(values["scenarios.mixed.median_ns"] * 10), 845, true);
+            ASSERT_EQUALS_INT(int(values["scenarios.mixed.p99_ns"]), 100, true);
+            ASSERT_EQUALS_INT(int(values.count("name")), 0, true);
+            std::map<std::string, double> broken;
+            const bool isBrokenParsed = PerfCheck::parseJson("{ \"calibration_ns\" 2.5 }", broken);
+            ASSERT_EQUALS_INT(isBrokenParsed, false, true);
+            // arrays and literals are not values a baseline holds
+            const bool isArrayParsed = PerfCheck::parseJson("{ \"runs\": [1, 2] }", broken);
+            const bool isLiteralParsed = PerfCheck::parseJson("{ \"optimised\": true }", broken);
+            ASSERT_EQUALS_INT(int(isArrayParsed || isLiteralParsed), 0, true);
+        };
+        CREATE_TEST(test_perf_baseline_parser)
+
+        /**
+         * TEST: sampled command spans are recorded up to the buffer cap and exported as Chrome trace JSON
+        */
+        auto test_trace_export = [&](){
+            const std::string path = _tempPath("toyRobotTrace", ".json").string();
+            object::Tracer::start(path, 4, 64);
+            object::Tracer::clear();
+            object::ToyRobot robot;
+            robot.setReportCallback([](const std::string&){});
+            robot.proccessInput("PLACE 0,0,NORTH");
+            for(int i = 0; i < 99; ++i)
+                robot.proccessInput(i % 2 ? "MOVE" : "RIGHT");
+            // 25 sampled commands with dispatch, parse and execute spans, 64 fit in the buffer
+            const uint64_t recorded = object::Tracer::recordedCount();
+            const uint64_t dropped = object::Tracer::droppedCount();
+            const bool isWritten = object::Tracer::stop();
+            std::ifstream file(path);
+            std::stringstream text;
+            text << file.rdbuf();
+            std::filesystem::remove(path);
+            object::Tracer::start("", 1, size_t(1) << 20);
+            object::Tracer::stop();
+            object::Tracer::clear();
+            ASSERT_EQUALS_INT(int(recorded), 64, true);
+            ASSERT_EQUALS_INT(int(dropped), 11, true);
+            ASSERT_EQUALS_INT(isWritten, true, true);
+            ASSERT_EQUALS_INT(int(text.str().find("\"traceEvents\"") != std::string::npos), 1, true);
+            ASSERT_EQUALS_INT(int(text.str().find("\"name\":\"execute\"") != std::string::npos), 1, true);
+            // tracing is off again, spans are not recorded
+            robot.proccessInput("MOVE");
+            ASSERT_EQUALS_INT(int(object::Tracer::recordedCount()), 0, true);
+        };
+        CREATE_TEST(test_trace_export)
+
+        /**
+         * TEST: AllocationTracker attributes heap allocations to the action of each command, movement allocates nothing
+        */
+        auto test_allocation_tracking = [&](){
+            object::ToyRobot robot;
+            std::string lastReport;
+            robot.setReportCallback([&](const std::string& _report){ lastReport = _report; });
+            object::AllocationTracker::reset();
+            object::AllocationTracker::enable();
+            // the binary command path allocates nothing for movement
+            robot.execute(type::Command{ type::ACTION::PLACE, 1, 2, type::HEADING::EAST });
+            for(int i = 0; i < 100; ++i)
+            {
+                robot.execute(type::Command{ type::ACTION::MOVE, 0, 0, type::HEADING::UNDEFINED });
+                robot.execute(type::Command{ type::ACTION::LEFT, 0, 0, type::HEADING::UNDEFINED });
+                robot.execute(type::Command{ type::ACTION::RIGHT, 0, 0, type::HEADING::UNDEFINED });
+            }
+            const uint64_t commandAllocations = object::AllocationTracker::threadAllocations();
+            // short string commands stay within the small string buffer, a long one is copied to the heap
+            // by the by-value action callback and attributed to the action it resolves to
+            robot.proccessInput("PLACE 3,3,SOUTH");
+            robot.proccessInput("MOVE");
+            robot.proccessInput("REPORT");
+            robot.proccessInput("JUMP");
+            robot.proccessInput("PLACE 100,100,NORTH");
+            object::AllocationTracker::disable();
+            const object::AllocationTracker::Counts move = object::AllocationTracker::get(type::ACTION::MOVE);
+            const object::AllocationTracker::Counts place = object::AllocationTracker::get(type::ACTION::PLACE);
+            const object::AllocationTracker::Counts report = object::AllocationTracker::get(type::ACTION::REPORT);
+            const object::AllocationTracker::Counts unresolved = object::AllocationTracker::get(object::AllocationTracker::UNRESOLVED);
+            ASSERT_EQUALS_INT(int(commandAllocations), 0, true);
+            ASSERT_EQUALS_INT(int(move.m_commands), 101, true);
+            ASSERT_EQUALS_INT(int(move.m_allocations), 0, true);
+            ASSERT_EQUALS_INT(int(report.m_commands), 1, true);
+            ASSERT_EQUALS_INT(int(report.m_allocations), 0, true);
+            ASSERT_EQUALS_INT(int(unresolved.m_commands), 1, true);
+            ASSERT_EQUALS_INT(int(place.m_commands), 3, true);
+            ASSERT_EQUALS_INT(int(place.m_allocations > 0), 1, true);
+            ASSERT_EQUALS_STRING(lastReport, std::string("3,2,SOUTH"), true);
+            // tracking is off again, nothing is counted
+            robot.proccessInput("PLACE 100,100,NORTH");
+            ASSERT_EQUALS_INT(int(object::AllocationTracker::get(type::ACTION::PLACE).m_commands), 3, true);
+            object::AllocationTracker::reset();
+        };
+        CREATE_TEST(test_allocation_tracking)
+
+        /**
+         * TEST: a batch of commands gives the same reports and state as running them one by one
+        */
+        auto test_batch_commands = [&](){
+            const std::vector<std::string_view> inputs = { "MOVE", "PLACE 0,0,NORTH", "MOVE", "REPORT", "JUMP", "RIGHT",
+                "PLACE 9,9,NORTH", "MOVE", "MOVE", "REPORT", "LEFT", "LEFT", "LEFT", "MOVE", "REPORT" };
+            // the same commands one by one
+            object::ToyRobot single;
+            std::string singleReports;
+            single.setReportCallback([&](const std::string& _report){ singleReports.append(_report).push_back('\n'); });
+            for(const std::string_view input : inputs)
+                single.proccessInput(std::string(input));
+
+            object::ToyRobot robot;
+            std::string reports;
+            reports.reserve(256);
+            object::AllocationTracker::enable();
+            const uint64_t allocations = object::AllocationTracker::threadAllocations();
+            const object::InputHandler::BatchResult result = robot.processBatch(inputs, &reports);
+            const uint64_t batchAllocations = object::AllocationTracker::threadAllocations() - allocations;
+            object::AllocationTracker::disable();
+            ASSERT_EQUALS_INT(int(batchAllocations), 0, true);
+            ASSERT_EQUALS_STRING(reports, singleReports, true);
+            ASSERT_EQUALS_STRING(reports, std::string("0,1,NORTH\n2,1,EAST\n2,0,SOUTH\n"), true);
+            // first MOVE before PLACE and the out of range PLACE are rejected, JUMP is ignored
+            ASSERT_EQUALS_INT(int(result.m_accepted), 12, true);
+            ASSERT_EQUALS_INT(int(result.m_rejected), 2, true);
+            ASSERT_EQUALS_INT(int(result.m_ignored), 1, true);
+            ASSERT_EQUALS_INT(int(result.m_reports), 3, true);
+            ASSERT_EQUALS_STRING(robot.getReport(), single.getReport(), true);
+
+            // pre-parsed commands, reports go to the callback when no buffer is given
+            std::vector<type::Command> commands(inputs.size());
+            size_t parsed = 0;
+            for(const std::string_view input : inputs)
+                parsed += object::InputHandler::parseCommand(input, commands[parsed]);
+            commands.resize(parsed);
+            object::ToyRobot parsedRobot;
+            std::string callbackReports;
+            parsedRobot.setReportCallback([&](const std::string& _report){ callbackReports.append(_report).push_back('\n'); });
+            const object::InputHandler::BatchResult parsedResult = parsedRobot.processBatch(commands);
+            ASSERT_EQUALS_STRING(callbackReports, singleReports, true);
+            ASSERT_EQUALS_INT(int(parsedResult.m_accepted), 12, true);
+            ASSERT_EQUALS_INT(int(parsedResult.m_rejected), 2, true);
+            ASSERT_EQUALS_INT(int(parsedResult.m_ignored), 0, true);
+        };
+        CREATE_TEST(test_batch_commands)
+
+        /**
+         * TEST: a file mapped Fleet grows past its capacity, reopens with the same robots and refuses foreign files
+        */
+        auto test_mapped_fleet = [&](){
+            const std::string path = _tempPath("toyRobotFleet", ".bin").string();
+            std::filesystem::remove(path);
+            {
+                auto fleet = object::Fleet::openMapped(path, 99, 49, object::Fleet::SYNC::PERIODIC, 100);
+                ASSERT_EQUALS_INT(int(fleet != nullptr), 1, true);
+                ASSERT_EQUALS_INT(fleet->isMapped(), true, true);
+                // grows past the initial capacity, moving the placed flags
+                for(uint32_t i = 0; i < 3000; ++i)
+                    fleet->addRobot();
+                for(uint32_t robot = 0; robot < 3000; robot += 3)
+                    fleet->placeHere(robot, robot % 100, robot % 50, type::HEADING::EAST);
+                fleet->move(3);
+                fleet->rotateLeft(6);
+                fleet->addRobot();
+            }
+            {
+                // extents come from the file
+                auto fleet = object::Fleet::openMapped(path, 5, 5);
+                ASSERT_EQUALS_INT(int(fleet != nullptr), 1, true);
+                ASSERT_EQUALS_INT(int(fleet->size()), 3001, true);
+                ASSERT_EQUALS_INT(int(fleet->getExtentX()), 99, true);
+                ASSERT_EQUALS_INT(int(fleet->getExtentY()), 49, true);
+                int placed = 0;
+                for(uint32_t robot = 0; robot < fleet->size(); ++robot)
+                    placed += fleet->isPlaced(robot);
+                ASSERT_EQUALS_INT(placed, 1000, true);
+                ASSERT_EQUALS_STRING(fleet->getReport(3), std::string("4,3,EAST"), true);
+                ASSERT_EQUALS_STRING(fleet->getReport(6), std::string("6,6,NORTH"), true);
+                ASSERT_EQUALS_STRING(fleet->getReport(2997), std::string("97,47,EAST"), true);
+                // a fork is an independent heap fleet
+                auto copy = fleet->fork();
+                ASSERT_EQUALS_INT(copy->isMapped(), false, true);
+                copy->move(3);
+                ASSERT_EQUALS_STRING(fleet->getReport(3), std::string("4,3,EAST"), true);
+                ASSERT_EQUALS_INT(fleet->sync(), true, true);
+            }
+            {
+                // files that are not fleets of this version are refused
+                std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+                file.seekp(8);
+                file.put(char(99));
+            }
+            auto refused = object::Fleet::openMapped(path, 5, 5);
+            std::filesystem::remove(path);
+            ASSERT_EQUALS_INT(int(refused == nullptr), 1, true);
+        };
+        CREATE_TEST(test_mapped_fleet)
+
+        /**
+         * TEST: RobotPool hands out generation checked handles and reuses released robots reset
+        */
+        auto test_robot_pool = [&](){
+            object::RobotPool pool(2);
+            const object::RobotPool::Handle first = pool.create();
+            const object::RobotPool::Handle second = pool.create();
+            const object::RobotPool::Handle full = pool.create();
+            ASSERT_EQUALS_INT(first.isValid() && second.isValid(), true, true);
+            ASSERT_EQUALS_INT(full.isValid(), false, true);
+            ASSERT_EQUALS_INT(int(pool.size()), 2, true);
+            object::ToyRobot* robot = pool.get(first);
+            std::string report;
+            robot->setReportCallback([&](const std::string& _report){ report = _report; });
+            robot->setHistoryCapacity(4);
+            robot->proccessInput("PLACE 1,1,EAST");
+            robot->proccessInput("MOVE");
+            robot->proccessInput("REPORT");
+            ASSERT_EQUALS_STRING(report, std::string("2,1,EAST"), true);
+            const bool isDestroyed = pool.destroy(first);
+            const bool isDestroyedTwice = pool.destroy(first);
+            ASSERT_EQUALS_INT(isDestroyed, true, true);
+            ASSERT_EQUALS_INT(isDestroyedTwice, false, true);
+            ASSERT_EQUALS_INT(int(pool.get(first) == nullptr), 1, true);
+
+            // the slot and robot are reused in the state of a new robot, the old handle stays stale
+            object::AllocationTracker::enable();
+            const uint64_t allocations = object::AllocationTracker::threadAllocations();
+            const object::RobotPool::Handle reused = pool.create();
+            object::ToyRobot* reusedRobot = pool.get(reused);
+            reusedRobot->proccessInput("MOVE");
+            reusedRobot->proccessInput("REPORT");
+            const bool isReusedDestroyed = pool.destroy(reused);
+            const object::RobotPool::Handle again = pool.create();
+            const uint64_t churnAllocations = object::AllocationTracker::threadAllocations() - allocations;
+            object::AllocationTracker::disable();
+            ASSERT_EQUALS_INT(int(reused.m_index), int(first.m_index), true);
+            ASSERT_EQUALS_INT(int(reusedRobot == robot), 1, true);
+            ASSERT_EQUALS_INT(int(pool.get(first) == nullptr), 1, true);
+            ASSERT_EQUALS_INT(isReusedDestroyed, true, true);
+            ASSERT_EQUALS_INT(int(churnAllocations), 0, true);
+            ASSERT_EQUALS_INT(pool.get(again)->isPlaced(), false, true);
+            ASSERT_EQUALS_INT(int(pool.get(again)->getHistoryCapacity()), int(object::ToyRobot::DEFAULT_HISTORY_CAPACITY), true);
+            ASSERT_EQUALS_INT(int(pool.size()), 2, true);
+        };
+        CREATE_TEST(test_robot_pool)
+
+        /**
+         * TEST: TrajectoryRecorder stores under a byte per step and gives back the robot state at every step
+        */
+        auto test_trajectory_recorder = [&](){
+            object::ToyRobot robot;
+            robot.setReportCallback([](const std::string&){});
+            object::TrajectoryRecorder recorder(64);
+            robot.addListener(&recorder);
+            // expected state after every step, packed like getReport but cheaper to compare
+            std::vector<std::string> expected;
+            std::mt19937 random(43);
+            static const char* const commands[] = { "MOVE", "MOVE", "MOVE", "LEFT", "RIGHT", "REPORT", "UNDO", "REDO" };
+            for(int i = 0; i < 5000; ++i)
+            {
+                if(i % 97 == 0)
+                    robot.proccessInput("PLACE " + std::to_string(random() % 5) + "," + std::to_string(random() % 5) + ",WEST");
+                else
+                    robot.proccessInput(commands[random() % 8]);
+                if(recorder.size() > expected.size())
+                    expected.push_back(robot.getReport());
+            }
+            int mismatches = 0;
+            for(uint64_t step = 0; step < recorder.size(); ++step)
+            {
+                const object::TrajectoryRecorder::Transform state = recorder.stateAt(step);
+                const auto position = state.getPosition();
+                const std::string report = std::to_string(position.x) + "," + std::to_string(position.y) + ","
+                    + type::headingMap.at(state.getRotation());
+                mismatches += report != expected[step];
+            }
+            ASSERT_EQUALS_INT(int(recorder.size()), int(expected.size()), true);
+            ASSERT_EQUALS_INT(int(recorder.size() > 4000), 1, true);
+            ASSERT_EQUALS_INT(mismatches, 0, true);
+            // mostly 2 bit codes, well under a byte per step
+            ASSERT_EQUALS_INT(int(recorder.byteSize() < recorder.size()), 1, true);
+            robot.removeListener(&recorder);
+            recorder.clear();
+            ASSERT_EQUALS_INT(int(recorder.size()), 0, true);
+        };
+        CREATE_TEST(test_trajectory_recorder)
+
+        /**
+         * TEST: ShardRunner worker processes hand robots across regions and end with the same fleet as runInProcess
+        */
+        auto test_shard_runner = [&](){
+            // the same random fleet and streams, run in this process and across 2x2 worker processes
+            object::ObstacleMap obstacles;
+            for(uint32_t i = 0; i < 64; ++i)
+                obstacles.addObstacle(i * 7 % 64, i * 13 % 64);
+            auto buildFleet = [&](std::unique_ptr<object::Fleet>& _fleet, std::unique_ptr<object::ShardRunner>& _runner, const unsigned _columns, const unsigned _rows)
+            {
+                _fleet = std::make_unique<object::Fleet>(63, 63);
+                _fleet->setObstacleMap(&obstacles);
+                _runner = std::make_unique<object::ShardRunner>(*_fleet, _columns, _rows);
+                std::mt19937 random(44);
+                std::vector<type::Command> stream(200);
+                for(uint32_t robot = 0; robot < 2000; ++robot)
+                {
+                    _fleet->addRobot();
+                    if(robot % 3 != 0)
+                        _fleet->placeHere(robot, random() % 64, random() % 64, type::HEADING(random() % 4));
+                    for(type::Command& command : stream)
+                    {
+                        const uint32_t roll = random() % 100;
+                        command = type::Command();
+                        command.action = roll < 3 ? type::ACTION::PLACE : roll < 75 ? type::ACTION::MOVE
+                            : roll < 85 ? type::ACTION::LEFT : roll < 95 ? type::ACTION::RIGHT : type::ACTION::REPORT;
+                        command.x = random() % 70;
+                        command.y = random() % 70;
+                        command.heading = type::HEADING(random() % 4);
+                        // coordinates far off the table are sent to workers and still rejected there
+                        if(roll == 0)
+                            command.x = (1u << 28) + command.x % 64;
+                    }
+                    _runner->addStream(stream);
+                }
+            };
+            std::unique_ptr<object::Fleet> reference;
+            std::unique_ptr<object::ShardRunner> referenceRunner;
+            buildFleet(reference, referenceRunner, 2, 2);
+            const object::ShardRunner::ShardStats referenceStats = referenceRunner->runInProcess();
+            std::unique_ptr<object::Fleet> sharded;
+            std::unique_ptr<object::ShardRunner> shardedRunner;
+            buildFleet(sharded, shardedRunner, 2, 2);
+            const object::ShardRunner::ShardStats stats = shardedRunner->run();
+            int mismatches = 0;
+            for(uint32_t robot = 0; robot < reference->size(); ++robot)
+                mismatches += reference->isPlaced(robot) != sharded->isPlaced(robot)
+                    || (reference->isPlaced(robot) && reference->getReport(robot) != sharded->getReport(robot));
+            ASSERT_EQUALS_INT(int(stats.m_workerCommands.size()), 4, true);
+            ASSERT_EQUALS_INT(int(stats.m_commands), int(referenceStats.m_commands), true);
+            ASSERT_EQUALS_INT(int(stats.m_commands), 2000 * 200, true);
+            ASSERT_EQUALS_INT(int(stats.m_handoffs > 1000), 1, true);
+            ASSERT_EQUALS_INT(mismatches, 0, true);
+        };
+        CREATE_TEST(test_shard_runner)
+
+        /**
+         * TEST: CALL should match running the macro body command by command, as one UNDO step
+        */
+        auto test_macros = [&](){
+            object::ObstacleMap obstacles;
+            obstacles.addObstacle(2, 2);
+            object::ToyRobot robot;
+            object::ToyRobot expanded;
+            robot.setObstacleMap(&obstacles);
+            expanded.setObstacleMap(&obstacles);
+            std::string report;
+            std::string expandedReport;
+            robot.setReportCallback([&](const std::string& _report){ report = _report; });
+            expanded.setReportCallback([&](const std::string& _report){ expandedReport = _report; });
+            std::mt19937 random(45);
+            static const char* const commands[] = { "MOVE", "MOVE", "LEFT", "RIGHT", "PLACE 0,0,NORTH", "PLACE 4,3,WEST" };
+            int mismatches = 0;
+            for(int trial = 0; trial < 200; ++trial)
+            {
+                std::vector<std::string> inner;
+                for(int i = 0; i < 20; ++i)
+                    inner.push_back(commands[random() % 6]);
+                std::string body;
+                for(const std::string& command : inner)
+                    body.append(command).append(";");
+                std::vector<std::string> outer(inner);
+                outer.push_back("MOVE");
+                outer.insert(outer.end(), inner.begin(), inner.end());
+                outer.push_back("LEFT");
+                // fresh robots, unplaced now and then
+                const std::string place = "PLACE " + std::to_string(random() % 5) + "," + std::to_string(random() % 5) + ",EAST";
+                robot.reset();
+                expanded.reset();
+                robot.setReportCallback([&](const std::string& _report){ report = _report; });
+                expanded.setReportCallback([&](const std::string& _report){ expandedReport = _report; });
+                robot.proccessInput("DEFINE INNER " + body);
+                robot.proccessInput("DEFINE OUTER CALL INNER; MOVE; CALL INNER; LEFT");
+                if(trial % 5 != 0)
+                {
+                    robot.proccessInput(place);
+                    expanded.proccessInput(place);
+                }
+                robot.proccessInput("CALL OUTER");
+                for(const std::string& command : outer)
+                    expanded.proccessInput(command);
+                robot.proccessInput("REPORT");
+                expanded.proccessInput("REPORT");
+                mismatches += robot.isPlaced() != expanded.isPlaced() || report != expandedReport;
+            }
+            ASSERT_EQUALS_INT(mismatches, 0, true);
+
+            // the cached transition follows obstacle changes
+            robot.reset();
+            robot.setReportCallback([&](const std::string& _report){ report = _report; });
+            robot.proccessInput("DEFINE RUN MOVE;MOVE;MOVE");
+            robot.proccessInput("PLACE 3,0,NORTH");
+            robot.proccessInput("CALL RUN");
+            robot.proccessInput("REPORT");
+            ASSERT_EQUALS_STRING(report, std::string("3,3,NORTH"), true);
+            obstacles.addObstacle(3, 2);
+            robot.proccessInput("PLACE 3,0,NORTH");
+            robot.proccessInput("CALL RUN");
+            robot.proccessInput("REPORT");
+            ASSERT_EQUALS_STRING(report, std::string("3,1,NORTH"), true);
+            // a call is one UNDO step
+            robot.proccessInput("UNDO");
+            robot.proccessInput("REPORT");
+            ASSERT_EQUALS_STRING(report, std::string("3,0,NORTH"), true);
+
+            // recursion and anything but PLACE, MOVE, LEFT and RIGHT are rejected
+            const bool isDefined = robot.define("LOOP", "MOVE; CALL LOOP");
+            const bool isCalled = robot.call("LOOP");
+            const bool isReportDefined = robot.define("SHOW", "REPORT");
+            const bool isUnknownCalled = robot.call("SHOW");
+            ASSERT_EQUALS_INT(isDefined, true, true);
+            ASSERT_EQUALS_INT(isCalled, false, true);
+            ASSERT_EQUALS_INT(isReportDefined, false, true);
+            ASSERT_EQUALS_INT(isUnknownCalled, false, true);
+            type::Command command;
+            const bool isParsed = object::InputHandler::parseCommand("CALL RUN", command);
+            ASSERT_EQUALS_INT(isParsed, false, true);
+
+            // a robot without obstacles
+            object::ToyRobot plain;
+            plain.define("STEP", "MOVE;RIGHT");
+            plain.placeHere(0, 0, type::HEADING::NORTH);
+            plain.call("STEP");
+            ASSERT_EQUALS_STRING(plain.getReport(), std::string("0,1,EAST"), true);
+
+            // a patrol that ends where it started is accepted and still one UNDO step
+            plain.define("PATROL", "MOVE;RIGHT;RIGHT;MOVE;RIGHT;RIGHT");
+            plain.proccessInput("LEFT");
+            const bool isPatrolled = plain.call("PATROL");
+            ASSERT_EQUALS_INT(isPatrolled, true, true);
+            ASSERT_EQUALS_STRING(plain.getReport(), std::string("0,1,NORTH"), true);
+            plain.proccessInput("UNDO");
+            ASSERT_EQUALS_STRING(plain.getReport(), std::string("0,1,NORTH"), true);
+            plain.proccessInput("UNDO");
+            ASSERT_EQUALS_STRING(plain.getReport(), std::string("0,1,EAST"), true);
+            // a body whose every command is rejected is rejected
+            plain.define("BUMP", "MOVE;MOVE");
+            plain.placeHere(0, 4, type::HEADING::NORTH);
+            const bool isBumped = plain.call("BUMP");
+            ASSERT_EQUALS_INT(isBumped, false, true);
+        };
+        CREATE_TEST(test_macros)
+
+        /**
+         * TEST: ResultCache keys replays by content, evicts least recently used results and reads them back from disk
+        */
+        auto test_result_cache = [&](){
+            // equal bytes give equal hashes however they are split
+            object::ContentHasher whole;
+            whole.update("PLACE 0,0,NORTH|MOVE|REPORT");
+            object::ContentHasher split;
+            split.update("PLACE 0,0,");
+            split.update("NORTH|MO");
+            split.update("VE|REPORT");
+            object::ContentHasher longer;
+            longer.update("PLACE 0,0,NORTH|MOVE|REPORT|");
+            ASSERT_EQUALS_INT(int(whole.digest() == split.digest()), 1, true);
+            ASSERT_EQUALS_INT(int(whole.digest() == longer.digest()), 0, true);
+
+            object::ToyRobot robot;
+            const object::ResultCache::Key key = object::ResultCache::makeKey(whole, robot.snapshot(), 4, 4, nullptr);
+            const object::ResultCache::Key largerKey = object::ResultCache::makeKey(whole, robot.snapshot(), 9, 9, nullptr);
+            robot.placeHere(0, 1, type::HEADING::NORTH);
+            const object::ResultCache::Result result{ robot.snapshot(), 3, "Output : 0,1,NORTH\n" };
+            const object::ResultCache::Key placedKey = object::ResultCache::makeKey(whole, robot.snapshot(), 4, 4, nullptr);
+            object::ObstacleMap obstacles;
+            obstacles.addObstacle(3, 3);
+            const object::ResultCache::Key blockedKey = object::ResultCache::makeKey(whole, object::ToyRobot::Snapshot(), 4, 4, &obstacles);
+            ASSERT_EQUALS_INT(int(key == placedKey || key == largerKey || key == blockedKey), 0, true);
+
+            const std::filesystem::path directory = _tempPath("toyrobot_result_cache_test");
+            std::filesystem::remove_all(directory);
+            object::ResultCacheConfig config;
+            config.m_maxEntries = 2;
+            config.m_directory = directory.string();
+            {
+                object::ResultCache cache(config);
+                object::ResultCache::Result found;
+                const bool isMissed = !cache.find(key, found);
+                cache.store(key, result);
+                const bool isFound = cache.find(key, found);
+                ASSERT_EQUALS_INT(isMissed && isFound, true, true);
+                ASSERT_EQUALS_STRING(found.m_reports, result.m_reports, true);
+                // two more results push the first one out of memory, it is then read back from disk
+                cache.store(placedKey, result);
+                cache.store(largerKey, result);
+                const bool isFoundOnDisk = cache.find(key, found);
+                const object::ResultCache::Stats stats = cache.getStats();
+                ASSERT_EQUALS_INT(isFoundOnDisk, true, true);
+                ASSERT_EQUALS_INT(int(stats.m_hits), 2, true);
+                ASSERT_EQUALS_INT(int(stats.m_diskHits), 1, true);
+                ASSERT_EQUALS_INT(int(stats.m_misses), 1, true);
+                ASSERT_EQUALS_INT(int(stats.m_evictions), 2, true);
+                ASSERT_EQUALS_INT(int(stats.m_entries), 2, true);
+            }
+            {
+                // results outlive the process that stored them
+                object::ResultCache cache(config);
+                object::ResultCache::Result found;
+                const bool isFound = cache.find(placedKey, found);
+                const bool isBlockedFound = cache.find(blockedKey, found);
+                object::ToyRobot restored;
+                cache.find(placedKey, found);
+                restored.restore(found.m_finalState);
+                ASSERT_EQUALS_INT(isFound, true, true);
+                ASSERT_EQUALS_INT(isBlockedFound, false, true);
+                ASSERT_EQUALS_INT(int(found.m_commands), 3, true);
+                ASSERT_EQUALS_STRING(restored.getReport(), std::string("0,1,NORTH"), true);
+            }
+            {
+                // files replayed by a build with other command semantics are not served, the replay version
+                // follows the 8 byte magic and the file version
+                const uint32_t olderVersion = object::ToyRobot::REPLAY_VERSION - 1;
+                for(const auto& entry : std::filesystem::directory_iterator(directory))
+                {
+                    std::fstream file(entry.path(), std::ios::binary | std::ios::in | std::ios::out);
+                    file.seekp(12);
+                    file.write(reinterpret_cast<const char*>(&olderVersion), sizeof(olderVersion));
+                }
+                object::ResultCache cache(config);
+                object::ResultCache::Result found;
+                const bool isFound = cache.find(placedKey, found);
+                ASSERT_EQUALS_INT(isFound, false, true);
+            }
+            {
+                // room for two files, storing a third deletes the oldest
+                std::filesystem::remove_all(directory);
+                config.m_maxDiskBytes = 250;
+                object::ResultCache cache(config);
+                cache.store(key, result);
+                cache.store(placedKey, result);
+                cache.store(largerKey, result);
+                const object::ResultCache::Stats stats = cache.getStats();
+                ASSERT_EQUALS_INT(int(stats.m_diskEvictions), 1, true);
+                ASSERT_EQUALS_INT(int(stats.m_diskBytes <= config.m_maxDiskBytes), 1, true);
+            }
+            {
+                // threads storing and finding at once keep the disk byte count equal to the files left
+                std::filesystem::remove_all(directory);
+                config.m_maxDiskBytes = 2000;
+                object::ResultCache cache(config);
+                std::vector<std::thread> threads;
+                for(uint32_t t = 0; t < 4; ++t)
+                    threads.emplace_back([&, t](){
+                        object::ResultCache::Result found;
+                        for(uint32_t i = 0; i < 50; ++i)
+                        {
+                            const object::ResultCache::Key threadKey = object::ResultCache::makeKey(whole, robot.snapshot(), t, i, nullptr);
+                            cache.store(threadKey, result);
+                            cache.find(threadKey, found);
+                        }
+                    });
+                for(std::thread& thread : threads)
+                    thread.join();
+                uint64_t onDisk = 0;
+                for(const auto& entry : std::filesystem::directory_iterator(directory))
+                    onDisk += entry.file_size();
+                const object::ResultCache::Stats stats = cache.getStats();
+                ASSERT_EQUALS_INT(int(stats.m_diskBytes), int(onDisk), true);
+                ASSERT_EQUALS_INT(int(stats.m_diskBytes <= config.m_maxDiskBytes), 1, true);
+                ASSERT_EQUALS_INT(int(stats.m_stores), 200, true);
+            }
+            std::filesystem::remove_all(directory);
+        };
+        CREATE_TEST(test_result_cache)
+
+        /**
+         * TEST: CommandRouter routes addressed commands to robots by id, alone and in batches, like routing them one by one
+        */
+        auto test_command_router = [&](){
+            // the id map against std::unordered_map, through growth and erasing
+            object::RobotIdMap ids;
+            std::unordered_map<uint32_t, uint32_t> reference;
+            std::mt19937 random(48);
+            for(uint32_t i = 0; i < 20000; ++i)
+            {
+                const uint32_t id = random() % 50000;
+                ids.insert(id, i);
+                reference[id] = i;
+            }
+            int mismatches = 0;
+            for(uint32_t id = 0; id < 50000; id += 3)
+            {
+                const bool isErased = ids.erase(id);
+                mismatches += isErased != (reference.erase(id) == 1);
+            }
+            for(uint32_t id = 0; id < 50000; ++id)
+            {
+                auto itr = reference.find(id);
+                mismatches += ids.find(id) != (itr == reference.end() ? object::RobotIdMap::NO_SLOT : itr->second);
+            }
+            ASSERT_EQUALS_INT(mismatches, 0, true);
+            ASSERT_EQUALS_INT(int(ids.size()), int(reference.size()), true);
+
+            // addressed string commands, the first PLACE of an id adds its robot
+            object::Fleet fleet(4, 4);
+            object::CommandRouter router(fleet);
+            const std::vector<std::string_view> inputs = { "R1 PLACE 0,0,NORTH", "R20 PLACE 3,3,SOUTH", "R1 MOVE", "R20 MOVE",
+                "R7 MOVE", "MOVE", "R1 REPORT", "R20 REPORT", "R1 UNDO" };
+            std::string reports;
+            const object::InputHandler::BatchResult result = router.routeBatch(std::span<const std::string_view>(inputs), &reports);
+            ASSERT_EQUALS_STRING(reports, std::string("R1 0,1,NORTH\nR20 3,2,SOUTH\n"), true);
+            ASSERT_EQUALS_INT(int(result.m_accepted), 6, true);
+            ASSERT_EQUALS_INT(int(result.m_rejected), 2, true);
+            ASSERT_EQUALS_INT(int(result.m_ignored), 1, true);
+            ASSERT_EQUALS_INT(int(result.m_reports), 2, true);
+            ASSERT_EQUALS_INT(int(fleet.size()), 2, true);
+
+            // a first PLACE onto an obstacle is rejected without taking a slot or an id
+            object::ObstacleMap obstacles;
+            obstacles.addObstacle(1, 1);
+            fleet.setObstacleMap(&obstacles);
+            ASSERT_EQUALS_INT(int(router.route("R5 PLACE 1,1,NORTH")), 0, true);
+            ASSERT_EQUALS_INT(int(fleet.size()), 2, true);
+            ASSERT_EQUALS_INT(int(router.size()), 2, true);
+            ASSERT_EQUALS_INT(int(router.findSlot(5) == object::RobotIdMap::NO_SLOT), 1, true);
+            ASSERT_EQUALS_INT(int(router.route("R5 PLACE 2,2,NORTH")), 1, true);
+            ASSERT_EQUALS_INT(int(fleet.size()), 3, true);
+            fleet.setObstacleMap(nullptr);
+
+            // a batch of mixed targets matches routing one command at a time
+            object::Fleet batched(63, 63);
+            object::Fleet single(63, 63);
+            object::CommandRouter batchedRouter(batched);
+            object::CommandRouter singleRouter(single);
+            std::vector<object::CommandRouter::AddressedCommand> commands(20000);
+            for(object::CommandRouter::AddressedCommand& command : commands)
+            {
+                command.m_robot = random() % 500 * 7919;
+                command.m_command.action = random() % 8 == 0 ? type::ACTION::PLACE : type::ACTION(random() % 3);
+                command.m_command.x = random() % 64;
+                command.m_command.y = random() % 64;
+                command.m_command.heading = type::HEADING(random() % 4);
+            }
+            batchedRouter.routeBatch(std::span<const object::CommandRouter::AddressedCommand>(commands));
+            for(const object::CommandRouter::AddressedCommand& command : commands)
+                singleRouter.route(command);
+            mismatches = 0;
+            for(uint32_t id = 0; id < 500 * 7919; id += 7919)
+            {
+                const uint32_t slot = batchedRouter.findSlot(id);
+                const uint32_t singleSlot = singleRouter.findSlot(id);
+                mismatches += slot != singleSlot || (slot != object::RobotIdMap::NO_SLOT && batched.getReport(slot) != single.getReport(slot));
+            }
+            ASSERT_EQUALS_INT(mismatches, 0, true);
+            ASSERT_EQUALS_INT(int(batchedRouter.size()), int(batched.size()), true);
+        };
+        CREATE_TEST(test_command_router)
+
+        /**
+         * TEST: every Engine gives the same reports as the reference ToyRobot, apart from obstacles on engines that ignore them
+        */
+        auto test_engines = [&](){
+            const std::vector<std::string> names = object::EngineRegistry::names();
+            ASSERT_EQUALS_INT(int(names.size() >= 3), 1, true);
+            object::ToyRobot unused;
+            object::EngineConfig unknown;
+            unknown.m_engine = "missing";
+            ASSERT_EQUALS_INT(int(object::EngineRegistry::create(unknown, unused) == nullptr), 1, true);
+
+            // every command checked against the reference, only engines that ignore obstacles diverge
+            static const char* const commands[] = { "MOVE", "MOVE", "LEFT", "RIGHT", "REPORT", "UNDO", "PLACE 2,1,EAST",
+                "PLACE 9,1,EAST", "PLACE 1,1", "JUMP", "MOVE 3" };
+            object::ObstacleMap obstacles;
+            obstacles.addObstacle(2, 2);
+            obstacles.addObstacle(3, 1);
+            auto runEngine = [&](const char* _name, const object::ObstacleMap* _obstacles, std::string& _reports)
+            {
+                object::ToyRobot robot;
+                robot.setObstacleMap(_obstacles);
+                object::EngineConfig config;
+                config.m_engine = _name;
+                config.m_shadowSample = 1;
+                config.m_shadowPrintLimit = 0;
+                std::unique_ptr<object::Engine> engine = object::EngineRegistry::create(config, robot);
+                engine->setReportCallback([&](const std::string& _report){ _reports.append(_report).push_back('\n'); });
+                std::mt19937 random(50);
+                for(int i = 0; i < 5000; ++i)
+                    engine->run(i == 0 ? "PLACE 0,0,NORTH" : commands[random() % 11]);
+                return static_cast<object::ShadowEngine&>(*engine).getStats();
+            };
+            std::string referenceReports;
+            std::string parsedReports;
+            std::string staticReports;
+            const object::ShadowEngine::ShadowStats referenceStats = runEngine("reference", &obstacles, referenceReports);
+            const object::ShadowEngine::ShadowStats parsedStats = runEngine("parsed", &obstacles, parsedReports);
+            const object::ShadowEngine::ShadowStats staticStats = runEngine("static", nullptr, staticReports);
+            std::string blockedReports;
+            const object::ShadowEngine::ShadowStats blockedStats = runEngine("static", &obstacles, blockedReports);
+            ASSERT_EQUALS_INT(int(referenceStats.m_divergences), 0, true);
+            ASSERT_EQUALS_INT(int(parsedStats.m_divergences), 0, true);
+            ASSERT_EQUALS_INT(int(staticStats.m_divergences), 0, true);
+            ASSERT_EQUALS_INT(int(blockedStats.m_divergences > 0), 1, true);
+            ASSERT_EQUALS_INT(int(parsedStats.m_sampled + parsedStats.m_skipped), 5000, true);
+            ASSERT_EQUALS_INT(int(parsedStats.m_skipped > 0), 1, true);
+            ASSERT_EQUALS_INT(int(referenceReports.empty()), 0, true);
+            ASSERT_EQUALS_STRING(parsedReports, referenceReports, true);
+        };
+        CREATE_TEST(test_engines)
+
+        /**
+         * TEST: EditableScript matches a full replay after every insert, replace, erase and obstacle change
+        */
+        auto test_editable_script = [&](){
+            object::ObstacleMap obstacles;
+            obstacles.addObstacle(2, 2);
+            object::EditableScript script(&obstacles);
+            std::vector<type::Command> commands;
+            auto describe = [](const object::ToyRobot::Snapshot& _state)
+            {
+                const auto position = _state.m_transform.getPosition();
+                return _state.m_hasBeenPlaced ? std::to_string(position.x) + "," + std::to_string(position.y) + ","
+                    + std::to_string(int(_state.m_transform.getRotation())) : std::string("unplaced");
+            };
+            // the state after the first _count commands, the slow way
+            auto replay = [&](const size_t _count)
+            {
+                object::ToyRobot robot;
+                robot.setObstacleMap(&obstacles);
+                for(size_t i = 0; i < _count; ++i)
+                    robot.execute(commands[i]);
+                return describe(robot.snapshot());
+            };
+            static const char* const inputs[] = { "MOVE", "MOVE", "LEFT", "RIGHT", "REPORT", "PLACE 0,0,NORTH",
+                "PLACE 4,3,WEST", "PLACE 2,2,EAST", "PLACE 1,4,SOUTH" };
+            type::Command undo;
+            object::InputHandler::parseCommand("UNDO", undo);
+            ASSERT_EQUALS_INT(script.insert(0, undo), false, true);
+            ASSERT_EQUALS_STRING(describe(script.finalState()), std::string("unplaced"), true);
+            std::mt19937 random(49);
+            int mismatches = 0;
+            for(int edit = 0; edit < 4000; ++edit)
+            {
+                type::Command command;
+                object::InputHandler::parseCommand(inputs[random() % 9], command);
+                const uint32_t choice = uint32_t(random() % 4);
+                // grow to a few hundred commands so blocks split, then mix in erases
+                if(commands.empty() || choice < 2 || (choice == 2 && commands.size() < 300))
+                {
+                    const size_t index = random() % (commands.size() + 1);
+                    mismatches += !script.insert(index, command);
+                    commands.insert(commands.begin() + ptrdiff_t(index), command);
+                }
+                else if(choice == 2)
+                {
+                    const size_t index = random() % commands.size();
+                    mismatches += !script.erase(index);
+                    commands.erase(commands.begin() + ptrdiff_t(index));
+                }
+                else
+                {
+                    const size_t index = random() % commands.size();
+                    mismatches += !script.replace(index, command);
+                    commands[index] = command;
+                }
+                // blocking a cell changes every transition
+                if(edit == 2000)
+                    obstacles.addObstacle(3, 3);
+                if(edit % 50 != 0)
+                    continue;
+                const size_t prefix = random() % (commands.size() + 1);
+                mismatches += describe(script.finalState()) != replay(commands.size());
+                mismatches += describe(script.stateAt(prefix)) != replay(prefix);
+                mismatches += script.size() != commands.size();
+            }
+            ASSERT_EQUALS_INT(mismatches, 0, true);
+            ASSERT_EQUALS_INT(script.erase(commands.size()), false, true);
+
+            // a start state other than unplaced
+            object::ToyRobot::Snapshot start;
+            start.m_transform.setPosition(type::T_Position<uint8_t>(4, 4));
+            start.m_transform.setRotation(type::HEADING::SOUTH);
+            start.m_hasBeenPlaced = true;
+            std::vector<type::Command> moves(3);
+            object::InputHandler::parseCommand("MOVE", moves[0]);
+            object::InputHandler::parseCommand("RIGHT", moves[1]);
+            object::InputHandler::parseCommand("MOVE", moves[2]);
+            ASSERT_EQUALS_INT(script.assign(moves), true, true);
+            ASSERT_EQUALS_STRING(describe(script.finalState(start)), std::string("4,3,3"), true);
+            ASSERT_EQUALS_STRING(describe(script.stateAt(1, start)), std::string("4,3,2"), true);
+        };
+        CREATE_TEST(test_editable_script)
+
+        /**
+         * TEST: GeofenceMonitor raises ENTER and EXIT events that rebuild exactly the zones each robot is in
+        */
+        auto test_geofence = [&](){
+            object::GeofenceIndex index(TABLE_TOP_X, TABLE_TOP_Y);
+            const uint32_t corner = index.addZone(0, 0, 1, 1);
+            const uint32_t middle = index.addZone(1, 1, 3, 3);
+            ASSERT_EQUALS_INT(int(corner), 0, true);
+            ASSERT_EQUALS_INT(int(index.addZone(0, 0, 5, 0)), int(object::GeofenceIndex::NO_ZONE), true);
+            ASSERT_EQUALS_INT(int(index.addZone(2, 0, 1, 0)), int(object::GeofenceIndex::NO_ZONE), true);
+            // empty, corner, corner and middle, middle
+            ASSERT_EQUALS_INT(int(index.getSetCount()), 4, true);
+            ASSERT_EQUALS_INT(int(index.getSet(1, 1) != index.getSet(0, 1)), 1, true);
+            object::SpscQueue<object::GeofenceEvent> queue(64);
+            auto drain = [&]()
+            {
+                std::string events;
+                object::GeofenceEvent event;
+                while(queue.tryPop(event))
+                    events.append(event.m_type == object::GeofenceEvent::TYPE::ENTER ? "E" : "X")
+                        .append(std::to_string(event.m_robot)).append(":").append(std::to_string(event.m_zone)).append(" ");
+                return events;
+            };
+
+            object::GeofenceMonitor monitor(index, queue, 7);
+            object::ToyRobot robot;
+            robot.setReportCallback([](const std::string&){});
+            robot.addListener(&monitor);
+            robot.proccessInput("PLACE 0,0,NORTH");
+            ASSERT_EQUALS_STRING(drain(), std::string("E7:0 "), true);
+            robot.proccessInput("MOVE");
+            robot.proccessInput("RIGHT");
+            robot.proccessInput("REPORT");
+            ASSERT_EQUALS_STRING(drain(), std::string(""), true);
+            robot.proccessInput("MOVE");
+            ASSERT_EQUALS_STRING(drain(), std::string("E7:1 "), true);
+            robot.proccessInput("MOVE");
+            ASSERT_EQUALS_STRING(drain(), std::string("X7:0 "), true);
+            // a removed zone is left on the next move
+            ASSERT_EQUALS_INT(index.removeZone(middle), true, true);
+            ASSERT_EQUALS_INT(index.removeZone(middle), false, true);
+            robot.proccessInput("MOVE");
+            ASSERT_EQUALS_STRING(drain(), std::string("X7:1 "), true);
+            robot.removeListener(&monitor);
+            // an UNDO back off the table exits every zone instead of looking up a cell
+            object::ToyRobot undone;
+            undone.addListener(&monitor);
+            undone.proccessInput("PLACE 0,0,NORTH");
+            ASSERT_EQUALS_STRING(drain(), std::string("E7:0 "), true);
+            undone.proccessInput("UNDO");
+            ASSERT_EQUALS_STRING(drain(), std::string("X7:0 "), true);
+            undone.proccessInput("REDO");
+            ASSERT_EQUALS_STRING(drain(), std::string("E7:0 "), true);
+            undone.removeListener(&monitor);
+
+            // fleet robots on a random walk, the zones each is in rebuilt from events match the rectangles
+            object::Fleet fleet(19, 19);
+            object::GeofenceIndex fleetIndex(19, 19);
+            object::SpscQueue<object::GeofenceEvent> fleetQueue(1024);
+            object::GeofenceMonitor fleetMonitor(fleetIndex, fleetQueue);
+            std::mt19937 random(50);
+            std::vector<std::array<uint32_t, 4>> zones;
+            for(int i = 0; i < 30; ++i)
+            {
+                const uint32_t x = random() % 20;
+                const uint32_t y = random() % 20;
+                zones.push_back({ x, y, std::min(19u, x + uint32_t(random() % 8)), std::min(19u, y + uint32_t(random() % 8)) });
+                fleetIndex.addZone(zones.back()[0], zones.back()[1], zones.back()[2], zones.back()[3]);
+            }
+            for(int i = 0; i < 50; ++i)
+                fleet.placeHere(fleet.addRobot(), random() % 20, random() % 20, type::HEADING(random() % 4));
+            fleet.setGeofenceMonitor(&fleetMonitor);
+            std::vector<std::vector<bool>> inside(50, std::vector<bool>(zones.size(), false));
+            int mismatches = 0;
+            for(int i = 0; i < 20000; ++i)
+            {
+                const uint32_t slot = uint32_t(random() % 50);
+                switch (random() % 5)
+                {
+                case 0:     fleet.rotateLeft(slot); break;
+                case 1:     fleet.rotateRight(slot); break;
+                case 2:     fleet.placeHere(slot, random() % 20, random() % 20, type::HEADING::NORTH); break;
+                default:    fleet.move(slot); break;
+                }
+                object::GeofenceEvent event;
+                while(fleetQueue.tryPop(event))
+                {
+                    const bool isEnter = event.m_type == object::GeofenceEvent::TYPE::ENTER;
+                    mismatches += inside[event.m_robot][event.m_zone] == isEnter;
+                    inside[event.m_robot][event.m_zone] = isEnter;
+                }
+            }
+            for(uint32_t slot = 0; slot < 50; ++slot)
+            {
+                const auto position = fleet.getPosition(slot);
+                for(size_t zone = 0; zone < zones.size(); ++zone)
+                    mismatches += inside[slot][zone] != (position.x >= zones[zone][0] && position.y >= zones[zone][1]
+                        && position.x <= zones[zone][2] && position.y <= zones[zone][3]);
+            }
+            ASSERT_EQUALS_INT(mismatches, 0, true);
+            ASSERT_EQUALS_INT(int(fleetMonitor.getStats().m_dropped), 0, true);
+            // leaving the table exits every zone
+            fleet.placeHere(0, zones[0][0], zones[0][1], type::HEADING::NORTH);
+            object::GeofenceEvent exit;
+            while(fleetQueue.tryPop(exit));
+            fleet.setState(0, fleet.getTransform(0), false);
+            const bool isRaised = fleetQueue.tryPop(exit);
+            ASSERT_EQUALS_INT(int(isRaised && exit.m_type == object::GeofenceEvent::TYPE::EXIT), 1, true);
+            fleet.setGeofenceMonitor(nullptr);
+
+            // overlapping zones along a strip give thousands of large differences, the remembered ones stay capped
+            object::Fleet strip(127, 0);
+            object::GeofenceIndex stripIndex(127, 0);
+            object::SpscQueue<object::GeofenceEvent> stripQueue(256);
+            object::GeofenceMonitor stripMonitor(stripIndex, stripQueue);
+            for(uint32_t x = 0; x < 128; ++x)
+                stripIndex.addZone(x, 0, std::min(127u, x + 80), 0);
+            const uint32_t walker = strip.addRobot();
+            strip.setGeofenceMonitor(&stripMonitor);
+            std::vector<bool> stripInside(128, false);
+            mismatches = 0;
+            for(int i = 0; i < 20000; ++i)
+            {
+                strip.placeHere(walker, random() % 128, 0, type::HEADING::EAST);
+                object::GeofenceEvent event;
+                while(stripQueue.tryPop(event))
+                {
+                    const bool isEnter = event.m_type == object::GeofenceEvent::TYPE::ENTER;
+                    mismatches += stripInside[event.m_zone] == isEnter;
+                    stripInside[event.m_zone] = isEnter;
+                }
+            }
+            const uint32_t last = strip.getPosition(walker).x;
+            for(uint32_t zone = 0; zone < 128; ++zone)
+                mismatches += stripInside[zone] != (last >= zone && last <= std::min(127u, zone + 80));
+            ASSERT_EQUALS_INT(mismatches, 0, true);
+            ASSERT_EQUALS_INT(int(stripMonitor.getStats().m_dropped), 0, true);
+            ASSERT_EQUALS_INT(int(stripMonitor.getDifferenceCount() <= 4096), 1, true);
+            ASSERT_EQUALS_INT(int(stripMonitor.getStats().m_changes > 4096), 1, true);
+            strip.setGeofenceMonitor(nullptr);
+        };
+        CREATE_TEST(test_geofence)
     };
 };
 
@@ -4,6 +4,11 @@
 
 #include "Objects.h"
 #include "UnitTests.h"
+#include "Benchmarks.h"
+#include "Pipeline.h"
+#include "PerfCheck.h"
+#include "Router.h"
+#include "Engine.h"
 
 /**
  * TODO:
@@ -12,9 +17,37 @@
  * ls:          iress/ToyRobotCodeChallenge/build
  * dataSet:     ./ToyRobotCodeChallenge 1 testData.txt
  * unitTests:   ./ToyRobotCodeChallenge 0
+ * benchmarks:  ./ToyRobotCodeChallenge 2
+ * analytics:   ./ToyRobotCodeChallenge 3 heatmap.csv testData.txt [more data sets..]
+ * pipelined:   ./ToyRobotCodeChallenge 4 [testData.txt], reads user input when no path is given
+ * dataSetDir:  ./ToyRobotCodeChallenge 5 dataSets/<name>.txt [threads] [cacheDir|memory]
+ * perfCheck:   ./ToyRobotCodeChallenge 6 [baseline.json] [medianTolerance] [p99Tolerance], exits 1 on regression
+ * perfRecord:  ./ToyRobotCodeChallenge 6 --record [baseline.json]
  * userInput:   ./ToyRobotCodeChallenge
+ * engines:     --engine=parsed and --shadow=100 anywhere on the command line, for dataSet and userInput
  * */
 
+/**
+ * @brief remove a "--name=value" flag from the arguments
+ * @param _prefix flag up to and including "="
+ * @return value of the last matching flag, nullptr if it is not given
+*/
+static const char* _takeFlag(int& _argc, char* _argv[], const char* _prefix)
+{
+    const char* value = nullptr;
+    const size_t length = strlen(_prefix);
+    int kept = 1;
+    for(int i = 1; i < _argc; ++i)
+    {
+        if(strncmp(_argv[i], _prefix, length) == 0)
+            value = _argv[i] + length;
+        else
+            _argv[kept++] = _argv[i];
+    }
+    _argc = kept;
+    return value;
+}
+
 /**
  * @brief main runtime loop
  * @param argc amount of arguments agaliable
@@ -22,10 +55,23 @@
 */
 int main(int argc, char *argv[]) 
 {
+    // optional tracing, see TOYROBOT_TRACE in the README
+    object::Tracer::startFromEnvironment();
+    // optional allocation counts per action, see TOYROBOT_ALLOCATIONS in the README
+    object::AllocationTracker::enableFromEnvironment();
     // create base object states
     const object::TableTop tableTop(TABLE_TOP_X, TABLE_TOP_Y);
     // get player robot from map
     object::ToyRobot& player = tableTop.getPlayer();
+    // engine running player commands, see Engines in the README
+    object::EngineConfig engineConfig = object::EngineConfig::fromEnvironment();
+    if(const char* engine = _takeFlag(argc, argv, "--engine="))
+        engineConfig.m_engine = engine;
+    if(const char* sample = _takeFlag(argc, argv, "--shadow="))
+        engineConfig.m_shadowSample = uint32_t(strtoul(sample, nullptr, 10));
+    const std::unique_ptr<object::Engine> engine = object::EngineRegistry::create(engineConfig, player);
+    if(!engine)
+        return 1;
     // run tests
     if(argc > 1)
     {
@@ -34,9 +80,69 @@ int main(int argc, char *argv[])
         if(strcmp(argv[1],"1")==0)
         {
             printf("run text test\n");
-            unitTests.runDataSetTests(argv[2]);
+            unitTests.runDataSetTests(argv[2], argc > 3 ? argv[3] : "", engine.get());
+            return 0;
+        }
+        // run benchmarks
+        else if(strcmp(argv[1],"2")==0)
+        {
+            Benchmarks benchmarks;
+            benchmarks.runBenchmarks();
             return 0;
         }
+        // run dataset analytics
+        else if(strcmp(argv[1],"3")==0 && argc > 3)
+        {
+            unitTests.runDataSetAnalytics(std::vector<std::string>(argv + 3, argv + argc), argv[2]);
+            return 0;
+        }
+        // run pipelined input from a data set or user input
+        else if(strcmp(argv[1],"4")==0)
+        {
+            object::PipelineConfig config;
+            object::PipelineStats stats;
+            if(argc > 2)
+            {
+                std::ifstream file(argv[2]);
+                stats = object::Pipeline(config).run(file, player);
+            }
+            else
+            {
+                // read line by line so interactive input is not held back
+                config.m_chunkSize = 0;
+                stats = object::Pipeline(config).run(std::cin, player);
+            }
+            stats.print();
+            return 0;
+        }
+        // run every dataset in a directory or glob
+        else if(strcmp(argv[1],"5")==0 && argc > 2)
+        {
+            // optional result cache, kept in a directory or in memory for this run only
+            std::unique_ptr<object::ResultCache> cache;
+            if(argc > 4)
+            {
+                object::ResultCacheConfig config;
+                if(strcmp(argv[4],"memory")!=0)
+                    config.m_directory = argv[4];
+                cache = std::make_unique<object::ResultCache>(config);
+            }
+            unitTests.runDataSetDirectory(argv[2], argc > 3 ? unsigned(atoi(argv[3])) : 0, cache.get());
+            return 0;
+        }
+        // compare throughput against a stored baseline, or record a new one
+        else if(strcmp(argv[1],"6")==0)
+        {
+            PerfCheck perfCheck;
+            if(argc > 2 && strcmp(argv[2],"--record")==0)
+                return perfCheck.writeBaseline(argc > 3 ? argv[3] : PERF_BASELINE_PATH);
+            PerfTolerance tolerance;
+            if(argc > 3)
+                tolerance.m_median = atof(argv[3]);
+            if(argc > 4)
+                tolerance.m_p99 = atof(argv[4]);
+            return perfCheck.run(argc > 2 ? argv[2] : PERF_BASELINE_PATH, tolerance);
+        }
         // run unit tests
         else
         {
@@ -46,13 +152,18 @@ int main(int argc, char *argv[])
     // run user input
     else
     {
+        // "R<id> command" goes to fleet robots, everything else to the player
+        object::CommandRouter router(tableTop.getFleet());
         while(true)
         {
             // get input from user
             std::string input;
             std::getline( std::cin, input);
             // proccess used input
-            player.proccessInput(input);
+            if(object::CommandRouter::isAddressed(input))
+                router.route(input);
+            else
+                engine->run(input);
         }
     }
     return 0;